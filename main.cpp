@@ -1,4 +1,12 @@
 #include <iostream>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <future>
+#include <iomanip>
+#include <limits>
+#include <sstream>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include <glm/glm.hpp>
@@ -10,12 +18,26 @@
 #include "Transform.h"
 #include "CapacitanceCalculator.h"
 #include "BulkCapacitanceProcessor.h"
+#include "DirectoryWatcher.h"
+#include "LiveCapacitance.h"
+#include "Overlay.h"
+#include "RunFile.h"
+#include "RowPrefetcher.h"
+#include "CapacitancePlot.h"
+#include "OffscreenExport.h"
+#include "FrameTimer.h"
+#include "Tracer.h"
+#include "EmbreeBenchmark.h"
 
 // Window settings
 const unsigned int WINDOW_WIDTH = 1200;
 const unsigned int WINDOW_HEIGHT = 800;
 const char* WINDOW_TITLE = "OBJ Viewer - FT_Sim with Step Mode Debug";
 
+// Redraw scheduling: frames are drawn on demand, at most MAX_FRAME_RATE per second
+const double MAX_FRAME_RATE = 60.0;
+const double IDLE_WAKE_INTERVAL = 0.25;  // s; the model watcher is polled at least this often
+
 // Global objects
 Camera* camera = nullptr;
 ModelManager* modelManager = nullptr;
@@ -23,6 +45,14 @@ Render* renderer = nullptr;
 TransformManager* transformManager = nullptr;
 CapacitanceCalculator* capacitanceCalculator = nullptr;
 BulkCapacitanceProcessor* bulkProcessor = nullptr;
+DirectoryWatcher* modelWatcher = nullptr;
+LiveCapacitance* liveCapacitance = nullptr;
+Overlay* overlay = nullptr;
+Overlay* stepOverlay = nullptr;
+RunFile* runFile = nullptr;
+RowPrefetcher* rowPrefetcher = nullptr;
+bool runResultsStale = false;  // A mesh was reloaded after the open run file's results were computed
+CapacitancePlot* plot = nullptr;
 
 // Input state
 bool wireframeMode = false;
@@ -36,19 +66,141 @@ size_t currentRow = 0;
 size_t maxRows = 0;
 bool stepModeInitialized = false;
 
+// Run file playback (step mode backed by the results of a bulk run)
+const size_t PAGE_ROWS = 100;
+const double MIN_PLAYBACK_SPEED = 1.0;       // rows/s
+const double MAX_PLAYBACK_SPEED = 3840.0;
+bool playing = false;
+double playbackSpeed = 30.0;
+double playbackPosition = 0.0;               // Fractional row while playing
+double lastPlaybackTime = 0.0;
+
+// Capacitance plot panel
+bool plotVisible = false;
+bool plotScrubbing = false;   // Left button went down on the plot; drags pick rows instead of rotating
+
+// Redraw state: set by input, transform changes and new results (may be set from worker threads)
+std::atomic<bool> redrawRequested(true);
+bool animating = false;  // Continuous redraw (frame-capped) while something animates
+uint64_t drawnTransformVersion = 0;
+
+// Live capacitance: transform changes are recomputed in the background and shown in the overlay
+bool liveMode = false;
+uint64_t liveSubmittedVersion = 0;
+uint64_t liveShownGeneration = 0;
+
+// Heatmap: positives coloured per triangle from the live worker's last full result
+enum class HeatmapMode { Off, Contribution, HitDistance };
+HeatmapMode heatmapMode = HeatmapMode::Off;
+std::vector<TriangleFields> heatmapFields;
+std::string heatmapLegend;
+
+// Debug ray capture: the latest calculation's rays (subsampled) are drawn over the scene
+RayCapture* rayCapture = nullptr;
+bool rayCaptureEnabled = false;
+uint64_t rayCaptureGeneration = 0;
+std::vector<CapturedRay> capturedRays;
+
+// Frame timing: CPU stages and GPU passes, shown in the bottom-right corner while enabled
+FrameTimer* frameTimer = nullptr;
+Overlay* timingOverlay = nullptr;
+const double TIMING_OVERLAY_INTERVAL = 0.5;  // s between overlay refreshes
+double lastTimingOverlayUpdate = 0.0;
+
+// Background bulk run: the job owns its processor, transform manager and calculator,
+// so step mode and the rendered transforms are untouched while it runs
+std::future<bool> bulkRun;
+BulkProgress bulkProgress;
+std::chrono::steady_clock::time_point bulkStartTime;
+double lastBulkTitleUpdate = 0.0;
+
+// Startup state: calculator setup finishes on a worker while the viewer is already running
+std::chrono::steady_clock::time_point startupTime;
+std::future<bool> calculatorReady;
+TransformManager* calculatorTransforms = nullptr;  // Snapshot the calculator starts from
+bool calculationQueued = false;                    // C pressed while the calculator was starting
+std::vector<ModelId> queuedMeshUpdates;            // Meshes reloaded while the calculator was starting
+bool firstFrameReported = false;
+bool firstResultReported = false;
+
 // Forward declarations
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
+void window_refresh_callback(GLFWwindow* window);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
+void mouse_button_callback(GLFWwindow* window, int button, int action, int mods);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
 void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods);
 void processInput(GLFWwindow* window);
 bool runBulkCapacitanceProcessing();
+void cancelBulkCapacitanceProcessing();
+void updateBulkProgress(GLFWwindow* window);
 bool initializeStepMode();
 void stepToRow(size_t row);
 void printStepModeInfo();
+void closeRunFile();
+void updateStepOverlay();
+void updatePlayback();
+void togglePlayback();
+void togglePlot();
+void loadPlot();
+void jumpToPlotRow(GLFWwindow* window);
+void getCursorFramebufferPos(GLFWwindow* window, double& x, double& y, int& width, int& height);
+bool ensureCalculatorReady();
+bool isCalculatorStarting();
+void runQueuedCalculatorWork();
+void calculateSingleCapacitance();
+void reportFirstResult();
+double getSecondsSinceStartup();
+void reloadChangedModels();
+void requestRedraw();
+void toggleLiveMode();
+void updateLiveCapacitance(uint64_t transformVersion);
+void cycleHeatmapMode();
+void updateHeatmap();
+void toggleRayCapture();
+void updateRayCapture();
+void toggleFrameTiming();
+void updateTimingOverlay();
+void exportFrameTiming();
 
-int main()
+int main(int argc, char** argv)
 {
+    // Opt-in timeline trace (--trace <file> or FT_SIM_TRACE)
+    if (Tracer::startFromCommandLine(argc, argv)) {
+        Tracer::setThreadName("main");
+    }
+
+    // Embree device and BVH build policy of every capacitance calculator (--embree-* options)
+    EmbreeConfig embreeConfig;
+    if (!parseEmbreeArguments(argc, argv, embreeConfig)) {
+        std::cerr << "Usage: FT_Sim [--embree-threads N] [--embree-affinity] [--embree-isa NAME] "
+                  << "[--embree-scene-flags FLAGS] [--embree-quality STATIC[:DYNAMIC]] [--embree-budget-mb N]" << std::endl;
+        std::cerr << "The memory budget applies to each calculator's device (viewer, live readout, row prefetch "
+                  << "and bulk run), so the process can use up to four times the budget" << std::endl;
+        return -1;
+    }
+    CapacitanceCalculator::setDefaultEmbreeConfig(embreeConfig);
+
+    // Compare build policies on the current models and exit: FT_Sim --embree-benchmark [rows]
+    size_t benchmarkRows = 0;
+    if (parseBenchmarkArguments(argc, argv, benchmarkRows)) {
+        return runEmbreeBenchmark(embreeConfig, benchmarkRows);
+    }
+
+    // Headless batch export (no window): FT_Sim --export <dir> [options]
+    ExportOptions exportOptions;
+    if (parseExportArguments(argc, argv, exportOptions)) {
+        return runOffscreenExport(exportOptions);
+    }
+
+    startupTime = std::chrono::steady_clock::now();
+    
+    // Start loading meshes right away; window, context and shader setup overlap with it
+    modelManager = new ModelManager();
+    std::future<bool> modelsLoaded = std::async(std::launch::async, []() {
+        return modelManager->loadAllModels("models/");
+    });
+
     // Initialize GLFW
     if (!glfwInit()) {
         std::cerr << "Failed to initialize GLFW" << std::endl;
@@ -72,7 +224,9 @@ int main()
 
     // Set callbacks
     glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+    glfwSetWindowRefreshCallback(window, window_refresh_callback);
     glfwSetCursorPosCallback(window, mouse_callback);
+    glfwSetMouseButtonCallback(window, mouse_button_callback);
     glfwSetScrollCallback(window, scroll_callback);
     glfwSetKeyCallback(window, key_callback);
 
@@ -96,13 +250,36 @@ int main()
     try {
         camera = new Camera(glm::vec3(10.0f, 10.0f, 10.0f)); // Isometric starting position
         renderer = new Render();
-        modelManager = new ModelManager();
         transformManager = new TransformManager();
         capacitanceCalculator = new CapacitanceCalculator();
         bulkProcessor = new BulkCapacitanceProcessor();
+        liveCapacitance = new LiveCapacitance();
+        overlay = new Overlay();
+        stepOverlay = new Overlay(OverlayAnchor::TopRight);
+        runFile = new RunFile();
+        rowPrefetcher = new RowPrefetcher();
+        plot = new CapacitancePlot();
+        frameTimer = new FrameTimer();
+        timingOverlay = new Overlay(OverlayAnchor::BottomRight);
 
-        // Load all OBJ models
-        if (!modelManager->loadAllModels("models/")) {
+        // Shaders and axes do not depend on the models
+        if (!renderer->initialize((GLProcLoader)glfwGetProcAddress)) {
+            std::cerr << "Failed to initialize renderer" << std::endl;
+            return -1;
+        }
+        if (!overlay->initialize() || !stepOverlay->initialize()) {
+            std::cerr << "Failed to initialize overlay; live readout is console-only" << std::endl;
+        }
+        if (!plot->initialize()) {
+            std::cerr << "Failed to initialize capacitance plot" << std::endl;
+        }
+        if (!frameTimer->initialize() || !timingOverlay->initialize()) {
+            std::cerr << "GPU timer queries unavailable; frame timing is CPU-only" << std::endl;
+        }
+        renderer->setFrameTimer(frameTimer);
+
+        // Wait for the mesh loads started above
+        if (!modelsLoaded.get()) {
             std::cerr << "Failed to load models" << std::endl;
             return -1;
         }
@@ -110,17 +287,27 @@ int main()
         // Assign models to transformation groups
         modelManager->assignModelGroups(*transformManager);
 
-        // Initialize renderer with loaded models
-        if (!renderer->initialize(modelManager->getModels())) {
-            std::cerr << "Failed to initialize renderer" << std::endl;
-            return -1;
-        }
+        // Initialize the capacitance calculator and build its BVHs on a worker. It starts from
+        // snapshots of the models and transforms, so reloads and edits here do not race with it,
+        // and is switched to the live transforms when its result is collected.
+        std::vector<Model> calculatorModels = modelManager->getModels();
+        calculatorTransforms = new TransformManager(*transformManager);
+        calculatorReady = std::async(std::launch::async, [calculatorModels]() {
+            Tracer::setThreadName("calculator startup");
+            bool ready = capacitanceCalculator->initialize(calculatorModels, *calculatorTransforms) &&
+                         capacitanceCalculator->ensureScenes();
+            
+            // Wake the main loop to run the work queued meanwhile
+            glfwPostEmptyEvent();
+            return ready;
+        });
 
-        // Initialize capacitance calculator
-        if (!capacitanceCalculator->initialize(modelManager->getModels(), *transformManager)) {
-            std::cerr << "Failed to initialize capacitance calculator" << std::endl;
-            return -1;
-        }
+        // Upload meshes; the viewer is interactive from here on
+        renderer->uploadModels(modelManager->getModels());
+
+        // Reload models when their files change on disk
+        modelWatcher = new DirectoryWatcher();
+        modelWatcher->start("models/");
 
         // Print transformation info
         transformManager->printGroupTransforms();
@@ -131,10 +318,18 @@ int main()
         std::cout << "- Mouse wheel: Zoom in/out" << std::endl;
         std::cout << "- SPACE: Toggle wireframe/solid mode" << std::endl;
         std::cout << "- C: Calculate single capacitance" << std::endl;
+        std::cout << "- L: Toggle live capacitance readout" << std::endl;
+        std::cout << "- R: Toggle ray capture (draws the rays of the next calculations)" << std::endl;
+        std::cout << "- H: Cycle heatmap (per-triangle contribution, hit distance, off; uses the live readout)" << std::endl;
         std::cout << "- S: Initialize step mode" << std::endl;
         std::cout << "- N: Next row (step mode)" << std::endl;
         std::cout << "- P: Previous row (step mode)" << std::endl;
-        std::cout << "- B: Run bulk capacitance processing from CSV files" << std::endl;
+        std::cout << "- PAGE UP/DOWN, HOME/END: Jump rows (step mode)" << std::endl;
+        std::cout << "- G: Play/pause, [ ]: Playback speed (step mode with a bulk run file)" << std::endl;
+        std::cout << "- T: Toggle capacitance plot (click/drag: jump to row, wheel: zoom, right drag: pan)" << std::endl;
+        std::cout << "- F: Toggle frame timing overlay, E: Export frame timing to frame_timing.csv" << std::endl;
+        std::cout << "- B: Run bulk capacitance processing from CSV files (in the background)" << std::endl;
+        std::cout << "- X: Cancel bulk processing (completed rows are saved)" << std::endl;
         std::cout << "- ESC: Exit" << std::endl;
 
     } catch (const std::exception& e) {
@@ -142,39 +337,472 @@ int main()
         return -1;
     }
 
-    // Render loop
+    // Render loop (redraws on demand; idles in glfwWaitEventsTimeout otherwise)
+    const double minFrameInterval = 1.0 / MAX_FRAME_RATE;
+    double lastFrameTime = -minFrameInterval;
+
     while (!glfwWindowShouldClose(window)) {
         // Process input
+        frameTimer->beginCpu(CpuStage::Input);
         processInput(window);
+        reloadChangedModels();
+        runQueuedCalculatorWork();
+        updateBulkProgress(window);
+        updatePlayback();
+
+        // Transform edits (step mode, calculated transforms) need a new frame too
+        uint64_t transformVersion = transformManager->getTransformVersion();
+        if (transformVersion != drawnTransformVersion) {
+            redrawRequested = true;
+        }
+        updateLiveCapacitance(transformVersion);
+        updateRayCapture();
+        frameTimer->endCpu(CpuStage::Input);
+        updateTimingOverlay();
 
-        // Clear screen
-        glClearColor(0.2f, 0.2f, 0.2f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        if ((redrawRequested || animating) && glfwGetTime() - lastFrameTime >= minFrameInterval) {
+            redrawRequested = false;
+            drawnTransformVersion = transformVersion;
+            lastFrameTime = glfwGetTime();
 
-        // Get matrices
-        glm::mat4 view = camera->getViewMatrix();
-        glm::mat4 projection = camera->getProjectionMatrix(WINDOW_WIDTH, WINDOW_HEIGHT);
+            frameTimer->beginFrame();
 
-        // Render all models with group transformations
-        renderer->render(view, projection, *transformManager, wireframeMode);
+            // Clear screen
+            glClearColor(0.2f, 0.2f, 0.2f, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        // Swap buffers and poll events
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+            // Get matrices
+            glm::mat4 view = camera->getViewMatrix();
+            glm::mat4 projection = camera->getProjectionMatrix(WINDOW_WIDTH, WINDOW_HEIGHT);
+
+            // Render all models with group transformations
+            renderer->render(view, projection, *transformManager, wireframeMode);
+
+            int framebufferWidth, framebufferHeight;
+            glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+            overlay->render(framebufferWidth, framebufferHeight);
+            stepOverlay->render(framebufferWidth, framebufferHeight);
+            if (plotVisible) {
+                plot->render(framebufferWidth, framebufferHeight);
+            }
+            if (frameTimer->isEnabled()) {
+                timingOverlay->render(framebufferWidth, framebufferHeight);
+            }
+            frameTimer->endFrame();
+
+            // Swap buffers
+            glfwSwapBuffers(window);
+
+            if (!firstFrameReported) {
+                std::cout << "Time to first frame: " << getSecondsSinceStartup() << " s" << std::endl;
+                firstFrameReported = true;
+            }
+        }
+
+        // Sleep until an event arrives, the next capped frame is due or the watcher needs polling
+        double timeout = IDLE_WAKE_INTERVAL;
+        if (redrawRequested || animating) {
+            timeout = std::min(timeout, lastFrameTime + minFrameInterval - glfwGetTime());
+        }
+        if (timeout > 0.0) {
+            glfwWaitEventsTimeout(timeout);
+        } else {
+            glfwPollEvents();
+        }
     }
 
-    // Cleanup
+    // Cleanup (the calculator may still be initializing on its worker; a bulk run saves what it has)
+    if (calculatorReady.valid()) {
+        calculatorReady.wait();
+    }
+    if (bulkRun.valid()) {
+        cancelBulkCapacitanceProcessing();
+        bulkRun.wait();
+    }
+    closeRunFile();
     delete camera;
     delete modelManager;
     delete renderer;
     delete transformManager;
     delete capacitanceCalculator;
+    delete calculatorTransforms;
     delete bulkProcessor;
+    delete modelWatcher;
+    delete liveCapacitance;
+    delete rayCapture;
+    delete overlay;
+    delete stepOverlay;
+    delete rowPrefetcher;
+    delete runFile;
+    delete plot;
+    delete timingOverlay;
+    delete frameTimer;
 
     glfwTerminate();
     return 0;
 }
 
+bool isCalculatorStarting()
+{
+    return calculatorReady.valid();
+}
+
+void runQueuedCalculatorWork()
+{
+    if (!calculationQueued && queuedMeshUpdates.empty()) {
+        return;
+    }
+    if (!ensureCalculatorReady()) {
+        // Still starting: keep the work; failed: there is nothing to run it on
+        if (!isCalculatorStarting()) {
+            calculationQueued = false;
+            queuedMeshUpdates.clear();
+        }
+        return;
+    }
+    
+    // The calculator started from the models as they were before these reloads
+    if (!queuedMeshUpdates.empty()) {
+        capacitanceCalculator->updateModelMeshes(modelManager->getModels(), queuedMeshUpdates);
+        queuedMeshUpdates.clear();
+    }
+    if (calculationQueued) {
+        calculationQueued = false;
+        calculateSingleCapacitance();
+    }
+}
+
+void calculateSingleCapacitance()
+{
+    if (!capacitanceCalculator) {
+        return;
+    }
+    if (!ensureCalculatorReady()) {
+        if (isCalculatorStarting() && !calculationQueued) {
+            calculationQueued = true;
+            std::cout << "Capacitance calculator is still building its scenes; calculating when it is ready" << std::endl;
+        }
+        return;
+    }
+    
+    std::cout << "\nCalculating single capacitance..." << std::endl;
+    std::vector<CapacitanceResult> results = capacitanceCalculator->calculateCapacitances();
+    capacitanceCalculator->printResults(results);
+    reportFirstResult();
+}
+
+void reportFirstResult()
+{
+    if (!firstResultReported) {
+        std::cout << "Time to first result: " << getSecondsSinceStartup() << " s" << std::endl;
+        firstResultReported = true;
+    }
+}
+
+double getSecondsSinceStartup()
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - startupTime).count();
+}
+
+bool ensureCalculatorReady()
+{
+    // Collect the background initialization result once the worker has finished (never blocks
+    // the UI; callers queue their work while isCalculatorStarting)
+    static bool ready = false;
+    if (calculatorReady.valid()) {
+        if (calculatorReady.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            return false;
+        }
+        ready = calculatorReady.get();
+        if (ready) {
+            capacitanceCalculator->setTransformManager(*transformManager);
+        } else {
+            std::cerr << "Capacitance calculator failed to initialize" << std::endl;
+        }
+        delete calculatorTransforms;
+        calculatorTransforms = nullptr;
+    }
+    return ready;
+}
+
+void requestRedraw()
+{
+    // Safe from any thread; the empty event wakes the main loop out of its wait
+    redrawRequested = true;
+    glfwPostEmptyEvent();
+}
+
+void toggleLiveMode()
+{
+    liveMode = !liveMode;
+    std::cout << "Live capacitance: " << (liveMode ? "ON" : "OFF") << std::endl;
+    
+    if (!liveMode) {
+        liveCapacitance->stop();
+        overlay->clear();
+        if (heatmapMode != HeatmapMode::Off) {
+            cycleHeatmapMode();
+        }
+        return;
+    }
+    
+    // The worker computes the current state first, then every submitted change
+    liveCapacitance->start(modelManager->getModels(), *transformManager, requestRedraw);
+    liveSubmittedVersion = transformManager->getTransformVersion();
+    liveShownGeneration = 0;
+    overlay->setLines({"LIVE CAPACITANCE", "COMPUTING..."});
+}
+
+void updateLiveCapacitance(uint64_t transformVersion)
+{
+    if (!liveMode) {
+        return;
+    }
+    
+    // Hand changed transforms to the worker (it only ever computes the latest state)
+    if (transformVersion != liveSubmittedVersion) {
+        liveCapacitance->submit(*transformManager);
+        liveSubmittedVersion = transformVersion;
+    }
+    
+    LiveCapacitanceResult live;
+    if (!liveCapacitance->getLatest(live, liveShownGeneration)) {
+        return;
+    }
+    liveShownGeneration = live.generation;
+    
+    if (live.failed) {
+        overlay->setLines({"LIVE CAPACITANCE", "UNAVAILABLE"});
+        return;
+    }
+    reportFirstResult();
+    
+    if (!live.coarse && heatmapMode != HeatmapMode::Off) {
+        heatmapFields.swap(live.triangleFields);
+        updateHeatmap();
+    }
+    
+    std::vector<std::string> lines;
+    lines.push_back(live.coarse ? "LIVE CAPACITANCE ~ESTIMATE" : "LIVE CAPACITANCE");
+    
+    double totalPF = 0.0;
+    for (const CapacitanceResult& result : live.results) {
+        double capacitancePF = result.capacitance * 1e12;
+        totalPF += capacitancePF;
+        
+        std::string name = result.modelName.substr(0, result.modelName.find('_'));
+        std::ostringstream line;
+        line << std::left << std::setw(6) << (name + ":") << std::right << std::fixed << std::setprecision(5) 
+             << std::setw(10) << capacitancePF << " PF";
+        lines.push_back(line.str());
+    }
+    
+    std::ostringstream total;
+    total << std::left << std::setw(6) << "TOTAL:" << std::right << std::fixed << std::setprecision(5) 
+          << std::setw(10) << totalPF << " PF";
+    lines.push_back(total.str());
+    
+    std::ostringstream timing;
+    timing << std::fixed << std::setprecision(1) << live.computeMs << " MS";
+    if (live.transformVersion != transformVersion) {
+        timing << "  UPDATING";
+    }
+    lines.push_back(timing.str());
+    if (!heatmapLegend.empty()) {
+        lines.push_back(heatmapLegend);
+    }
+    
+    overlay->setLines(lines);
+    redrawRequested = true;
+}
+
+void cycleHeatmapMode()
+{
+    switch (heatmapMode) {
+        case HeatmapMode::Off: heatmapMode = HeatmapMode::Contribution; break;
+        case HeatmapMode::Contribution: heatmapMode = HeatmapMode::HitDistance; break;
+        case HeatmapMode::HitDistance: heatmapMode = HeatmapMode::Off; break;
+    }
+    
+    if (heatmapMode == HeatmapMode::Off) {
+        std::cout << "Heatmap: OFF" << std::endl;
+        renderer->setHeatmap(false);
+        renderer->clearTriangleScalars();
+        heatmapFields.clear();
+        heatmapLegend.clear();
+        return;
+    }
+    
+    std::cout << "Heatmap: " << (heatmapMode == HeatmapMode::Contribution ? "triangle contribution" : "hit distance") << std::endl;
+    
+    // The per-triangle values come from the live worker's full passes
+    if (!liveMode) {
+        toggleLiveMode();
+    }
+    updateHeatmap();
+    
+    // Fetch the latest result again so the readout shows the new legend
+    liveShownGeneration = 0;
+}
+
+void updateHeatmap()
+{
+    if (heatmapFields.empty()) {
+        return;
+    }
+    
+    // One buffer upload per positive model; the range covers every triangle with a hit
+    bool contribution = heatmapMode == HeatmapMode::Contribution;
+    float low = std::numeric_limits<float>::max();
+    float high = 0.0f;
+    for (const TriangleFields& fields : heatmapFields) {
+        const std::vector<float>& values = contribution ? fields.contributions : fields.hitDistances;
+        if (fields.modelId == INVALID_MODEL_ID) {
+            continue;
+        }
+        renderer->setTriangleScalars(fields.modelId, values);
+        
+        for (float value : values) {
+            if (value >= 0.0f) {
+                low = std::min(low, value);
+                high = std::max(high, value);
+            }
+        }
+    }
+    if (low > high) {
+        low = 0.0f;
+        high = 1.0f;
+    }
+    
+    // Equal values would make the shader divide by a zero range: widen it (relative for large values)
+    constexpr float MIN_HEATMAP_RANGE = 1e-6f;
+    float minRange = std::max(MIN_HEATMAP_RANGE, std::abs(low) * MIN_HEATMAP_RANGE);
+    if (high - low < minRange) {
+        high = low + minRange;
+    }
+    
+    // Near hits are the hot end of the distance map
+    if (contribution) {
+        renderer->setHeatmap(true, low, high);
+    } else {
+        renderer->setHeatmap(true, high, low);
+    }
+    
+    std::ostringstream legend;
+    legend << std::fixed << std::setprecision(3) << (contribution ? "HEAT: " : "HEAT DIST: ") << low << "-" << high 
+           << (contribution ? " FF" : " MM");
+    heatmapLegend = legend.str();
+    requestRedraw();
+}
+
+void toggleRayCapture()
+{
+    rayCaptureEnabled = !rayCaptureEnabled;
+    
+    // Allocated on first use and kept, since a pass on a worker may still be writing to it
+    if (rayCaptureEnabled && !rayCapture) {
+        rayCapture = new RayCapture();
+    }
+    RayCapture* capture = rayCaptureEnabled ? rayCapture : nullptr;
+    capacitanceCalculator->setRayCapture(capture);
+    liveCapacitance->setRayCapture(capture);
+    
+    if (rayCaptureEnabled) {
+        std::cout << "Ray capture: ON (up to " << rayCapture->getBudget() 
+                  << " rays of the next calculation; press C or L)" << std::endl;
+    } else {
+        std::cout << "Ray capture: OFF" << std::endl;
+        renderer->setRayLines({});
+    }
+}
+
+void updateRayCapture()
+{
+    if (!rayCaptureEnabled || !rayCapture->getLatest(capturedRays, rayCaptureGeneration)) {
+        return;
+    }
+    
+    renderer->setRayLines(capturedRays);
+    requestRedraw();
+}
+
+void toggleFrameTiming()
+{
+    frameTimer->setEnabled(!frameTimer->isEnabled());
+    lastTimingOverlayUpdate = 0.0;
+    
+    if (frameTimer->isEnabled()) {
+        std::cout << "Frame timing: ON (rolling window; E exports)" << std::endl;
+        timingOverlay->setLines(frameTimer->formatLines());
+    } else {
+        std::cout << "Frame timing: OFF" << std::endl;
+        timingOverlay->clear();
+    }
+    requestRedraw();
+}
+
+void updateTimingOverlay()
+{
+    if (!frameTimer->isEnabled() || glfwGetTime() - lastTimingOverlayUpdate < TIMING_OVERLAY_INTERVAL) {
+        return;
+    }
+    lastTimingOverlayUpdate = glfwGetTime();
+    
+    // The refresh itself draws a frame, so idle scenes keep sampling at the refresh rate
+    timingOverlay->setLines(frameTimer->formatLines());
+    requestRedraw();
+}
+
+void exportFrameTiming()
+{
+    if (!frameTimer->isEnabled()) {
+        std::cout << "Frame timing is off; press F to start sampling" << std::endl;
+        return;
+    }
+    frameTimer->exportToFile("frame_timing.csv");
+}
+
+void reloadChangedModels()
+{
+    static std::vector<std::string> changedFiles;
+    changedFiles.clear();
+    
+    if (!modelWatcher || !modelWatcher->poll(changedFiles)) {
+        return;
+    }
+    
+    for (const std::string& filePath : changedFiles) {
+        // Only the changed mesh is reloaded, re-uploaded and rebuilt
+        std::vector<ModelId> changedModels;
+        if (!modelManager->reloadMeshFile(filePath, changedModels)) {
+            continue;
+        }
+        
+        renderer->updateModelMeshes(modelManager->getModels(), changedModels);
+        requestRedraw();
+        
+        if (liveCapacitance->isRunning()) {
+            liveCapacitance->updateModelMeshes(modelManager->getModels(), changedModels);
+        }
+        
+        // Prefetched rows used the old mesh: restart the worker on the new models (clears its cache)
+        if (runFile->isOpen()) {
+            runResultsStale = true;
+            rowPrefetcher->stop();
+            rowPrefetcher->start(modelManager->getModels(), runFile, requestRedraw);
+            rowPrefetcher->request(currentRow);
+            updateStepOverlay();
+        }
+        
+        if (ensureCalculatorReady()) {
+            capacitanceCalculator->updateModelMeshes(modelManager->getModels(), changedModels);
+            std::cout << "Capacitance results computed before this reload are stale" << std::endl;
+        } else if (isCalculatorStarting()) {
+            queuedMeshUpdates.insert(queuedMeshUpdates.end(), changedModels.begin(), changedModels.end());
+        }
+    }
+}
+
 bool initializeStepMode()
 {
     std::cout << "\n" << std::string(60, '=') << std::endl;
@@ -183,12 +811,28 @@ bool initializeStepMode()
     
     std::string csvDirectory = "csv_data";
     
-    if (!bulkProcessor->initializeStepMode(csvDirectory)) {
-        std::cerr << "Failed to initialize step mode" << std::endl;
+    // Prefer the poses and results of a previous bulk run; the CSV files are the fallback
+    closeRunFile();
+    if (runFile->open(RunFile::getRunPath(csvDirectory))) {
+        maxRows = runFile->getRowCount();
+        std::cout << "Using bulk run file: " << runFile->getComputedRowCount() << "/" << maxRows 
+                  << " rows computed; the rest are computed around the current row" << std::endl;
+        rowPrefetcher->start(modelManager->getModels(), runFile, requestRedraw);
+    } else {
+        if (!bulkProcessor->initializeStepMode(csvDirectory)) {
+            std::cerr << "Failed to initialize step mode" << std::endl;
+            return false;
+        }
+        maxRows = bulkProcessor->getMaxRows();
+        std::cout << "No bulk run file; rows are recalculated from the CSV files (press B to create one)" << std::endl;
+    }
+    
+    if (maxRows == 0) {
+        std::cerr << "No rows to step through" << std::endl;
+        closeRunFile();
         return false;
     }
     
-    maxRows = bulkProcessor->getMaxRows();
     currentRow = 0;
     stepModeInitialized = true;
     stepMode = true;
@@ -216,6 +860,15 @@ void stepToRow(size_t row)
     
     currentRow = row;
     
+    // With a run file the pose is read straight from the mapping (O(1) per row)
+    plot->setCursorRow(currentRow);
+    if (runFile->isOpen()) {
+        BulkCapacitanceProcessor::applyRunRecord(runFile->getRecord(currentRow), *transformManager);
+        rowPrefetcher->request(currentRow);
+        updateStepOverlay();
+        return;
+    }
+    
     std::cout << "\n" << std::string(40, '-') << std::endl;
     std::cout << "STEPPING TO ROW " << currentRow << "/" << (maxRows - 1) << std::endl;
     std::cout << std::string(40, '-') << std::endl;
@@ -230,6 +883,172 @@ void stepToRow(size_t row)
     std::cout << "Row " << currentRow << " applied successfully" << std::endl;
 }
 
+void closeRunFile()
+{
+    // The prefetcher reads the mapping, so it stops first
+    rowPrefetcher->stop();
+    runFile->close();
+    runResultsStale = false;
+    stepOverlay->clear();
+    playing = false;
+    animating = false;
+}
+
+void updateStepOverlay()
+{
+    RunRecord record = runFile->getRecord(currentRow);
+    bool computed = (record.flags & RUN_ROW_COMPUTED) != 0;
+    bool stale = computed && runResultsStale;
+    if (!computed) {
+        computed = rowPrefetcher->getCapacitances(currentRow, record.capacitances);
+    }
+    const char* missing = rowPrefetcher->isRunning() ? "PENDING" : "UNAVAILABLE";
+    
+    std::vector<std::string> lines;
+    std::ostringstream header;
+    header << "ROW " << currentRow << "/" << (maxRows - 1);
+    lines.push_back(header.str());
+    
+    std::ostringstream playback;
+    playback << (playing ? "PLAYING " : "PAUSED ") << std::fixed << std::setprecision(0) << playbackSpeed << " ROWS/S";
+    lines.push_back(playback.str());
+    
+    static const char* COLUMN_NAMES[RUN_CAPACITANCE_COLUMNS] = {"A1", "A2", "B1", "B2", "C1", "C2"};
+    double totalPF = 0.0;
+    for (size_t i = 0; i < RUN_CAPACITANCE_COLUMNS; i++) {
+        std::ostringstream line;
+        line << std::left << std::setw(6) << (std::string(COLUMN_NAMES[i]) + ":") << std::right;
+        if (computed) {
+            double capacitancePF = record.capacitances[i] * 1e12;
+            totalPF += capacitancePF;
+            line << std::fixed << std::setprecision(5) << std::setw(10) << capacitancePF << " PF";
+        } else {
+            line << std::setw(10) << missing;
+        }
+        lines.push_back(line.str());
+    }
+    
+    std::ostringstream total;
+    total << std::left << std::setw(6) << "TOTAL:" << std::right;
+    if (computed) {
+        total << std::fixed << std::setprecision(5) << std::setw(10) << totalPF << " PF";
+    } else {
+        total << std::setw(10) << missing;
+    }
+    lines.push_back(total.str());
+    if (stale) {
+        lines.push_back("STALE: MESH RELOADED");
+    }
+    
+    stepOverlay->setLines(lines);
+}
+
+void updatePlayback()
+{
+    if (!stepModeInitialized || !runFile->isOpen()) {
+        return;
+    }
+    
+    // Prefetched rows arrive from the worker; the pending row is refreshed when they do
+    if (!playing) {
+        if (redrawRequested) {
+            updateStepOverlay();
+        }
+        return;
+    }
+    
+    double now = glfwGetTime();
+    playbackPosition += (now - lastPlaybackTime) * playbackSpeed;
+    lastPlaybackTime = now;
+    
+    size_t row = static_cast<size_t>(playbackPosition);
+    if (row >= maxRows - 1) {
+        row = maxRows - 1;
+        playing = false;
+        animating = false;
+        std::cout << "Playback reached the last row" << std::endl;
+    }
+    if (row != currentRow || !playing) {
+        stepToRow(row);
+    }
+}
+
+void togglePlayback()
+{
+    if (!stepModeInitialized || !runFile->isOpen()) {
+        std::cout << "Playback needs step mode with a bulk run file (press B, then S)" << std::endl;
+        return;
+    }
+    
+    playing = !playing;
+    if (playing && currentRow >= maxRows - 1) {
+        stepToRow(0);
+    }
+    playbackPosition = static_cast<double>(currentRow);
+    lastPlaybackTime = glfwGetTime();
+    animating = playing;
+    updateStepOverlay();
+}
+
+void togglePlot()
+{
+    plotVisible = !plotVisible;
+    std::cout << "Capacitance plot: " << (plotVisible ? "ON" : "OFF") << std::endl;
+    if (plotVisible) {
+        loadPlot();
+    }
+}
+
+void loadPlot()
+{
+    // The step mode mapping is reused when open; otherwise the run file is mapped just for loading
+    bool loaded = false;
+    if (runFile->isOpen()) {
+        loaded = plot->load(*runFile);
+    } else {
+        RunFile file;
+        loaded = file.open(RunFile::getRunPath("csv_data")) && plot->load(file);
+    }
+    
+    if (!loaded) {
+        std::cout << "No bulk run results to plot (press B to run one)" << std::endl;
+        plotVisible = false;
+        return;
+    }
+    std::cout << "Channels: A1 red, A2 orange, B1 green, B2 cyan, C1 blue, C2 violet, total white" << std::endl;
+}
+
+void jumpToPlotRow(GLFWwindow* window)
+{
+    double x, y;
+    int width, height;
+    getCursorFramebufferPos(window, x, y, width, height);
+    size_t row = plot->getRowAt(x, width);
+    
+    if (!stepModeInitialized && !initializeStepMode()) {
+        return;
+    }
+    if (playing) {
+        togglePlayback();
+    }
+    if (row < maxRows && row != currentRow) {
+        stepToRow(row);
+    }
+}
+
+void getCursorFramebufferPos(GLFWwindow* window, double& x, double& y, int& width, int& height)
+{
+    // Cursor positions are in screen coordinates, which differ from pixels on high-DPI displays
+    int windowWidth, windowHeight;
+    glfwGetCursorPos(window, &x, &y);
+    glfwGetWindowSize(window, &windowWidth, &windowHeight);
+    glfwGetFramebufferSize(window, &width, &height);
+    if (windowWidth > 0 && windowHeight > 0) {
+        x *= static_cast<double>(width) / windowWidth;
+        y *= static_cast<double>(height) / windowHeight;
+    }
+}
+
 void printStepModeInfo()
 {
     if (!stepMode) {
@@ -246,27 +1065,133 @@ void printStepModeInfo()
 
 bool runBulkCapacitanceProcessing()
 {
+    if (bulkRun.valid()) {
+        std::cout << "Bulk processing is already running (press X to cancel)" << std::endl;
+        return false;
+    }
+    
     std::cout << "\n" << std::string(60, '=') << std::endl;
     std::cout << "STARTING BULK CAPACITANCE PROCESSING" << std::endl;
     std::cout << std::string(60, '=') << std::endl;
     
     std::string csvDirectory = "csv_data";
     
-    if (!bulkProcessor->processCSVFiles(csvDirectory, *capacitanceCalculator, *transformManager)) {
-        std::cerr << "Bulk processing failed" << std::endl;
-        return false;
+    // The run rewrites the run file; step mode falls back to the CSV data until it is reopened
+    if (runFile->isOpen()) {
+        closeRunFile();
+        stepMode = false;
+        stepModeInitialized = false;
+        std::cout << "Step mode closed for the bulk run (press S to reopen)" << std::endl;
     }
     
-    std::cout << "\n" << std::string(60, '=') << std::endl;
-    std::cout << "BULK CAPACITANCE PROCESSING COMPLETED" << std::endl;
-    std::cout << std::string(60, '=') << std::endl;
+    // Snapshot the models; live reloads during the run do not affect it
+    std::vector<Model> models = modelManager->getModels();
+    
+    bulkProgress.reset();
+    bulkStartTime = std::chrono::steady_clock::now();
+    lastBulkTitleUpdate = 0.0;
+    
+    bulkRun = std::async(std::launch::async, [models, csvDirectory]() {
+        Tracer::setThreadName("bulk run");
+        TransformManager jobTransforms;
+        for (const Model& model : models) {
+            jobTransforms.registerModel(model.id, model.name);
+        }
+        
+        CapacitanceCalculator jobCalculator;
+        BulkCapacitanceProcessor jobProcessor;
+        bool success = jobCalculator.initialize(models, jobTransforms) &&
+                       jobProcessor.processCSVFiles(csvDirectory, jobCalculator, jobTransforms, &bulkProgress);
+        
+        // Wake the main loop so the result is reported right away
+        glfwPostEmptyEvent();
+        return success;
+    });
     
     return true;
 }
 
+void cancelBulkCapacitanceProcessing()
+{
+    if (!bulkRun.valid()) {
+        std::cout << "No bulk processing running" << std::endl;
+        return;
+    }
+    
+    std::cout << "Cancelling bulk processing after the current row..." << std::endl;
+    bulkProgress.cancelRequested = true;
+}
+
+void updateBulkProgress(GLFWwindow* window)
+{
+    if (!bulkRun.valid()) {
+        return;
+    }
+    
+    // Finished: report and restore the title
+    if (bulkRun.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+        bool success = bulkRun.get();
+        
+        std::cout << "\n" << std::string(60, '=') << std::endl;
+        if (success) {
+            std::cout << "BULK CAPACITANCE PROCESSING COMPLETED" << std::endl;
+        } else if (bulkProgress.cancelRequested) {
+            std::cout << "BULK CAPACITANCE PROCESSING CANCELLED" << std::endl;
+        } else {
+            std::cerr << "Bulk processing failed" << std::endl;
+        }
+        std::cout << std::string(60, '=') << std::endl;
+        
+        glfwSetWindowTitle(window, WINDOW_TITLE);
+        
+        // Show the new results
+        if (plotVisible) {
+            loadPlot();
+            requestRedraw();
+        }
+        return;
+    }
+    
+    // Progress in the title bar, refreshed twice a second
+    double now = glfwGetTime();
+    if (now - lastBulkTitleUpdate < 0.5) {
+        return;
+    }
+    lastBulkTitleUpdate = now;
+    
+    size_t rowsDone = bulkProgress.rowsDone.load(std::memory_order_relaxed);
+    size_t totalRows = bulkProgress.totalRows.load(std::memory_order_relaxed);
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - bulkStartTime).count();
+    double rowsPerSecond = elapsed > 0.0 ? rowsDone / elapsed : 0.0;
+    
+    std::ostringstream title;
+    title << WINDOW_TITLE << " - Bulk: " << rowsDone << "/" << totalRows << " rows";
+    if (rowsPerSecond > 0.0) {
+        title << ", " << std::fixed << std::setprecision(1) << rowsPerSecond << " rows/s";
+        
+        if (totalRows > rowsDone) {
+            long long eta = static_cast<long long>((totalRows - rowsDone) / rowsPerSecond);
+            title << ", ETA " << eta / 3600 << "h " << std::setfill('0') << std::setw(2) << (eta / 60) % 60 
+                  << "m " << std::setw(2) << eta % 60 << "s";
+        }
+    }
+    if (bulkProgress.cancelRequested) {
+        title << " (cancelling)";
+    }
+    
+    glfwSetWindowTitle(window, title.str().c_str());
+}
+
 void framebuffer_size_callback(GLFWwindow* window, int width, int height)
 {
     glViewport(0, 0, width, height);
+    requestRedraw();
+}
+
+void window_refresh_callback(GLFWwindow* window)
+{
+    // Window was exposed or damaged
+    requestRedraw();
 }
 
 void mouse_callback(GLFWwindow* window, double xpos, double ypos)
@@ -277,26 +1202,84 @@ void mouse_callback(GLFWwindow* window, double xpos, double ypos)
         firstMouse = false;
     }
 
+    // Drags that started on the plot scrub or pan it instead of rotating the camera
+    if (plotScrubbing) {
+        jumpToPlotRow(window);
+        lastX = xpos;
+        lastY = ypos;
+        return;
+    }
+    if (plotVisible && glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_RIGHT) == GLFW_PRESS) {
+        double x, y;
+        int width, height;
+        getCursorFramebufferPos(window, x, y, width, height);
+        if (plot->containsPoint(x, y, width, height)) {
+            int windowWidth, windowHeight;
+            glfwGetWindowSize(window, &windowWidth, &windowHeight);
+            double pixelsPerUnit = windowWidth > 0 ? static_cast<double>(width) / windowWidth : 1.0;
+            plot->pan((xpos - lastX) * pixelsPerUnit, width);
+            requestRedraw();
+        }
+    }
+
     // Only process mouse movement if left button is pressed
     if (glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS) {
         float xoffset = static_cast<float>(xpos - lastX);
         float yoffset = static_cast<float>(lastY - ypos); // Reversed since y-coordinates go from bottom to top
 
         camera->processMouseMovement(xoffset, yoffset);
+        requestRedraw();
     }
 
     lastX = xpos;
     lastY = ypos;
 }
 
+void mouse_button_callback(GLFWwindow* window, int button, int action, int mods)
+{
+    if (button != GLFW_MOUSE_BUTTON_LEFT) {
+        return;
+    }
+    
+    if (action == GLFW_RELEASE) {
+        plotScrubbing = false;
+        return;
+    }
+    
+    double x, y;
+    int width, height;
+    getCursorFramebufferPos(window, x, y, width, height);
+    if (action == GLFW_PRESS && plotVisible && plot->containsPoint(x, y, width, height)) {
+        plotScrubbing = true;
+        jumpToPlotRow(window);
+        requestRedraw();
+    }
+}
+
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
 {
+    // Over the plot the wheel zooms its time axis
+    if (plotVisible) {
+        double x, y;
+        int width, height;
+        getCursorFramebufferPos(window, x, y, width, height);
+        if (plot->containsPoint(x, y, width, height)) {
+            plot->zoom(x, width, yoffset);
+            requestRedraw();
+            return;
+        }
+    }
+    
     camera->processMouseScroll(static_cast<float>(yoffset));
+    requestRedraw();
 }
 
 void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods)
 {
     if (action == GLFW_PRESS) {
+        // Any handled key may change what is shown
+        requestRedraw();
+        
         switch (key) {
             case GLFW_KEY_ESCAPE:
                 glfwSetWindowShouldClose(window, true);
@@ -306,11 +1289,22 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
                 std::cout << "Wireframe mode: " << (wireframeMode ? "ON" : "OFF") << std::endl;
                 break;
             case GLFW_KEY_C:  // Single capacitance calculation
-                if (capacitanceCalculator) {
-                    std::cout << "\nCalculating single capacitance..." << std::endl;
-                    std::vector<CapacitanceResult> results = capacitanceCalculator->calculateCapacitances();
-                    capacitanceCalculator->printResults(results);
-                }
+                calculateSingleCapacitance();
+                break;
+            case GLFW_KEY_L:  // Live capacitance readout
+                toggleLiveMode();
+                break;
+            case GLFW_KEY_R:  // Debug ray capture
+                toggleRayCapture();
+                break;
+            case GLFW_KEY_H:  // Per-triangle heatmap
+                cycleHeatmapMode();
+                break;
+            case GLFW_KEY_F:  // Frame timing overlay
+                toggleFrameTiming();
+                break;
+            case GLFW_KEY_E:  // Export frame timing
+                exportFrameTiming();
                 break;
             case GLFW_KEY_S:  // Initialize step mode
                 std::cout << "\nInitializing step mode..." << std::endl;
@@ -338,10 +1332,47 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
                     std::cout << "Step mode not active. Press 'S' to initialize." << std::endl;
                 }
                 break;
-            case GLFW_KEY_B:  // Bulk capacitance processing
-                std::cout << "\nStarting bulk capacitance processing..." << std::endl;
+            case GLFW_KEY_PAGE_UP:  // Jump back a page of rows
+                if (stepMode && stepModeInitialized) {
+                    stepToRow(currentRow > PAGE_ROWS ? currentRow - PAGE_ROWS : 0);
+                }
+                break;
+            case GLFW_KEY_PAGE_DOWN:  // Jump forward a page of rows
+                if (stepMode && stepModeInitialized) {
+                    stepToRow(std::min(currentRow + PAGE_ROWS, maxRows - 1));
+                }
+                break;
+            case GLFW_KEY_HOME:
+                if (stepMode && stepModeInitialized) {
+                    stepToRow(0);
+                }
+                break;
+            case GLFW_KEY_END:
+                if (stepMode && stepModeInitialized) {
+                    stepToRow(maxRows - 1);
+                }
+                break;
+            case GLFW_KEY_G:  // Play/pause the run file
+                togglePlayback();
+                break;
+            case GLFW_KEY_LEFT_BRACKET:  // Slower playback
+            case GLFW_KEY_RIGHT_BRACKET:  // Faster playback
+                playbackSpeed = key == GLFW_KEY_RIGHT_BRACKET ? playbackSpeed * 2.0 : playbackSpeed * 0.5;
+                playbackSpeed = std::max(MIN_PLAYBACK_SPEED, std::min(playbackSpeed, MAX_PLAYBACK_SPEED));
+                std::cout << "Playback speed: " << playbackSpeed << " rows/s" << std::endl;
+                if (runFile->isOpen()) {
+                    updateStepOverlay();
+                }
+                break;
+            case GLFW_KEY_T:  // Capacitance time-series plot
+                togglePlot();
+                break;
+            case GLFW_KEY_B:  // Bulk capacitance processing (runs in the background)
                 runBulkCapacitanceProcessing();
                 break;
+            case GLFW_KEY_X:  // Cancel bulk capacitance processing
+                cancelBulkCapacitanceProcessing();
+                break;
         }
     }
 }
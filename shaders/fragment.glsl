@@ -1,9 +1,28 @@
 #version 330 core
+in vec3 vertexColor;
 out vec4 FragColor;
 
-uniform vec3 color;
+uniform bool useHeatmap;              // Colour by the per-triangle scalars instead
+uniform samplerBuffer triangleScalars;
+uniform vec2 heatmapRange;            // Value mapped to the cold end, value mapped to the hot end
+
+vec3 heatmapColor(float t)
+{
+    // Blue - cyan - green - yellow - red
+    return clamp(vec3(1.5 - abs(4.0 * t - 3.0), 1.5 - abs(4.0 * t - 2.0), 1.5 - abs(4.0 * t - 1.0)), 0.0, 1.0);
+}
 
 void main()
 {
-    FragColor = vec4(color, 1.0);
+    if (useHeatmap) {
+        float value = texelFetch(triangleScalars, gl_PrimitiveID).r;
+        if (value < 0.0) {
+            FragColor = vec4(0.3, 0.3, 0.3, 1.0);  // No data (ray missed)
+            return;
+        }
+        float t = clamp((value - heatmapRange.x) / (heatmapRange.y - heatmapRange.x), 0.0, 1.0);
+        FragColor = vec4(heatmapColor(t), 1.0);
+        return;
+    }
+    FragColor = vec4(vertexColor, 1.0);
 }
\ No newline at end of file
@@ -1,11 +1,23 @@
 #version 330 core
 layout (location = 0) in vec3 aPos;
+layout (location = 1) in mat4 aInstanceModel;  // Occupies locations 1-4
+layout (location = 5) in vec3 aInstanceColor;
+
+layout (std140) uniform Camera
+{
+    mat4 view;
+    mat4 projection;
+};
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+uniform vec3 color;
+uniform bool useInstancing;  // Per-instance attributes instead of the model/color uniforms
+
+out vec3 vertexColor;
 
 void main()
 {
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
+    mat4 modelMatrix = useInstancing ? aInstanceModel : model;
+    vertexColor = useInstancing ? aInstanceColor : color;
+    gl_Position = projection * view * modelMatrix * vec4(aPos, 1.0);
 }
\ No newline at end of file
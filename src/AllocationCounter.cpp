@@ -0,0 +1,125 @@
+#include "AllocationCounter.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#ifdef FT_SIM_COUNT_ALLOCATIONS
+
+namespace {
+    std::atomic<size_t> allocationCount{0};
+    thread_local size_t threadAllocationCount = 0;
+
+    void* countedAllocate(size_t size)
+    {
+        allocationCount.fetch_add(1, std::memory_order_relaxed);
+        threadAllocationCount++;
+        if (size == 0) size = 1;
+        return std::malloc(size);
+    }
+
+    void* countedAllocateAligned(size_t size, size_t alignment)
+    {
+        allocationCount.fetch_add(1, std::memory_order_relaxed);
+        threadAllocationCount++;
+        if (size == 0) size = 1;
+        // Round up so the size is a multiple of the alignment
+        size = (size + alignment - 1) / alignment * alignment;
+#ifdef _WIN32
+        return _aligned_malloc(size, alignment);
+#else
+        return std::aligned_alloc(alignment, size);
+#endif
+    }
+
+    void countedFreeAligned(void* ptr)
+    {
+#ifdef _WIN32
+        _aligned_free(ptr);
+#else
+        std::free(ptr);
+#endif
+    }
+}
+
+void* operator new(size_t size)
+{
+    void* ptr = countedAllocate(size);
+    if (!ptr) throw std::bad_alloc();
+    return ptr;
+}
+
+void* operator new[](size_t size)
+{
+    void* ptr = countedAllocate(size);
+    if (!ptr) throw std::bad_alloc();
+    return ptr;
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    return countedAllocate(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+    return countedAllocate(size);
+}
+
+void* operator new(size_t size, std::align_val_t alignment)
+{
+    void* ptr = countedAllocateAligned(size, static_cast<size_t>(alignment));
+    if (!ptr) throw std::bad_alloc();
+    return ptr;
+}
+
+void* operator new[](size_t size, std::align_val_t alignment)
+{
+    void* ptr = countedAllocateAligned(size, static_cast<size_t>(alignment));
+    if (!ptr) throw std::bad_alloc();
+    return ptr;
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::align_val_t) noexcept { countedFreeAligned(ptr); }
+void operator delete[](void* ptr, std::align_val_t) noexcept { countedFreeAligned(ptr); }
+void operator delete(void* ptr, size_t, std::align_val_t) noexcept { countedFreeAligned(ptr); }
+void operator delete[](void* ptr, size_t, std::align_val_t) noexcept { countedFreeAligned(ptr); }
+
+bool AllocationCounter::isEnabled()
+{
+    return true;
+}
+
+size_t AllocationCounter::getCount()
+{
+    return allocationCount.load(std::memory_order_relaxed);
+}
+
+size_t AllocationCounter::getThreadCount()
+{
+    return threadAllocationCount;
+}
+
+#else
+
+bool AllocationCounter::isEnabled()
+{
+    return false;
+}
+
+size_t AllocationCounter::getCount()
+{
+    return 0;
+}
+
+size_t AllocationCounter::getThreadCount()
+{
+    return 0;
+}
+
+#endif
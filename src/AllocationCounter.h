@@ -0,0 +1,22 @@
+#ifndef ALLOCATIONCOUNTER_H
+#define ALLOCATIONCOUNTER_H
+
+#include <cstddef>
+
+// Counts global operator new calls when built with FT_SIM_COUNT_ALLOCATIONS.
+// Used by the bulk processor to verify that steady-state rows do not allocate; normal
+// builds compile the counting out and the check never triggers.
+class AllocationCounter
+{
+public:
+    // True when the counting operator new replacement is compiled in
+    static bool isEnabled();
+
+    // Number of heap allocations made through operator new so far
+    static size_t getCount();
+
+    // Same, counting only allocations made by the calling thread (unaffected by other threads)
+    static size_t getThreadCount();
+};
+
+#endif
@@ -1,11 +1,19 @@
 #include "BulkCapacitanceProcessor.h"
+#include "AllocationCounter.h"
+#include "PerfCounters.h"
+#include "StageTimers.h"
+#include "Tracer.h"
 #include <iostream>
 #include <fstream>
 #include <sstream>
 #include <iomanip>
 #include <algorithm>
+#include <chrono>
 #include <cmath>
 #include <cfloat>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
 
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
@@ -89,37 +97,37 @@ bool BulkCapacitanceProcessor::stepToRow(size_t rowNumber, TransformManager& tra
     if (currentStepRow < tagData.rows.size()) {
         // Calculate TAG transformation
         SpherePositions tagDeformed = addOffsets(tagResting, tagData.rows[currentStepRow].offsets);
-        updateCentroidStats("TAG", tagDeformed);
+        updateCentroidStats(tagCentroidStats, tagDeformed);
         CoordinateSystem tagUVW = createCoordinateSystem(tagResting.A, tagResting.B, tagResting.C, 'A');
         CoordinateSystem tagIJK = createCoordinateSystem(tagDeformed.A, tagDeformed.B, tagDeformed.C, 'A');
         glm::mat4 tagTransform = calculateRigidBodyTransform(tagUVW, tagIJK);
         
         // Apply TAG transformation to TransformManager
-        transformManager.applyCalculatedTransform("TAG", tagTransform);
+        transformManager.applyCalculatedTransform(SubGroupType::TAG, tagTransform);
     }
     
     if (currentStepRow < tbgData.rows.size()) {
         // Calculate TBG transformation
         SpherePositions tbgDeformed = addOffsets(tbgResting, tbgData.rows[currentStepRow].offsets);
-        updateCentroidStats("TBG", tbgDeformed);
+        updateCentroidStats(tbgCentroidStats, tbgDeformed);
         CoordinateSystem tbgUVW = createCoordinateSystem(tbgResting.A, tbgResting.B, tbgResting.C, 'B');
         CoordinateSystem tbgIJK = createCoordinateSystem(tbgDeformed.A, tbgDeformed.B, tbgDeformed.C, 'B');
         glm::mat4 tbgTransform = calculateRigidBodyTransform(tbgUVW, tbgIJK);
         
         // Apply TBG transformation to TransformManager
-        transformManager.applyCalculatedTransform("TBG", tbgTransform);
+        transformManager.applyCalculatedTransform(SubGroupType::TBG, tbgTransform);
     }
     
     if (currentStepRow < tcgData.rows.size()) {
         // Calculate TCG transformation
         SpherePositions tcgDeformed = addOffsets(tcgResting, tcgData.rows[currentStepRow].offsets);
-        updateCentroidStats("TCG", tcgDeformed);
+        updateCentroidStats(tcgCentroidStats, tcgDeformed);
         CoordinateSystem tcgUVW = createCoordinateSystem(tcgResting.A, tcgResting.B, tcgResting.C, 'C');
         CoordinateSystem tcgIJK = createCoordinateSystem(tcgDeformed.A, tcgDeformed.B, tcgDeformed.C, 'C');
         glm::mat4 tcgTransform = calculateRigidBodyTransform(tcgUVW, tcgIJK);
         
         // Apply TCG transformation to TransformManager
-        transformManager.applyCalculatedTransform("TCG", tcgTransform);
+        transformManager.applyCalculatedTransform(SubGroupType::TCG, tcgTransform);
     }
     
     return true;
@@ -194,13 +202,23 @@ void BulkCapacitanceProcessor::printDetailedDebugInfo(size_t row, TransformManag
 
 bool BulkCapacitanceProcessor::processCSVFiles(const std::string& csvDirectory, 
                                              CapacitanceCalculator& capacitanceCalculator,
-                                             TransformManager& transformManager)
+                                             TransformManager& transformManager,
+                                             BulkProgress* progress)
 {
     std::cout << "Starting bulk capacitance processing..." << std::endl;
+    auto startTime = std::chrono::steady_clock::now();
+    StageTimers::resetThread();
+    PerfCounters::resetThread();
     
     // Reset centroid statistics
     resetCentroidStats();
     
+    // Scenes are built on first use; a build that fails here would fail on every row
+    if (!capacitanceCalculator.ensureScenes()) {
+        std::cerr << "Failed to build the Embree scenes; bulk processing not started" << std::endl;
+        return false;
+    }
+    
     // Load all individual sphere CSV files and combine into group data
     if (!loadGroupFromIndividualFiles(csvDirectory, "TAG", tagData)) {
         std::cerr << "Failed to load TAG group files" << std::endl;
@@ -229,62 +247,89 @@ bool BulkCapacitanceProcessor::processCSVFiles(const std::string& csvDirectory,
     std::cout << "  TCG: " << tcgData.rows.size() << " rows" << std::endl;
     std::cout << "  Processing " << maxRows << " rows total" << std::endl;
     
-    // Storage for all results
-    std::vector<std::vector<CapacitanceResult>> allResults;
+    if (progress) {
+        progress->rowsDone.store(0, std::memory_order_relaxed);
+        progress->totalRows.store(maxRows, std::memory_order_relaxed);
+    }
+    
+    // Preallocate result storage for every row up front
+    capacitanceBuffer.assign(maxRows * CAPACITANCE_COLUMNS, 0.0);
+    rowResults.reserve(CAPACITANCE_COLUMNS);
+    runRecords.assign(maxRows, RunRecord());
+    
+    // Resting positions do not change between rows
+    SpherePositions tagResting = getRestingPositions("TAG");
+    SpherePositions tbgResting = getRestingPositions("TBG");
+    SpherePositions tcgResting = getRestingPositions("TCG");
+    
+    if (AllocationCounter::isEnabled()) {
+        std::cout << "Allocation counting enabled: rows after " << ALLOCATION_WARMUP_ROWS 
+                  << " warm-up row(s) must not allocate" << std::endl;
+    }
     
     // Process each row
+    size_t rowsCompleted = 0;
+    bool cancelled = false;
+    bool allocationCheckFailed = false;
+    bool calculationFailed = false;
     for (size_t row = 0; row < maxRows; row++) {
-        // Get resting positions for each group
-        SpherePositions tagResting = getRestingPositions("TAG");
-        SpherePositions tbgResting = getRestingPositions("TBG");
-        SpherePositions tcgResting = getRestingPositions("TCG");
+        if (progress && progress->cancelRequested.load(std::memory_order_relaxed)) {
+            cancelled = true;
+            break;
+        }
         
-        // Reset transformations to default state
-        resetTransformations(transformManager);
+        size_t allocationsBeforeRow = AllocationCounter::getThreadCount();
+        FT_TRACE_SCOPE("bulk", "row", "row", static_cast<int64_t>(row));
+        FT_PERF_REGION(PerfRegion::Row);
         
-        // Apply transformations for this row
-        if (row < tagData.rows.size()) {
-            // Calculate TAG transformation
-            SpherePositions tagDeformed = addOffsets(tagResting, tagData.rows[row].offsets);
-            updateCentroidStats("TAG", tagDeformed);
-            CoordinateSystem tagUVW = createCoordinateSystem(tagResting.A, tagResting.B, tagResting.C, 'A');
-            CoordinateSystem tagIJK = createCoordinateSystem(tagDeformed.A, tagDeformed.B, tagDeformed.C, 'A');
-            glm::mat4 tagTransform = calculateRigidBodyTransform(tagUVW, tagIJK);
-            
-            // Apply TAG transformation to TransformManager
-            transformManager.applyCalculatedTransform("TAG", tagTransform);
+        // Calculate this row's pose and apply it
+        RunRecord& record = runRecords[row];
+        {
+            FT_STAGE_TIMER(BulkStage::Pose);
+            computeRowPose(row, tagResting, tbgResting, tcgResting, record, true);
+            applyRunRecord(record, transformManager);
         }
         
-        if (row < tbgData.rows.size()) {
-            // Calculate TBG transformation
-            SpherePositions tbgDeformed = addOffsets(tbgResting, tbgData.rows[row].offsets);
-            updateCentroidStats("TBG", tbgDeformed);
-            CoordinateSystem tbgUVW = createCoordinateSystem(tbgResting.A, tbgResting.B, tbgResting.C, 'B');
-            CoordinateSystem tbgIJK = createCoordinateSystem(tbgDeformed.A, tbgDeformed.B, tbgDeformed.C, 'B');
-            glm::mat4 tbgTransform = calculateRigidBodyTransform(tbgUVW, tbgIJK);
-            
-            // Apply TBG transformation to TransformManager
-            transformManager.applyCalculatedTransform("TBG", tbgTransform);
+        // Refresh geometry with new transforms
+        {
+            FT_STAGE_TIMER(BulkStage::GeometryRefresh);
+            capacitanceCalculator.refreshGeometry();
         }
         
-        if (row < tcgData.rows.size()) {
-            // Calculate TCG transformation
-            SpherePositions tcgDeformed = addOffsets(tcgResting, tcgData.rows[row].offsets);
-            updateCentroidStats("TCG", tcgDeformed);
-            CoordinateSystem tcgUVW = createCoordinateSystem(tcgResting.A, tcgResting.B, tcgResting.C, 'C');
-            CoordinateSystem tcgIJK = createCoordinateSystem(tcgDeformed.A, tcgDeformed.B, tcgDeformed.C, 'C');
-            glm::mat4 tcgTransform = calculateRigidBodyTransform(tcgUVW, tcgIJK);
-            
-            // Apply TCG transformation to TransformManager
-            transformManager.applyCalculatedTransform("TCG", tcgTransform);
+        // Calculate capacitance for this configuration into the reusable row buffer
+        {
+            FT_STAGE_TIMER(BulkStage::RayCast);
+            calculationFailed = !capacitanceCalculator.calculateCapacitances(rowResults, 0, nullptr);
+        }
+        if (calculationFailed) {
+            std::cerr << "Capacitance calculation failed at row " << (row + 1) << std::endl;
+            break;
         }
         
-        // Refresh geometry with new transforms
-        capacitanceCalculator.refreshGeometry();
+        double* rowCapacitances = &capacitanceBuffer[row * CAPACITANCE_COLUMNS];
+        for (size_t i = 0; i < CAPACITANCE_COLUMNS && i < rowResults.size(); i++) {
+            rowCapacitances[i] = rowResults[i].capacitance;
+            record.capacitances[i] = rowResults[i].capacitance;
+        }
+        record.flags |= RUN_ROW_COMPUTED;
         
-        // Calculate capacitance for this configuration
-        std::vector<CapacitanceResult> results = capacitanceCalculator.calculateCapacitances();
-        allResults.push_back(results);
+        rowsCompleted = row + 1;
+        
+        // Allocation-check builds stop the run (keeping the rows done) if a steady-state row touched the heap
+        if (AllocationCounter::isEnabled() && row >= ALLOCATION_WARMUP_ROWS) {
+            size_t rowAllocations = AllocationCounter::getThreadCount() - allocationsBeforeRow;
+            if (rowAllocations > 0) {
+                std::cerr << "Allocation check failed: row " << (row + 1) << " made " 
+                          << rowAllocations << " heap allocation(s)" << std::endl;
+                allocationCheckFailed = true;
+                break;
+            }
+        }
+        
+        FT_STAGE_COUNT(BulkCounter::Rows, 1);
+        if (progress) {
+            progress->rowsDone.store(rowsCompleted, std::memory_order_relaxed);
+        }
         
         // Print progress every 50 rows or for important milestones
         if ((row + 1) % 50 == 0 || row == 0 || (row + 1) == maxRows) {
@@ -292,12 +337,50 @@ bool BulkCapacitanceProcessor::processCSVFiles(const std::string& csvDirectory,
         }
     }
     
+    // Leave the run's transform manager at the rest pose
+    resetTransformations(transformManager);
+    
+    // The run file gets every row's pose; rows not reached keep RUN_ROW_COMPUTED clear
+    for (size_t row = rowsCompleted; row < maxRows; row++) {
+        computeRowPose(row, tagResting, tbgResting, tcgResting, runRecords[row], false);
+    }
+    bool stopped = cancelled || allocationCheckFailed || calculationFailed;
+    std::string runPath = stopped ? RunFile::getPartialRunPath(csvDirectory) : RunFile::getRunPath(csvDirectory);
+    {
+        FT_STAGE_TIMER(BulkStage::Save);
+        FT_TRACE_SCOPE("bulk", "save run file");
+        if (RunFile::save(runPath, runRecords)) {
+            FT_STAGE_COUNT(BulkCounter::BytesWritten, std::filesystem::file_size(runPath));
+            std::cout << "Pose trajectory and results saved to: " << runPath << std::endl;
+        }
+    }
+    
+    // A cancelled or stopped run keeps the complete results of a previous run and writes its rows separately
+    if (stopped) {
+        std::string partialPath = csvDirectory + "/capacitance_results_partial.csv";
+        if (!saveResults(capacitanceBuffer, rowsCompleted, partialPath)) {
+            std::cerr << "Failed to save partial results" << std::endl;
+            return false;
+        }
+        const char* reason = cancelled ? "cancelled" : allocationCheckFailed ? "stopped by the allocation check"
+                                                                             : "stopped by a failed calculation";
+        std::cout << "Bulk processing " << reason << " after "
+                  << rowsCompleted << "/" << maxRows << " rows. Partial results saved to: " << partialPath << std::endl;
+        EmbreeMemoryStats embreeMemory = capacitanceCalculator.getMemoryStats();
+        embreeMemory.print();
+        writeStageReport(csvDirectory, startTime, true, embreeMemory);
+        return false;
+    }
+    
     // Save results to CSV
     std::string outputPath = csvDirectory + "/capacitance_results.csv";
-    if (!saveResults(allResults, outputPath)) {
+    if (!saveResults(capacitanceBuffer, maxRows, outputPath)) {
         std::cerr << "Failed to save results" << std::endl;
         return false;
     }
+    EmbreeMemoryStats embreeMemory = capacitanceCalculator.getMemoryStats();
+    embreeMemory.print();
+    writeStageReport(csvDirectory, startTime, false, embreeMemory);
     
     std::cout << "Bulk processing complete. Results saved to: " << outputPath << std::endl;
     
@@ -307,36 +390,25 @@ bool BulkCapacitanceProcessor::processCSVFiles(const std::string& csvDirectory,
     return true;
 }
 
-void BulkCapacitanceProcessor::updateCentroidStats(const std::string& groupName, const SpherePositions& currentPositions)
+void BulkCapacitanceProcessor::updateCentroidStats(CentroidStats& stats, const SpherePositions& currentPositions)
 {
     // Calculate current circumcenter
     glm::vec3 currentCentroid = calculateCircumcenter(currentPositions.A, currentPositions.B, currentPositions.C);
     
-    CentroidStats* stats = nullptr;
-    if (groupName == "TAG") {
-        stats = &tagCentroidStats;
-    } else if (groupName == "TBG") {
-        stats = &tbgCentroidStats;
-    } else if (groupName == "TCG") {
-        stats = &tcgCentroidStats;
-    } else {
-        return;
-    }
-    
     // Update current position
-    stats->currentPosition = currentCentroid;
+    stats.currentPosition = currentCentroid;
     
     // Update min/max tracking
-    stats->minPosition.x = std::min(stats->minPosition.x, currentCentroid.x);
-    stats->minPosition.y = std::min(stats->minPosition.y, currentCentroid.y);
-    stats->minPosition.z = std::min(stats->minPosition.z, currentCentroid.z);
+    stats.minPosition.x = std::min(stats.minPosition.x, currentCentroid.x);
+    stats.minPosition.y = std::min(stats.minPosition.y, currentCentroid.y);
+    stats.minPosition.z = std::min(stats.minPosition.z, currentCentroid.z);
     
-    stats->maxPosition.x = std::max(stats->maxPosition.x, currentCentroid.x);
-    stats->maxPosition.y = std::max(stats->maxPosition.y, currentCentroid.y);
-    stats->maxPosition.z = std::max(stats->maxPosition.z, currentCentroid.z);
+    stats.maxPosition.x = std::max(stats.maxPosition.x, currentCentroid.x);
+    stats.maxPosition.y = std::max(stats.maxPosition.y, currentCentroid.y);
+    stats.maxPosition.z = std::max(stats.maxPosition.z, currentCentroid.z);
     
     // Calculate and update bounding sphere radius
-    calculateBoundingSphere(*stats);
+    calculateBoundingSphere(stats);
 }
 
 void BulkCapacitanceProcessor::calculateBoundingSphere(CentroidStats& stats)
@@ -457,6 +529,10 @@ void BulkCapacitanceProcessor::resetCentroidStats()
 
 bool BulkCapacitanceProcessor::loadGroupFromIndividualFiles(const std::string& csvDirectory, const std::string& groupName, GroupCSVData& groupData)
 {
+    FT_STAGE_TIMER(BulkStage::CsvParse);
+    // The group name is passed through as-is so nothing is allocated while tracing is off
+    FT_TRACE_SCOPE("csv_load", groupName);
+    
     // Map group names to file prefixes
     std::string prefix;
     if (groupName == "TAG") {
@@ -524,8 +600,8 @@ bool BulkCapacitanceProcessor::loadIndividualSphereFile(const std::string& fileP
     bool firstLine = true;
     
     while (std::getline(file, line)) {
-        line = trim(line);
-        if (line.empty()) continue;
+        FT_STAGE_COUNT(BulkCounter::BytesRead, line.size() + 1);
+        if (trimView(line).empty()) continue;
         
         // Skip header row
         if (firstLine) {
@@ -545,24 +621,18 @@ bool BulkCapacitanceProcessor::loadIndividualSphereFile(const std::string& fileP
 
 bool BulkCapacitanceProcessor::parseIndividualSphereRow(const std::string& line, glm::vec3& offset)
 {
-    std::vector<std::string> tokens = splitCSVLine(line);
-    
-    if (tokens.size() < 3) {
-        std::cerr << "Invalid CSV row: expected 3 columns (UX,UY,UZ), got " << tokens.size() << std::endl;
+    float values[3];
+    if (!parseCSVFloats(line, values, 3)) {
+        std::cerr << "Invalid CSV row: expected 3 numeric columns (UX,UY,UZ): " << line << std::endl;
         return false;
     }
     
-    try {
-        // Parse UX, UY, UZ and convert from meters to mm
-        offset.x = std::stof(tokens[0]) * 1000.0f;
-        offset.y = std::stof(tokens[1]) * 1000.0f;
-        offset.z = std::stof(tokens[2]) * 1000.0f;
-        
-        return true;
-    } catch (const std::exception& e) {
-        std::cerr << "Error parsing CSV row: " << e.what() << std::endl;
-        return false;
-    }
+    // Parse UX, UY, UZ and convert from meters to mm
+    offset.x = values[0] * 1000.0f;
+    offset.y = values[1] * 1000.0f;
+    offset.z = values[2] * 1000.0f;
+    
+    return true;
 }
 
 bool BulkCapacitanceProcessor::loadCSVFile(const std::string& filePath, GroupCSVData& groupData)
@@ -577,8 +647,8 @@ bool BulkCapacitanceProcessor::loadCSVFile(const std::string& filePath, GroupCSV
     bool firstLine = true;
     
     while (std::getline(file, line)) {
-        line = trim(line);
-        if (line.empty()) continue;
+        FT_STAGE_COUNT(BulkCounter::BytesRead, line.size() + 1);
+        if (trimView(line).empty()) continue;
         
         // Skip header row
         if (firstLine) {
@@ -598,45 +668,63 @@ bool BulkCapacitanceProcessor::loadCSVFile(const std::string& filePath, GroupCSV
 
 bool BulkCapacitanceProcessor::parseCSVRow(const std::string& line, GroupRowData& rowData)
 {
-    std::vector<std::string> tokens = splitCSVLine(line);
-    
-    if (tokens.size() < 9) {
-        std::cerr << "Invalid CSV row: expected 9 columns, got " << tokens.size() << std::endl;
+    float values[9];
+    if (!parseCSVFloats(line, values, 9)) {
+        std::cerr << "Invalid CSV row: expected 9 numeric columns: " << line << std::endl;
         return false;
     }
     
-    try {
-        // Parse A, B, C positions (convert from meters to mm)
-        rowData.offsets.A.x = std::stof(tokens[0]) * 1000.0f;
-        rowData.offsets.A.y = std::stof(tokens[1]) * 1000.0f;
-        rowData.offsets.A.z = std::stof(tokens[2]) * 1000.0f;
-        
-        rowData.offsets.B.x = std::stof(tokens[3]) * 1000.0f;
-        rowData.offsets.B.y = std::stof(tokens[4]) * 1000.0f;
-        rowData.offsets.B.z = std::stof(tokens[5]) * 1000.0f;
-        
-        rowData.offsets.C.x = std::stof(tokens[6]) * 1000.0f;
-        rowData.offsets.C.y = std::stof(tokens[7]) * 1000.0f;
-        rowData.offsets.C.z = std::stof(tokens[8]) * 1000.0f;
+    // Parse A, B, C positions (convert from meters to mm)
+    rowData.offsets.A = glm::vec3(values[0], values[1], values[2]) * 1000.0f;
+    rowData.offsets.B = glm::vec3(values[3], values[4], values[5]) * 1000.0f;
+    rowData.offsets.C = glm::vec3(values[6], values[7], values[8]) * 1000.0f;
+    
+    return true;
+}
+
+size_t BulkCapacitanceProcessor::splitCSVLine(std::string_view line, std::string_view* tokens, size_t maxTokens)
+{
+    // Split into views over the line; no strings are created
+    size_t tokenCount = 0;
+    size_t start = 0;
+    
+    while (tokenCount < maxTokens && start <= line.size()) {
+        size_t comma = line.find(',', start);
+        size_t end = (comma == std::string_view::npos) ? line.size() : comma;
+        tokens[tokenCount++] = trimView(line.substr(start, end - start));
         
-        return true;
-    } catch (const std::exception& e) {
-        std::cerr << "Error parsing CSV row: " << e.what() << std::endl;
-        return false;
+        if (comma == std::string_view::npos) break;
+        start = comma + 1;
     }
+    
+    return tokenCount;
 }
 
-std::vector<std::string> BulkCapacitanceProcessor::splitCSVLine(const std::string& line)
+bool BulkCapacitanceProcessor::parseCSVFloats(std::string_view line, float* values, size_t valueCount)
 {
-    std::vector<std::string> tokens;
-    std::stringstream ss(line);
-    std::string token;
+    constexpr size_t MAX_COLUMNS = 16;
+    std::string_view tokens[MAX_COLUMNS];
     
-    while (std::getline(ss, token, ',')) {
-        tokens.push_back(trim(token));
+    size_t tokenCount = splitCSVLine(line, tokens, MAX_COLUMNS);
+    if (tokenCount < valueCount || valueCount > MAX_COLUMNS) {
+        return false;
     }
     
-    return tokens;
+    for (size_t i = 0; i < valueCount; i++) {
+        if (tokens[i].empty()) return false;
+        
+        // Copy into a small stack buffer so strtof sees a terminated token
+        char buffer[64];
+        size_t length = std::min(tokens[i].size(), sizeof(buffer) - 1);
+        tokens[i].copy(buffer, length);
+        buffer[length] = '\0';
+        
+        char* end = nullptr;
+        values[i] = std::strtof(buffer, &end);
+        if (end == buffer) return false;
+    }
+    
+    return true;
 }
 
 glm::vec3 BulkCapacitanceProcessor::calculateCircumcenter(const glm::vec3& A, const glm::vec3& B, const glm::vec3& C)
@@ -767,11 +855,103 @@ SpherePositions BulkCapacitanceProcessor::addOffsets(const SpherePositions& rest
     return result;
 }
 
-bool BulkCapacitanceProcessor::saveResults(const std::vector<std::vector<CapacitanceResult>>& allResults, const std::string& outputPath)
+void BulkCapacitanceProcessor::computeRowPose(size_t row, const SpherePositions& tagResting,
+                                              const SpherePositions& tbgResting, const SpherePositions& tcgResting,
+                                              RunRecord& record, bool trackCentroids)
 {
-    std::ofstream file(outputPath);
+    record = RunRecord();
+    
+    if (row < tagData.rows.size()) {
+        // Calculate TAG transformation
+        SpherePositions tagDeformed = addOffsets(tagResting, tagData.rows[row].offsets);
+        if (trackCentroids) updateCentroidStats(tagCentroidStats, tagDeformed);
+        CoordinateSystem tagUVW = createCoordinateSystem(tagResting.A, tagResting.B, tagResting.C, 'A');
+        CoordinateSystem tagIJK = createCoordinateSystem(tagDeformed.A, tagDeformed.B, tagDeformed.C, 'A');
+        glm::mat4 tagTransform = calculateRigidBodyTransform(tagUVW, tagIJK);
+        
+        std::memcpy(record.transforms[0], &tagTransform[0][0], sizeof(record.transforms[0]));
+        record.flags |= RUN_ROW_HAS_TAG;
+    }
+    
+    if (row < tbgData.rows.size()) {
+        // Calculate TBG transformation
+        SpherePositions tbgDeformed = addOffsets(tbgResting, tbgData.rows[row].offsets);
+        if (trackCentroids) updateCentroidStats(tbgCentroidStats, tbgDeformed);
+        CoordinateSystem tbgUVW = createCoordinateSystem(tbgResting.A, tbgResting.B, tbgResting.C, 'B');
+        CoordinateSystem tbgIJK = createCoordinateSystem(tbgDeformed.A, tbgDeformed.B, tbgDeformed.C, 'B');
+        glm::mat4 tbgTransform = calculateRigidBodyTransform(tbgUVW, tbgIJK);
+        
+        std::memcpy(record.transforms[1], &tbgTransform[0][0], sizeof(record.transforms[1]));
+        record.flags |= RUN_ROW_HAS_TBG;
+    }
+    
+    if (row < tcgData.rows.size()) {
+        // Calculate TCG transformation
+        SpherePositions tcgDeformed = addOffsets(tcgResting, tcgData.rows[row].offsets);
+        if (trackCentroids) updateCentroidStats(tcgCentroidStats, tcgDeformed);
+        CoordinateSystem tcgUVW = createCoordinateSystem(tcgResting.A, tcgResting.B, tcgResting.C, 'C');
+        CoordinateSystem tcgIJK = createCoordinateSystem(tcgDeformed.A, tcgDeformed.B, tcgDeformed.C, 'C');
+        glm::mat4 tcgTransform = calculateRigidBodyTransform(tcgUVW, tcgIJK);
+        
+        std::memcpy(record.transforms[2], &tcgTransform[0][0], sizeof(record.transforms[2]));
+        record.flags |= RUN_ROW_HAS_TCG;
+    }
+}
+
+void BulkCapacitanceProcessor::applyRunRecord(const RunRecord& record, TransformManager& transformManager)
+{
+    // Reset transformations to default state
+    resetTransformations(transformManager);
+    
+    // Record slots map to fixed sub-groups: no name lookups per row
+    static constexpr SubGroupType RECORD_GROUPS[3] = {SubGroupType::TAG, SubGroupType::TBG, SubGroupType::TCG};
+    static constexpr uint32_t RECORD_GROUP_FLAGS[3] = {RUN_ROW_HAS_TAG, RUN_ROW_HAS_TBG, RUN_ROW_HAS_TCG};
+    
+    glm::mat4 transform;
+    for (size_t group = 0; group < 3; group++) {
+        if (record.flags & RECORD_GROUP_FLAGS[group]) {
+            std::memcpy(&transform[0][0], record.transforms[group], sizeof(record.transforms[group]));
+            transformManager.applyCalculatedTransform(RECORD_GROUPS[group], transform);
+        }
+    }
+}
+
+void BulkCapacitanceProcessor::writeStageReport(const std::string& csvDirectory,
+                                                std::chrono::steady_clock::time_point startTime, bool cancelled,
+                                                const EmbreeMemoryStats& embreeMemory)
+{
+    if (!StageTimers::isEnabled()) {
+        return;
+    }
+    
+    StageTotals totals;
+    StageTimers::takeThreadTotals(totals);
+    double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    
+    // Hardware counters of this thread's regions, when built in
+    PerfTotals hardwareCounters;
+    PerfCounters::takeThreadTotals(hardwareCounters);
+    const PerfTotals* hardware = PerfCounters::isCompiledIn() ? &hardwareCounters : nullptr;
+    
+    std::string reportPath = csvDirectory + "/bulk_run_report.json";
+    if (StageTimers::writeJsonReport(reportPath, totals, wallSeconds, maxRows, cancelled, hardware, &embreeMemory)) {
+        double rows = static_cast<double>(totals.counters[static_cast<size_t>(BulkCounter::Rows)]);
+        double rays = static_cast<double>(totals.counters[static_cast<size_t>(BulkCounter::Rays)]);
+        std::cout << "Stage timing report saved to: " << reportPath << " (" << std::fixed << std::setprecision(1)
+                  << rows / wallSeconds << " rows/s, " << std::setprecision(2) << rays / wallSeconds / 1.0e6
+                  << " Mrays/s)" << std::endl;
+    }
+}
+
+bool BulkCapacitanceProcessor::saveResults(const std::vector<double>& capacitances, size_t rowCount, const std::string& outputPath)
+{
+    FT_TRACE_SCOPE("bulk", "save results");
+    
+    // Write next to the target and rename, so readers never see a half-written file
+    std::string tempPath = outputPath + ".tmp";
+    std::ofstream file(tempPath);
     if (!file.is_open()) {
-        std::cerr << "Cannot create output file: " << outputPath << std::endl;
+        std::cerr << "Cannot create output file: " << tempPath << std::endl;
         return false;
     }
     
@@ -779,16 +959,16 @@ bool BulkCapacitanceProcessor::saveResults(const std::vector<std::vector<Capacit
     file << "Row,A1_Capacitance_pF,A2_Capacitance_pF,B1_Capacitance_pF,B2_Capacitance_pF,C1_Capacitance_pF,C2_Capacitance_pF,Total_Capacitance_pF\n";
     
     // Write data
-    for (size_t i = 0; i < allResults.size(); i++) {
-        const auto& results = allResults[i];
+    for (size_t i = 0; i < rowCount && (i + 1) * CAPACITANCE_COLUMNS <= capacitances.size(); i++) {
+        const double* rowCapacitances = &capacitances[i * CAPACITANCE_COLUMNS];
         
         file << (i + 1);  // Row number (1-based)
         
         double totalCapacitance = 0.0;
-        for (const auto& result : results) {
-            double capacitancePF = result.capacitance * 1e12;  // Convert to picofarads
+        for (size_t c = 0; c < CAPACITANCE_COLUMNS; c++) {
+            double capacitancePF = rowCapacitances[c] * 1e12;  // Convert to picofarads
             file << "," << std::fixed << std::setprecision(5) << capacitancePF;
-            totalCapacitance += result.capacitance;
+            totalCapacitance += rowCapacitances[c];
         }
         
         // Add total capacitance
@@ -796,7 +976,19 @@ bool BulkCapacitanceProcessor::saveResults(const std::vector<std::vector<Capacit
         file << "," << std::fixed << std::setprecision(5) << totalPF << "\n";
     }
     
+    FT_STAGE_COUNT(BulkCounter::BytesWritten, static_cast<std::streamoff>(file.tellp()));
     file.close();
+    if (!file) {
+        std::cerr << "Failed to write output file: " << tempPath << std::endl;
+        return false;
+    }
+    
+    std::error_code error;
+    std::filesystem::rename(tempPath, outputPath, error);
+    if (error) {
+        std::cerr << "Cannot replace output file " << outputPath << ": " << error.message() << std::endl;
+        return false;
+    }
     return true;
 }
 
@@ -834,10 +1026,10 @@ void BulkCapacitanceProcessor::resetTransformations(TransformManager& transformM
     transformManager.buildTransformationMatrices();
 }
 
-std::string BulkCapacitanceProcessor::trim(const std::string& str)
+std::string_view BulkCapacitanceProcessor::trimView(std::string_view str)
 {
     size_t start = str.find_first_not_of(" \t\r\n");
-    if (start == std::string::npos) return "";
+    if (start == std::string_view::npos) return std::string_view();
     
     size_t end = str.find_last_not_of(" \t\r\n");
     return str.substr(start, end - start + 1);
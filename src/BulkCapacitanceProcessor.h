@@ -1,11 +1,15 @@
 #ifndef BULKCAPACITANCEPROCESSOR_H
 #define BULKCAPACITANCEPROCESSOR_H
 
+#include <atomic>
+#include <chrono>
 #include <vector>
 #include <string>
+#include <string_view>
 #include <glm/glm.hpp>
 #include "CapacitanceCalculator.h"
 #include "Transform.h"
+#include "RunFile.h"
 
 // Structure to hold sphere position data for one row
 struct SpherePositions {
@@ -45,16 +49,33 @@ struct CentroidStats {
         boundingSphereRadius(0.0f) {}
 };
 
+// Progress of a bulk run, published by the worker and polled by the viewer without locking
+struct BulkProgress {
+    std::atomic<size_t> rowsDone{0};
+    std::atomic<size_t> totalRows{0};
+    std::atomic<bool> cancelRequested{false};
+    
+    void reset()
+    {
+        rowsDone = 0;
+        totalRows = 0;
+        cancelRequested = false;
+    }
+};
+
 class BulkCapacitanceProcessor
 {
 public:
     BulkCapacitanceProcessor();
     ~BulkCapacitanceProcessor();
 
-    // Original bulk processing function
+    // Original bulk processing function. With a progress object, rows done are published as
+    // they complete and a cancel request stops the run after the current row; the rows finished
+    // so far are then written to capacitance_results_partial.csv and false is returned.
     bool processCSVFiles(const std::string& csvDirectory, 
                         CapacitanceCalculator& capacitanceCalculator,
-                        TransformManager& transformManager);
+                        TransformManager& transformManager,
+                        BulkProgress* progress = nullptr);
 
     // NEW: Step mode functions
     bool initializeStepMode(const std::string& csvDirectory);
@@ -63,6 +84,9 @@ public:
     size_t getMaxRows() const;
     void printCurrentRowInfo() const;
 
+    // Apply the pose stored in a run file record (O(1); no CSV data needed)
+    static void applyRunRecord(const RunRecord& record, TransformManager& transformManager);
+
 private:
     // NEW: Individual file loading methods
     bool loadGroupFromIndividualFiles(const std::string& csvDirectory, const std::string& groupName, GroupCSVData& groupData);
@@ -72,7 +96,8 @@ private:
     // Original CSV loading methods (kept for compatibility)
     bool loadCSVFile(const std::string& filePath, GroupCSVData& groupData);
     bool parseCSVRow(const std::string& line, GroupRowData& rowData);
-    std::vector<std::string> splitCSVLine(const std::string& line);
+    size_t splitCSVLine(std::string_view line, std::string_view* tokens, size_t maxTokens);
+    bool parseCSVFloats(std::string_view line, float* values, size_t valueCount);
 
     // Geometry calculations
     glm::vec3 calculateCircumcenter(const glm::vec3& A, const glm::vec3& B, const glm::vec3& C);
@@ -82,24 +107,32 @@ private:
     // Rigid body transformation
     glm::mat4 calculateRigidBodyTransform(const CoordinateSystem& from, const CoordinateSystem& to);
     
+    // Pose of one row (calculated group transforms) from the loaded CSV data
+    void computeRowPose(size_t row, const SpherePositions& tagResting, const SpherePositions& tbgResting,
+                        const SpherePositions& tcgResting, RunRecord& record, bool trackCentroids);
+    
     // Sphere position management
     SpherePositions getRestingPositions(const std::string& groupName);
     SpherePositions addOffsets(const SpherePositions& resting, const SpherePositions& offsets);
     
     // NEW: Centroid tracking methods
-    void updateCentroidStats(const std::string& groupName, const SpherePositions& currentPositions);
+    void updateCentroidStats(CentroidStats& stats, const SpherePositions& currentPositions);
     void calculateBoundingSphere(CentroidStats& stats);
     void printCentroidStats() const;
     void resetCentroidStats();
     
-    // Output
-    bool saveResults(const std::vector<std::vector<CapacitanceResult>>& allResults, 
+    // Output (capacitances are stored row-major, CAPACITANCE_COLUMNS values per row, in Farads)
+    bool saveResults(const std::vector<double>& capacitances, size_t rowCount,
                     const std::string& outputPath);
     
+    // JSON stage timing report of the calling thread's run (no-op without FT_SIM_STAGE_TIMERS)
+    void writeStageReport(const std::string& csvDirectory, std::chrono::steady_clock::time_point startTime,
+                          bool cancelled, const EmbreeMemoryStats& embreeMemory);
+    
     // Helper functions
-    void resetTransformations(TransformManager& transformManager);
+    static void resetTransformations(TransformManager& transformManager);
     void printDetailedDebugInfo(size_t row, TransformManager& transformManager);
-    std::string trim(const std::string& str);
+    std::string_view trimView(std::string_view str);
     
     // Data storage
     GroupCSVData tagData, tbgData, tcgData;
@@ -109,6 +142,15 @@ private:
     size_t currentStepRow;
     bool stepModeActive;
     
+    // Bulk run buffers, sized before the row loop so steady-state rows do not allocate
+    std::vector<CapacitanceResult> rowResults;
+    std::vector<double> capacitanceBuffer;
+    std::vector<RunRecord> runRecords;        // Written to the run file at the end of a run
+    
+    // Rows processed before the allocation check starts (buffers are sized on the first row)
+    static constexpr size_t ALLOCATION_WARMUP_ROWS = 1;
+    static constexpr size_t CAPACITANCE_COLUMNS = 6;
+    
     // NEW: Centroid tracking data
     CentroidStats tagCentroidStats;
     CentroidStats tbgCentroidStats;
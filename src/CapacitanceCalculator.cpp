@@ -1,8 +1,13 @@
 #include "CapacitanceCalculator.h"
+#include "RayCapture.h"
+#include "PerfCounters.h"
+#include "StageTimers.h"
+#include "Tracer.h"
 #include <iostream>
 #include <iomanip>
 #include <cmath>
 #include <algorithm>
+#include <chrono>
 
 // Constants
 constexpr double FARADS_TO_PICOFARADS = 1e12;
@@ -12,8 +17,12 @@ const std::vector<std::string> CapacitanceCalculator::POSITIVE_MODEL_NAMES = {
     "A1_model", "A2_model", "B1_model", "B2_model", "C1_model", "C2_model"
 };
 
+EmbreeConfig CapacitanceCalculator::defaultEmbreeConfig;
+std::mutex CapacitanceCalculator::defaultEmbreeConfigMutex;
+
 CapacitanceCalculator::CapacitanceCalculator() 
-    : device(nullptr), transformManager(nullptr)
+    : device(nullptr), scenesReady(false), geometryVersion(0), streamScenes(false), fallbackBuilds(0),
+      sceneEvictions(0), threadLimit(0), recordTriangleFields(false), rayCapture(nullptr), transformManager(nullptr)
 {
 }
 
@@ -26,6 +35,7 @@ bool CapacitanceCalculator::initialize(const std::vector<Model>& models, Transfo
 {
     std::cout << "Initializing CapacitanceCalculator..." << std::endl;
     
+    // Model instances are lightweight; the mesh data itself is shared, not copied
     allModels = models;
     transformManager = &transformMgr;
     
@@ -38,6 +48,28 @@ bool CapacitanceCalculator::initialize(const std::vector<Model>& models, Transfo
     // Setup model pairings
     setupModelPairings();
     
+    // Resolve model names to IDs once; the per-row path only uses IDs
+    if (!resolveModelIds()) {
+        std::cerr << "Failed to resolve capacitance model IDs" << std::endl;
+        return false;
+    }
+    
+    // Geometry extraction and BVH builds are deferred until the first calculation (see ensureScenes)
+    scenesReady = false;
+    
+    std::cout << "CapacitanceCalculator initialized successfully" << std::endl;
+    
+    return true;
+}
+
+bool CapacitanceCalculator::ensureScenes()
+{
+    if (scenesReady) {
+        return true;
+    }
+    
+    auto buildStart = std::chrono::steady_clock::now();
+    
     // Extract transformed geometry
     if (!extractTransformedGeometry()) {
         std::cerr << "Failed to extract transformed geometry" << std::endl;
@@ -50,99 +82,311 @@ bool CapacitanceCalculator::initialize(const std::vector<Model>& models, Transfo
         return false;
     }
     
-    std::cout << "CapacitanceCalculator initialized successfully" << std::endl;
+    scenesReady = true;
+    
+    double buildMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - buildStart).count();
+    std::cout << "Built " << negativeModelIds.size() << " Embree scenes in " << buildMs << " ms ("
+              << memoryMonitor.getCurrentBytes() / (1024 * 1024) << " MB of Embree memory)" << std::endl;
     
     return true;
 }
 
 void CapacitanceCalculator::refreshGeometry()
 {
-    // Release existing scenes
-    for (auto& pair : scenes) {
-        if (pair.second) {
-            rtcReleaseScene(pair.second);
-        }
-    }
-    scenes.clear();
+    FT_TRACE_SCOPE("calculator", "refreshGeometry");
     
-    // Clear existing triangle data
-    positiveTriangles.clear();
+    // First use: the initial build already reflects the current transforms
+    if (!scenesReady) {
+        ensureScenes();
+        return;
+    }
     
-    // Re-extract geometry with current transformations
+    // Re-extract geometry with current transformations (reuses the triangle buffers)
     if (!extractTransformedGeometry()) {
         std::cerr << "Failed to re-extract transformed geometry" << std::endl;
         return;
     }
     
-    // Recreate Embree scenes
-    if (!createEmbreeScenes()) {
-        std::cerr << "Failed to recreate Embree scenes" << std::endl;
+    // Update Embree scenes whose negative transform changed
+    if (!updateEmbreeScenes()) {
+        std::cerr << "Failed to update Embree scenes" << std::endl;
         return;
     }
 }
 
-std::vector<CapacitanceResult> CapacitanceCalculator::calculateCapacitances()
+void CapacitanceCalculator::refreshScenes()
 {
-    std::vector<CapacitanceResult> results;
+    FT_TRACE_SCOPE("calculator", "refreshScenes");
+    
+    if (!scenesReady) {
+        ensureScenes();
+        return;
+    }
+    
+    if (!updateEmbreeScenes()) {
+        std::cerr << "Failed to update Embree scenes" << std::endl;
+    }
+}
+
+void CapacitanceCalculator::setThreadLimit(unsigned int threads)
+{
+    threadLimit = threads;
+}
+
+void CapacitanceCalculator::updateModelMeshes(const std::vector<Model>& models, const std::vector<ModelId>& changedModels)
+{
+    bool negativeChanged = false;
     
-    for (const std::string& modelName : POSITIVE_MODEL_NAMES) {
-        CapacitanceResult result = calculateSingleCapacitance(modelName);
-        results.push_back(result);
+    for (ModelId id : changedModels) {
+        if (id >= allModels.size() || id >= models.size()) {
+            continue;
+        }
         
-        // Convert to picofarads for display
-        double capacitancePF = result.capacitance * FARADS_TO_PICOFARADS;
+        allModels[id].mesh = models[id].mesh;
+        builtVersions[id] = UNBUILT_VERSION;
+        
+        // Negative geometry was built from the old mesh: drop it so it is recreated
+        if (negativeGeoms[id]) {
+            releaseScene(id);
+            rtcReleaseGeometry(negativeGeoms[id]);
+            negativeGeoms[id] = nullptr;
+            sceneMemory[id].geometryBytes = 0;
+            negativeChanged = true;
+        }
     }
     
+    geometryVersion++;
+    
+    if (!scenesReady) {
+        return; // Everything is built from the new meshes on first use
+    }
+    
+    // Positives are re-extracted because their built version was reset
+    if (!extractTransformedGeometry()) {
+        std::cerr << "Failed to re-extract geometry after mesh update" << std::endl;
+    }
+    if (negativeChanged && !createEmbreeScenes()) {
+        std::cerr << "Failed to rebuild Embree scenes after mesh update" << std::endl;
+    }
+}
+
+void CapacitanceCalculator::setTransformManager(TransformManager& transforms)
+{
+    if (transformManager && transformManager != &transforms) {
+        // Versions of different managers are unrelated: compare the matrices the geometry was built from
+        for (ModelId id = 0; id < builtVersions.size(); id++) {
+            if (builtVersions[id] == UNBUILT_VERSION) {
+                continue;
+            }
+            bool unchanged = transforms.getCombinedTransform(id) == transformManager->getCombinedTransform(id);
+            builtVersions[id] = unchanged ? transforms.getModelTransformVersion(id) : UNBUILT_VERSION;
+        }
+    }
+    transformManager = &transforms;
+}
+
+uint64_t CapacitanceCalculator::getGeometryVersion() const
+{
+    return geometryVersion;
+}
+
+std::vector<CapacitanceResult> CapacitanceCalculator::calculateCapacitances()
+{
+    std::vector<CapacitanceResult> results;
+    calculateCapacitances(results);
     return results;
 }
 
+void CapacitanceCalculator::calculateCapacitances(std::vector<CapacitanceResult>& results)
+{
+    if (!ensureScenes()) {
+        results.clear();
+        return;
+    }
+    
+    results.resize(POSITIVE_MODEL_NAMES.size());
+    RayCapturePass capturePass(rayCapture);
+    
+    for (size_t slot = 0; slot < POSITIVE_MODEL_NAMES.size(); slot++) {
+        calculateSlotCapacitance(slot, results[slot]);
+    }
+}
+
+bool CapacitanceCalculator::calculateCapacitances(std::vector<CapacitanceResult>& results, size_t maxSamplesPerModel,
+                                                  const std::atomic<bool>* abort)
+{
+    if (!ensureScenes()) {
+        results.clear();
+        return false;
+    }
+    
+    results.resize(POSITIVE_MODEL_NAMES.size());
+    RayCapturePass capturePass(rayCapture);
+    
+    for (size_t slot = 0; slot < POSITIVE_MODEL_NAMES.size(); slot++) {
+        if (abort && abort->load(std::memory_order_relaxed)) {
+            return false;
+        }
+        
+        const Model* model = slot < positiveModelIds.size() ? getModel(positiveModelIds[slot]) : nullptr;
+        size_t triangleCount = model ? model->mesh->indices.size() / 3 : 0;
+        size_t sampleStride = 1;
+        if (maxSamplesPerModel > 0 && triangleCount > maxSamplesPerModel) {
+            sampleStride = (triangleCount + maxSamplesPerModel - 1) / maxSamplesPerModel;
+        }
+        calculateSlotCapacitance(slot, results[slot], sampleStride);
+    }
+    return true;
+}
+
 CapacitanceResult CapacitanceCalculator::calculateSingleCapacitance(const std::string& positiveModelName)
 {
     CapacitanceResult result;
     result.modelName = positiveModelName;
     result.capacitance = 0.0;
     result.triangleCount = 0;
+    result.sampledTriangles = 0;
     result.hitCount = 0;
     result.averageDistance = 0.0;
     
-    // Find the triangles for this model
-    auto triangleIt = positiveTriangles.find(positiveModelName);
-    if (triangleIt == positiveTriangles.end()) {
-        std::cerr << "No triangles found for model: " << positiveModelName << std::endl;
+    if (!ensureScenes()) {
         return result;
     }
     
-    // Find the corresponding scene
-    auto sceneIt = scenes.find(positiveModelName);
-    if (sceneIt == scenes.end()) {
-        std::cerr << "No scene found for model: " << positiveModelName << std::endl;
-        return result;
+    RayCapturePass capturePass(rayCapture);
+    
+    // Name lookup is only done at this API boundary
+    for (size_t slot = 0; slot < POSITIVE_MODEL_NAMES.size(); slot++) {
+        if (POSITIVE_MODEL_NAMES[slot] == positiveModelName) {
+            calculateSlotCapacitance(slot, result);
+            return result;
+        }
     }
     
-    const std::vector<Triangle>& triangles = triangleIt->second;
-    RTCScene scene = sceneIt->second;
+    std::cerr << "No triangles found for model: " << positiveModelName << std::endl;
+    return result;
+}
+
+void CapacitanceCalculator::calculateSlotCapacitance(size_t slot, CapacitanceResult& result, size_t sampleStride)
+{
+    FT_TRACE_SCOPE("rays", POSITIVE_MODEL_NAMES[slot], "stride", static_cast<int64_t>(sampleStride));
+    result.modelName = POSITIVE_MODEL_NAMES[slot];
+    result.capacitance = 0.0;
+    result.triangleCount = 0;
+    result.sampledTriangles = 0;
+    result.hitCount = 0;
+    result.averageDistance = 0.0;
     
-    result.triangleCount = triangles.size();
+    // Find the triangles for this model
+    if (slot >= positiveTriangles.size()) {
+        std::cerr << "No triangles found for model: " << POSITIVE_MODEL_NAMES[slot] << std::endl;
+        return;
+    }
+    
+    // Find the scene of the paired negative model
+    ModelId negativeId = pairedNegativeIds[slot];
+    RTCScene scene = acquireScene(negativeId);
+    if (!scene) {
+        std::cerr << "No scene found for model: " << POSITIVE_MODEL_NAMES[slot] << std::endl;
+        return;
+    }
+    
+    ModelId positiveId = positiveModelIds[slot];
+    const Model* model = getModel(positiveId);
+    size_t meshTriangles = model ? model->mesh->indices.size() / 3 : 0;
+    
+    // Positives whose transform changed since the last extraction (see refreshScenes): a full
+    // pass re-extracts them, a sampled pass transforms only the strided subset it traces
+    const std::vector<Triangle>* triangleSource = &positiveTriangles[slot];
+    size_t traceStride = sampleStride;
+    uint64_t version = transformManager->getModelTransformVersion(positiveId);
+    if (model && version != builtVersions[positiveId]) {
+        if (sampleStride == 1) {
+            extractTrianglesFromModel(*model, transformManager->getCombinedTransform(positiveId), positiveTriangles[slot]);
+            builtVersions[positiveId] = version;
+        } else {
+            extractTrianglesFromModel(*model, transformManager->getCombinedTransform(positiveId), sampledTriangles, sampleStride);
+            triangleSource = &sampledTriangles;
+            traceStride = 1;
+        }
+    }
+    const std::vector<Triangle>& triangles = *triangleSource;
+    
+    // Fields are kept for full passes only; a sampled pass would leave most triangles unset
+    TriangleFields* fields = nullptr;
+    if (recordTriangleFields && sampleStride == 1 && model) {
+        triangleFields.resize(POSITIVE_MODEL_NAMES.size());
+        fields = &triangleFields[slot];
+        fields->modelId = positiveModelIds[slot];
+        fields->contributions.assign(meshTriangles, -1.0f);
+        fields->hitDistances.assign(meshTriangles, -1.0f);
+    }
+    
+    // Captured rays are subsampled so every positive gets its share of the budget (two rays per triangle)
+    size_t captureStride = 1;
+    if (rayCapture) {
+        size_t slotBudget = std::max<size_t>(rayCapture->getBudget() / POSITIVE_MODEL_COUNT / 2, 1);
+        size_t tracedTriangles = (triangles.size() + traceStride - 1) / traceStride;
+        captureStride = std::max<size_t>((tracedTriangles + slotBudget - 1) / slotBudget, 1);
+    }
     
     double totalCapacitance = 0.0;
     double totalDistance = 0.0;
     size_t hitCount = 0;
+    size_t sampledCount = 0;
     
-    // Process each triangle
-    for (const Triangle& triangle : triangles) {
-        double contribution = shootRayAndCalculateContribution(triangle, scene);
+    // Process each triangle (or every sampleStride-th; mesh triangles are spatially sorted,
+    // so a strided subset covers the whole surface)
+    FT_PERF_REGION(PerfRegion::RayCast);
+    for (size_t t = 0; t < triangles.size(); t += traceStride) {
+        const Triangle& triangle = triangles[t];
+        RayCapture* capture = (rayCapture && sampledCount % captureStride == 0) ? rayCapture : nullptr;
+        sampledCount++;
+        float hitDistance = -1.0f;
+        double contribution = shootRayAndCalculateContribution(triangle, scene, hitDistance, capture);
         if (contribution > 0.0) {
             totalCapacitance += contribution;
+            totalDistance += hitDistance;
             hitCount++;
-            // Note: We'd need to modify shootRayAndCalculateContribution to return distance for averaging
+        }
+        
+        if (fields && triangle.primitive < fields->contributions.size()) {
+            fields->contributions[triangle.primitive] = contribution > 0.0 ? static_cast<float>(contribution * 1e15) : -1.0f;
+            fields->hitDistances[triangle.primitive] = hitDistance;
         }
     }
     
+    // Scale a sampled sum up to the full surface
+    if (sampleStride > 1 && sampledCount > 0) {
+        totalCapacitance *= static_cast<double>(meshTriangles) / sampledCount;
+    }
+    
+    FT_STAGE_COUNT(BulkCounter::Rays, sampledCount * 2);
+    FT_STAGE_COUNT(BulkCounter::Hits, hitCount);
+    
+    result.triangleCount = meshTriangles;
+    result.sampledTriangles = sampledCount;
     result.capacitance = totalCapacitance;
     result.hitCount = hitCount;
     result.averageDistance = hitCount > 0 ? totalDistance / hitCount : 0.0;
-    
-    return result;
+}
+
+void CapacitanceCalculator::setTriangleFieldRecording(bool enabled)
+{
+    recordTriangleFields = enabled;
+    if (!enabled) {
+        triangleFields.clear();
+    }
+}
+
+const std::vector<TriangleFields>& CapacitanceCalculator::getTriangleFields() const
+{
+    return triangleFields;
+}
+
+void CapacitanceCalculator::setRayCapture(RayCapture* capture)
+{
+    rayCapture = capture;
 }
 
 void CapacitanceCalculator::printResults(const std::vector<CapacitanceResult>& results) const
@@ -159,10 +403,10 @@ void CapacitanceCalculator::printResults(const std::vector<CapacitanceResult>& r
         
         std::cout << std::left << std::setw(12) << result.modelName << ": ";
         std::cout << std::fixed << std::setprecision(5) << std::setw(12) << capacitancePF << " pF";
-        std::cout << " (Hits: " << std::setw(4) << result.hitCount << "/" << std::setw(4) << result.triangleCount << ")";
+        std::cout << " (Hits: " << std::setw(4) << result.hitCount << "/" << std::setw(4) << result.sampledTriangles << ")";
         
-        if (result.triangleCount > 0) {
-            double hitRate = 100.0 * result.hitCount / result.triangleCount;
+        if (result.sampledTriangles > 0) {
+            double hitRate = 100.0 * result.hitCount / result.sampledTriangles;
             std::cout << " [" << std::fixed << std::setprecision(1) << hitRate << "%]";
         }
         
@@ -181,16 +425,33 @@ void CapacitanceCalculator::printResults(const std::vector<CapacitanceResult>& r
 
 bool CapacitanceCalculator::setupEmbreeDevice()
 {
-    device = rtcNewDevice(nullptr);
+    embreeConfig = getDefaultEmbreeConfig();
+    if (threadLimit > 0 && (embreeConfig.threads == 0 || embreeConfig.threads > threadLimit)) {
+        embreeConfig.threads = threadLimit;
+    }
+    std::string deviceString = embreeConfig.getDeviceString();
+    device = rtcNewDevice(deviceString.empty() ? nullptr : deviceString.c_str());
     if (!device) {
-        std::cerr << "Failed to create Embree device" << std::endl;
+        std::cerr << "Failed to create Embree device" << (deviceString.empty() ? "" : " (" + deviceString + ")") << std::endl;
         return false;
     }
     
-    // Set error handler
+    // Set error handler (allocations refused by the memory budget are handled by the build fallbacks)
     rtcSetDeviceErrorFunction(device, [](void* userPtr, RTCError error, const char* str) {
+        if (error == RTC_ERROR_OUT_OF_MEMORY && static_cast<EmbreeMemoryMonitor*>(userPtr)->getBudget() > 0) {
+            return;
+        }
         std::cerr << "Embree error " << error << ": " << str << std::endl;
-    }, nullptr);
+    }, &memoryMonitor);
+    
+    memoryMonitor.attach(device);
+    memoryMonitor.setBudget(embreeConfig.memoryBudgetBytes);
+    std::cout << "Embree device: " << (deviceString.empty() ? "defaults" : deviceString) << ", BVH "
+              << embreeConfig.describe();
+    if (memoryMonitor.getBudget() > 0) {
+        std::cout << ", memory budget " << memoryMonitor.getBudget() / (1024 * 1024) << " MB for this device";
+    }
+    std::cout << std::endl;
     
     return true;
 }
@@ -206,25 +467,74 @@ void CapacitanceCalculator::setupModelPairings()
     modelPairings["C2_model"] = "stationary_negative_C";
 }
 
-bool CapacitanceCalculator::extractTransformedGeometry()
+bool CapacitanceCalculator::resolveModelIds()
 {
-    // Extract positive model triangles
-    for (const std::string& modelName : POSITIVE_MODEL_NAMES) {
-        // Find the model
-        auto modelIt = std::find_if(allModels.begin(), allModels.end(),
-                                   [&modelName](const Model& m) { return m.name == modelName; });
+    // Model IDs equal their index in the model list (see ModelManager)
+    auto findModelId = [this](const std::string& name) {
+        for (const Model& model : allModels) {
+            if (model.name == name) return model.id;
+        }
+        return INVALID_MODEL_ID;
+    };
+    
+    positiveModelIds.assign(POSITIVE_MODEL_NAMES.size(), INVALID_MODEL_ID);
+    pairedNegativeIds.assign(POSITIVE_MODEL_NAMES.size(), INVALID_MODEL_ID);
+    negativeModelIds.clear();
+    
+    for (size_t slot = 0; slot < POSITIVE_MODEL_NAMES.size(); slot++) {
+        const std::string& modelName = POSITIVE_MODEL_NAMES[slot];
         
-        if (modelIt == allModels.end()) {
+        positiveModelIds[slot] = findModelId(modelName);
+        if (getModel(positiveModelIds[slot]) == nullptr) {
             std::cerr << "Model not found: " << modelName << std::endl;
             return false;
         }
         
-        // Get transformation matrix
-        glm::mat4 transform = transformManager->getCombinedTransform(modelName);
+        auto pairingIt = modelPairings.find(modelName);
+        ModelId negativeId = pairingIt != modelPairings.end() ? findModelId(pairingIt->second) : INVALID_MODEL_ID;
+        if (getModel(negativeId) == nullptr) {
+            std::cerr << "Negative model not found for: " << modelName << std::endl;
+            return false;
+        }
+        
+        pairedNegativeIds[slot] = negativeId;
+        if (std::find(negativeModelIds.begin(), negativeModelIds.end(), negativeId) == negativeModelIds.end()) {
+            negativeModelIds.push_back(negativeId);
+        }
+    }
+    
+    positiveTriangles.resize(POSITIVE_MODEL_NAMES.size());
+    scenes.assign(allModels.size(), nullptr);
+    negativeGeoms.assign(allModels.size(), nullptr);
+    builtVersions.assign(allModels.size(), UNBUILT_VERSION);
+    sceneMemory.assign(allModels.size(), SceneMemory());
+    
+    return true;
+}
+
+const Model* CapacitanceCalculator::getModel(ModelId id) const
+{
+    if (id >= allModels.size() || allModels[id].id != id) {
+        return nullptr;
+    }
+    return &allModels[id];
+}
+
+bool CapacitanceCalculator::extractTransformedGeometry()
+{
+    // Extract positive model triangles
+    for (size_t slot = 0; slot < positiveModelIds.size(); slot++) {
+        ModelId modelId = positiveModelIds[slot];
+        
+        // Skip models whose world matrix has not changed since the last extraction
+        uint64_t version = transformManager->getModelTransformVersion(modelId);
+        if (version == builtVersions[modelId]) {
+            continue;
+        }
         
-        // Extract triangles
-        std::vector<Triangle> triangles = extractTrianglesFromModel(*modelIt, transform);
-        positiveTriangles[modelName] = triangles;
+        // Extract triangles into this model's existing buffer
+        extractTrianglesFromModel(allModels[modelId], transformManager->getCombinedTransform(modelId), positiveTriangles[slot]);
+        builtVersions[modelId] = version;
     }
     
     return true;
@@ -232,103 +542,346 @@ bool CapacitanceCalculator::extractTransformedGeometry()
 
 bool CapacitanceCalculator::createEmbreeScenes()
 {
-    for (const auto& pairing : modelPairings) {
-        const std::string& positiveModel = pairing.first;
-        const std::string& negativeModel = pairing.second;
+    for (ModelId negativeId : negativeModelIds) {
+        // Positives paired with the same negative share its scene
+        if (negativeGeoms[negativeId] && (scenes[negativeId] || streamScenes)) {
+            continue;
+        }
         
-        // Create scene
-        RTCScene scene = rtcNewScene(device);
+        const Model& negativeModel = allModels[negativeId];
+        FT_TRACE_SCOPE("scene", negativeModel.name, "model", negativeId);
         
-        // Find negative model
-        auto negModelIt = std::find_if(allModels.begin(), allModels.end(),
-                                      [&negativeModel](const Model& m) { return m.name == negativeModel; });
+        if (!negativeGeoms[negativeId]) {
+            // Get transformation for negative model
+            const glm::mat4& negTransform = transformManager->getCombinedTransform(negativeId);
+            
+            // Create geometry for negative model; when its buffers do not fit, stream the scenes
+            int64_t bytesBefore = memoryMonitor.getCurrentBytes();
+            RTCGeometry geom = createEmbreeGeometry(negativeModel, negTransform);
+            if (!geom && !streamScenes && memoryMonitor.getBudget() > 0) {
+                streamScenes = true;
+                releaseEmbreeScenesExcept(INVALID_MODEL_ID);
+                bytesBefore = memoryMonitor.getCurrentBytes();
+                geom = createEmbreeGeometry(negativeModel, negTransform);
+            }
+            if (!geom) {
+                std::cerr << "Failed to create geometry for: " << negativeModel.name << std::endl;
+                return false;
+            }
+            
+            SceneMemory& memory = sceneMemory[negativeId];
+            memory.name = negativeModel.name;
+            memory.geometryBytes = static_cast<size_t>(std::max<int64_t>(memoryMonitor.getCurrentBytes() - bytesBefore, 0));
+            memory.dynamic = false;
+            negativeGeoms[negativeId] = geom;
+            builtVersions[negativeId] = transformManager->getModelTransformVersion(negativeId);
+        }
         
-        if (negModelIt == allModels.end()) {
-            std::cerr << "Negative model not found: " << negativeModel << std::endl;
+        // Streamed scenes are built when a calculation needs them
+        if (!streamScenes && !buildScene(negativeId)) {
             return false;
         }
+    }
+    
+    return true;
+}
+
+bool CapacitanceCalculator::updateEmbreeScenes()
+{
+    for (ModelId negativeId : negativeModelIds) {
+        if (!negativeGeoms[negativeId]) {
+            return createEmbreeScenes();
+        }
         
-        // Get transformation for negative model
-        glm::mat4 negTransform = transformManager->getCombinedTransform(negativeModel);
+        // Negatives are normally stationary: only rebuild when the transform actually moved
+        uint64_t version = transformManager->getModelTransformVersion(negativeId);
+        if (version == builtVersions[negativeId]) {
+            continue;
+        }
         
-        // Create geometry for negative model
-        RTCGeometry geom = createEmbreeGeometry(*negModelIt, negTransform);
-        if (!geom) {
-            std::cerr << "Failed to create geometry for: " << negativeModel << std::endl;
-            return false;
+        // The first pose change moves the scene to the dynamic build policy; refitting is
+        // set on the geometry before its vertices are committed
+        FT_TRACE_SCOPE("scene", allModels[negativeId].name, "model", negativeId);
+        bool becameDynamic = !sceneMemory[negativeId].dynamic;
+        if (becameDynamic) {
+            sceneMemory[negativeId].dynamic = true;
+            if (embreeConfig.dynamicQuality == RTC_BUILD_QUALITY_REFIT) {
+                rtcSetGeometryBuildQuality(negativeGeoms[negativeId], RTC_BUILD_QUALITY_REFIT);
+            }
         }
         
-        // Attach geometry to scene
-        rtcAttachGeometry(scene, geom);
-        rtcReleaseGeometry(geom);
+        // Rewrite vertices in place and recommit the owning scene (an evicted scene is rebuilt on use)
+        updateEmbreeGeometry(negativeGeoms[negativeId], allModels[negativeId], transformManager->getCombinedTransform(negativeId));
+        builtVersions[negativeId] = version;
+        if (!scenes[negativeId]) {
+            continue;
+        }
+        if (becameDynamic) {
+            // Scene flags and quality take effect on a new scene
+            releaseScene(negativeId);
+            if (!streamScenes && !buildScene(negativeId)) {
+                return false;
+            }
+            continue;
+        }
         
-        // Commit scene
+        rtcGetDeviceError(device);
+        {
+            FT_PERF_REGION(PerfRegion::BvhBuild);
+            rtcCommitScene(scenes[negativeId]);
+        }
+        if (rtcGetDeviceError(device) != RTC_ERROR_NONE) {
+            // The rebuild did not fit: start over with the fallbacks
+            releaseScene(negativeId);
+            if (!streamScenes && !buildScene(negativeId)) {
+                return false;
+            }
+        }
+    }
+    
+    return true;
+}
+
+bool CapacitanceCalculator::buildScene(ModelId negativeId)
+{
+    // Streaming keeps a single BVH: make room first
+    if (streamScenes) {
+        releaseEmbreeScenesExcept(negativeId);
+    }
+    
+    for (size_t level = 0; level < SCENE_BUILD_LEVELS; level++) {
+        if (commitScene(negativeId, getSceneBuildSettings(negativeId, level))) {
+            if (level > 0) {
+                fallbackBuilds++;
+            }
+            return true;
+        }
+    }
+    
+    // Last resort: stream the scenes and try again with only this one resident
+    if (!streamScenes && memoryMonitor.getBudget() > 0) {
+        std::cerr << "Embree scenes exceed the memory budget of " << memoryMonitor.getBudget() / (1024 * 1024)
+                  << " MB; building them one at a time" << std::endl;
+        streamScenes = true;
+        return buildScene(negativeId);
+    }
+    
+    std::cerr << "Scene for " << allModels[negativeId].name << " does not fit the Embree memory budget" << std::endl;
+    return false;
+}
+
+bool CapacitanceCalculator::commitScene(ModelId negativeId, const SceneBuildSettings& settings)
+{
+    int64_t bytesBefore = memoryMonitor.getCurrentBytes();
+    rtcGetDeviceError(device);  // Clear earlier errors; a failed commit is detected below
+    
+    RTCScene scene = rtcNewScene(device);
+    if (!scene) {
+        return false;
+    }
+    rtcSetSceneFlags(scene, settings.flags);
+    rtcSetSceneBuildQuality(scene, settings.quality);
+    
+    // Attach the geometry (the scene keeps its own reference) and build the BVH
+    rtcAttachGeometry(scene, negativeGeoms[negativeId]);
+    {
+        FT_PERF_REGION(PerfRegion::BvhBuild);
         rtcCommitScene(scene);
-        
-        scenes[positiveModel] = scene;
+    }
+    if (rtcGetDeviceError(device) != RTC_ERROR_NONE) {
+        rtcReleaseScene(scene);
+        return false;
     }
     
+    scenes[negativeId] = scene;
+    SceneMemory& memory = sceneMemory[negativeId];
+    memory.bvhBytes = static_cast<size_t>(std::max<int64_t>(memoryMonitor.getCurrentBytes() - bytesBefore, 0));
+    memory.quality = settings.quality;
+    memory.compact = (settings.flags & RTC_SCENE_FLAG_COMPACT) != 0;
+    memory.resident = true;
     return true;
 }
 
-std::vector<Triangle> CapacitanceCalculator::extractTrianglesFromModel(const Model& model, const glm::mat4& transform)
+void CapacitanceCalculator::releaseScene(ModelId negativeId)
+{
+    if (negativeId >= scenes.size() || !scenes[negativeId]) {
+        return;
+    }
+    
+    rtcReleaseScene(scenes[negativeId]);
+    scenes[negativeId] = nullptr;
+    sceneMemory[negativeId].bvhBytes = 0;
+    sceneMemory[negativeId].resident = false;
+}
+
+void CapacitanceCalculator::releaseEmbreeScenesExcept(ModelId keptId)
+{
+    for (ModelId negativeId : negativeModelIds) {
+        if (negativeId != keptId && scenes[negativeId]) {
+            releaseScene(negativeId);
+            sceneEvictions++;
+        }
+    }
+}
+
+RTCScene CapacitanceCalculator::acquireScene(ModelId negativeId)
 {
-    std::vector<Triangle> triangles;
+    if (negativeId >= scenes.size()) {
+        return nullptr;
+    }
+    if (!scenes[negativeId] && negativeGeoms[negativeId]) {
+        buildScene(negativeId);
+    }
+    return scenes[negativeId];
+}
+
+void CapacitanceCalculator::releaseEmbreeScenes()
+{
+    for (ModelId negativeId = 0; negativeId < scenes.size(); negativeId++) {
+        releaseScene(negativeId);
+    }
     
-    // Process triangles (assuming indices represent triangles)
-    for (size_t i = 0; i < model.indices.size(); i += 3) {
-        if (i + 2 >= model.indices.size()) break;
-        
+    for (size_t i = 0; i < negativeGeoms.size(); i++) {
+        if (negativeGeoms[i]) {
+            rtcReleaseGeometry(negativeGeoms[i]);
+            negativeGeoms[i] = nullptr;
+            sceneMemory[i].geometryBytes = 0;
+        }
+    }
+}
+
+CapacitanceCalculator::SceneBuildSettings CapacitanceCalculator::getSceneBuildSettings(ModelId negativeId, size_t level) const
+{
+    bool dynamic = sceneMemory[negativeId].dynamic;
+    RTCSceneFlags flags = embreeConfig.getSceneFlags(dynamic);
+    if (level == 0) {
+        return {embreeConfig.getSceneQuality(dynamic), flags};
+    }
+    
+    // Frugal fallback: trades trace speed for a smaller BVH
+    return {RTC_BUILD_QUALITY_LOW, static_cast<RTCSceneFlags>(flags | RTC_SCENE_FLAG_COMPACT)};
+}
+
+void CapacitanceCalculator::setDefaultEmbreeConfig(const EmbreeConfig& config)
+{
+    std::lock_guard<std::mutex> lock(defaultEmbreeConfigMutex);
+    defaultEmbreeConfig = config;
+}
+
+EmbreeConfig CapacitanceCalculator::getDefaultEmbreeConfig()
+{
+    std::lock_guard<std::mutex> lock(defaultEmbreeConfigMutex);
+    return defaultEmbreeConfig;
+}
+
+EmbreeMemoryStats CapacitanceCalculator::getMemoryStats() const
+{
+    EmbreeMemoryStats stats;
+    stats.budgetBytes = memoryMonitor.getBudget();
+    stats.currentBytes = static_cast<size_t>(std::max<int64_t>(memoryMonitor.getCurrentBytes(), 0));
+    stats.peakBytes = memoryMonitor.getPeakBytes();
+    stats.deniedAllocations = memoryMonitor.getDeniedAllocations();
+    stats.fallbackBuilds = fallbackBuilds;
+    stats.sceneEvictions = sceneEvictions;
+    stats.streamingScenes = streamScenes;
+    
+    for (const std::vector<Triangle>& triangles : positiveTriangles) {
+        stats.triangleBytes += triangles.capacity() * sizeof(Triangle);
+    }
+    // Negatives loaded from the same file share one mesh: it is charged to the first of them
+    std::vector<const MeshAsset*> chargedMeshes;
+    for (ModelId negativeId : negativeModelIds) {
+        if (negativeId < sceneMemory.size()) {
+            SceneMemory memory = sceneMemory[negativeId];
+            const MeshAsset* mesh = allModels[negativeId].mesh.get();
+            memory.meshBytes = 0;
+            if (mesh && std::find(chargedMeshes.begin(), chargedMeshes.end(), mesh) == chargedMeshes.end()) {
+                chargedMeshes.push_back(mesh);
+                memory.meshBytes = mesh->vertices.size() * sizeof(float) + mesh->indices.size() * sizeof(unsigned int);
+            }
+            stats.scenes.push_back(memory);
+        }
+    }
+    return stats;
+}
+
+void CapacitanceCalculator::extractTrianglesFromModel(const Model& model, const glm::mat4& transform, std::vector<Triangle>& triangles,
+                                                      size_t stride)
+{
+    const MeshAsset& mesh = *model.mesh;
+    bool hasPrecomputed = mesh.triangleAreas.size() * 3 == mesh.indices.size();
+    glm::mat3 rotation(transform);
+    
+    // Size once; later calls for the same model reuse the storage
+    triangles.resize((mesh.indices.size() / 3 + stride - 1) / stride);
+    size_t triangleCount = 0;
+    
+    // Process triangles (assuming indices represent triangles), or every stride-th
+    for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3 * stride) {
         // Get vertex indices
-        unsigned int idx0 = model.indices[i];
-        unsigned int idx1 = model.indices[i + 1];
-        unsigned int idx2 = model.indices[i + 2];
+        unsigned int idx0 = mesh.indices[i];
+        unsigned int idx1 = mesh.indices[i + 1];
+        unsigned int idx2 = mesh.indices[i + 2];
         
         // Get vertices (assuming 3 floats per vertex)
-        if ((idx0 + 1) * 3 > model.vertices.size() ||
-            (idx1 + 1) * 3 > model.vertices.size() ||
-            (idx2 + 1) * 3 > model.vertices.size()) {
+        if ((idx0 + 1) * 3 > mesh.vertices.size() ||
+            (idx1 + 1) * 3 > mesh.vertices.size() ||
+            (idx2 + 1) * 3 > mesh.vertices.size()) {
             continue; // Skip invalid indices
         }
         
-        glm::vec3 v0(model.vertices[idx0 * 3], model.vertices[idx0 * 3 + 1], model.vertices[idx0 * 3 + 2]);
-        glm::vec3 v1(model.vertices[idx1 * 3], model.vertices[idx1 * 3 + 1], model.vertices[idx1 * 3 + 2]);
-        glm::vec3 v2(model.vertices[idx2 * 3], model.vertices[idx2 * 3 + 1], model.vertices[idx2 * 3 + 2]);
+        glm::vec3 v0(mesh.vertices[idx0 * 3], mesh.vertices[idx0 * 3 + 1], mesh.vertices[idx0 * 3 + 2]);
+        glm::vec3 v1(mesh.vertices[idx1 * 3], mesh.vertices[idx1 * 3 + 1], mesh.vertices[idx1 * 3 + 2]);
+        glm::vec3 v2(mesh.vertices[idx2 * 3], mesh.vertices[idx2 * 3 + 1], mesh.vertices[idx2 * 3 + 2]);
         
         // Apply transformation
         v0 = applyTransform(v0, transform);
         v1 = applyTransform(v1, transform);
         v2 = applyTransform(v2, transform);
         
-        // Create triangle
-        Triangle triangle;
+        // Fill triangle
+        Triangle& triangle = triangles[triangleCount++];
         triangle.v0 = v0;
         triangle.v1 = v1;
         triangle.v2 = v2;
         triangle.center = (v0 + v1 + v2) / 3.0f;
-        triangle.normal = calculateTriangleNormal(v0, v1, v2);
-        triangle.area = calculateTriangleArea(v0, v1, v2);
+        triangle.primitive = static_cast<unsigned int>(i / 3);
         
-        triangles.push_back(triangle);
+        if (hasPrecomputed) {
+            // Group transforms are rigid: rotate the cached normal, the area is unchanged
+            size_t t = i / 3;
+            glm::vec3 normal(mesh.triangleNormals[t * 3], mesh.triangleNormals[t * 3 + 1], mesh.triangleNormals[t * 3 + 2]);
+            triangle.normal = rotation * normal;
+            triangle.area = mesh.triangleAreas[t];
+        } else {
+            triangle.normal = calculateTriangleNormal(v0, v1, v2);
+            triangle.area = calculateTriangleArea(v0, v1, v2);
+        }
     }
     
-    return triangles;
+    // Shrinking keeps the capacity, so the next refresh does not allocate
+    triangles.resize(triangleCount);
 }
 
 RTCGeometry CapacitanceCalculator::createEmbreeGeometry(const Model& model, const glm::mat4& transform)
 {
+    const MeshAsset& mesh = *model.mesh;
     RTCGeometry geom = rtcNewGeometry(device, RTC_GEOMETRY_TYPE_TRIANGLE);
     
     // Count valid triangles
-    size_t triangleCount = model.indices.size() / 3;
-    size_t vertexCount = model.vertices.size() / 3;
+    size_t triangleCount = mesh.indices.size() / 3;
+    size_t vertexCount = mesh.vertices.size() / 3;
     
-    // Allocate vertex buffer
+    // Allocate vertex buffer (null if the memory budget refused it)
     float* vertices = (float*)rtcSetNewGeometryBuffer(geom, RTC_BUFFER_TYPE_VERTEX, 0, RTC_FORMAT_FLOAT3, 3 * sizeof(float), vertexCount);
+    if (!vertices) {
+        rtcReleaseGeometry(geom);
+        return nullptr;
+    }
     
     // Copy and transform vertices
     for (size_t i = 0; i < vertexCount; i++) {
-        glm::vec3 v(model.vertices[i * 3], model.vertices[i * 3 + 1], model.vertices[i * 3 + 2]);
+        glm::vec3 v(mesh.vertices[i * 3], mesh.vertices[i * 3 + 1], mesh.vertices[i * 3 + 2]);
         v = applyTransform(v, transform);
         
         vertices[i * 3] = v.x;
@@ -338,20 +891,45 @@ RTCGeometry CapacitanceCalculator::createEmbreeGeometry(const Model& model, cons
     
     // Allocate index buffer
     unsigned int* indices = (unsigned int*)rtcSetNewGeometryBuffer(geom, RTC_BUFFER_TYPE_INDEX, 0, RTC_FORMAT_UINT3, 3 * sizeof(unsigned int), triangleCount);
+    if (!indices) {
+        rtcReleaseGeometry(geom);
+        return nullptr;
+    }
     
     // Copy indices
-    for (size_t i = 0; i < model.indices.size(); i++) {
-        indices[i] = model.indices[i];
+    for (size_t i = 0; i < mesh.indices.size(); i++) {
+        indices[i] = mesh.indices[i];
     }
     
     rtcCommitGeometry(geom);
     return geom;
 }
 
-double CapacitanceCalculator::shootRayAndCalculateContribution(const Triangle& triangle, RTCScene scene)
+void CapacitanceCalculator::updateEmbreeGeometry(RTCGeometry geom, const Model& model, const glm::mat4& transform)
+{
+    const MeshAsset& mesh = *model.mesh;
+    float* vertices = (float*)rtcGetGeometryBufferData(geom, RTC_BUFFER_TYPE_VERTEX, 0);
+    size_t vertexCount = mesh.vertices.size() / 3;
+    
+    for (size_t i = 0; i < vertexCount; i++) {
+        glm::vec3 v(mesh.vertices[i * 3], mesh.vertices[i * 3 + 1], mesh.vertices[i * 3 + 2]);
+        v = applyTransform(v, transform);
+        
+        vertices[i * 3] = v.x;
+        vertices[i * 3 + 1] = v.y;
+        vertices[i * 3 + 2] = v.z;
+    }
+    
+    rtcUpdateGeometryBuffer(geom, RTC_BUFFER_TYPE_VERTEX, 0);
+    rtcCommitGeometry(geom);
+}
+
+double CapacitanceCalculator::shootRayAndCalculateContribution(const Triangle& triangle, RTCScene scene, float& hitDistance,
+                                                                RayCapture* capture)
 {
     // Shoot ray in both directions along normal
     double totalContribution = 0.0;
+    hitDistance = -1.0f;
     
     for (int direction = -1; direction <= 1; direction += 2) { // -1 and +1
         RTCRayHit rayhit;
@@ -374,6 +952,9 @@ double CapacitanceCalculator::shootRayAndCalculateContribution(const Triangle& t
         // Check if we hit something
         if (rayhit.hit.geomID != RTC_INVALID_GEOMETRY_ID) {
             float distance = rayhit.ray.tfar; // Distance to hit point in mm
+            if (hitDistance < 0.0f || distance < hitDistance) {
+                hitDistance = distance;
+            }
             
             // Calculate capacitance contribution: C = ε₀ * εᵣ * A / d
             // Convert area from mm² to m²: multiply by 1e-6
@@ -386,6 +967,12 @@ double CapacitanceCalculator::shootRayAndCalculateContribution(const Triangle& t
                 totalContribution += contribution;
             }
         }
+        
+        if (capture) {
+            bool hit = rayhit.hit.geomID != RTC_INVALID_GEOMETRY_ID;
+            capture->record(triangle.center, triangle.normal * static_cast<float>(direction),
+                            hit ? rayhit.ray.tfar : -1.0f, MAX_RAY_DISTANCE);
+        }
     }
     
     return totalContribution;
@@ -416,30 +1003,35 @@ void CapacitanceCalculator::printModelInfo() const
 {
     std::cout << "\nModel Information:" << std::endl;
     std::cout << "Positive models: " << positiveTriangles.size() << std::endl;
-    for (const auto& pair : positiveTriangles) {
-        std::cout << "  " << pair.first << ": " << pair.second.size() << " triangles" << std::endl;
+    for (size_t slot = 0; slot < positiveTriangles.size(); slot++) {
+        std::cout << "  " << POSITIVE_MODEL_NAMES[slot] << ": " << positiveTriangles[slot].size() << " triangles" << std::endl;
     }
-    std::cout << "Embree scenes: " << scenes.size() << std::endl;
+    std::cout << "Embree scenes: " << negativeModelIds.size() << std::endl;
 }
 
 void CapacitanceCalculator::cleanup()
 {
-    // Release scenes
-    for (auto& pair : scenes) {
-        if (pair.second) {
-            rtcReleaseScene(pair.second);
-        }
-    }
-    scenes.clear();
+    // Release scenes and negative geometries
+    releaseEmbreeScenes();
+    scenesReady = false;
     
     // Release device
     if (device) {
         rtcReleaseDevice(device);
         device = nullptr;
     }
+    streamScenes = false;
+    fallbackBuilds = 0;
+    sceneEvictions = 0;
     
     // Clear data
     positiveTriangles.clear();
+    positiveModelIds.clear();
+    pairedNegativeIds.clear();
+    negativeModelIds.clear();
+    scenes.clear();
     negativeGeoms.clear();
+    sceneMemory.clear();
+    builtVersions.clear();
     modelPairings.clear();
 }
\ No newline at end of file
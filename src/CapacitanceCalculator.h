@@ -1,13 +1,19 @@
 #ifndef CAPACITANCECALCULATOR_H
 #define CAPACITANCECALCULATOR_H
 
+#include <atomic>
 #include <vector>
 #include <string>
 #include <map>
+#include <mutex>
 #include <glm/glm.hpp>
 #include <embree4/rtcore.h>
 #include "ModelManager.h"
 #include "Transform.h"
+#include "EmbreeConfig.h"
+#include "EmbreeMemory.h"
+
+class RayCapture;
 
 // Physical constants
 constexpr double EPSILON_0 = 8.854e-12; // F/m (vacuum permittivity)
@@ -18,7 +24,8 @@ constexpr float MAX_RAY_DISTANCE = 2.0f; // mm
 struct CapacitanceResult {
     std::string modelName;
     double capacitance;           // Farads
-    size_t triangleCount;         // Number of triangles processed
+    size_t triangleCount;         // Number of triangles in the positive mesh
+    size_t sampledTriangles;      // Number of triangles traced (fewer than triangleCount in a sampled pass)
     size_t hitCount;             // Number of successful ray hits
     double averageDistance;       // Average hit distance in mm
 };
@@ -29,6 +36,15 @@ struct Triangle {
     glm::vec3 center;            // Triangle center
     glm::vec3 normal;            // Surface normal
     float area;                  // Triangle area
+    unsigned int primitive;      // Index of the source mesh triangle
+};
+
+// Per-triangle values of one positive model from its last full calculation, in mesh triangle
+// order (the gl_PrimitiveID of the rendered mesh); -1 for triangles whose rays missed
+struct TriangleFields {
+    ModelId modelId = INVALID_MODEL_ID;
+    std::vector<float> contributions;   // fF
+    std::vector<float> hitDistances;    // mm, nearest of the two ray directions
 };
 
 class CapacitanceCalculator
@@ -43,6 +59,23 @@ public:
     // Calculate capacitance for all 6 positive models
     std::vector<CapacitanceResult> calculateCapacitances();
 
+    // Calculate capacitance for all 6 positive models into a reusable buffer
+    // (does not allocate once the buffer has been sized by a previous call)
+    void calculateCapacitances(std::vector<CapacitanceResult>& results);
+
+    // Progressive variant: with maxSamplesPerModel > 0, only an evenly strided subset of each
+    // positive's triangles is traced and the sum is scaled up (a coarse estimate). Returns false,
+    // leaving partial results, if abort becomes true between models.
+    bool calculateCapacitances(std::vector<CapacitanceResult>& results, size_t maxSamplesPerModel,
+                               const std::atomic<bool>* abort);
+
+    // Keep per-triangle contributions and hit distances of full (unsampled) calculations
+    void setTriangleFieldRecording(bool enabled);
+    const std::vector<TriangleFields>& getTriangleFields() const;
+
+    // Debug: record a subsample of the traced rays into a capture (nullptr disables)
+    void setRayCapture(RayCapture* capture);
+
     // Calculate capacitance for a specific positive model
     CapacitanceResult calculateSingleCapacitance(const std::string& positiveModelName);
 
@@ -52,18 +85,86 @@ public:
     // Refresh geometry with current transformations
     void refreshGeometry();
 
+    // Update only the scenes of negatives whose transforms changed. Stale positives are then
+    // re-extracted by the next calculation; a sampled one transforms just the triangles it traces.
+    void refreshScenes();
+
+    // Cap the Embree worker threads of this calculator's device (0: as configured); call before
+    // initialize. Background calculators use it to leave cores to the viewer.
+    void setThreadLimit(unsigned int threads);
+
+    // Pick up replaced meshes (e.g. after a live reload): re-extracts the affected
+    // positives and rebuilds the scenes of affected negatives
+    void updateModelMeshes(const std::vector<Model>& models, const std::vector<ModelId>& changedModels);
+
+    // Switch to another transform manager, e.g. the live one after building from a snapshot copy.
+    // Geometry whose world matrix is the same in both managers is not rebuilt.
+    void setTransformManager(TransformManager& transforms);
+
+    // Bumped whenever model geometry changes; results computed before a change are stale
+    uint64_t getGeometryVersion() const;
+
+    // Extract geometry and build the Embree scenes if that has not happened yet.
+    // Called lazily by the calculation functions, so startup does not pay for BVH builds.
+    bool ensureScenes();
+
+    // Embree device and build policy for calculators initialized afterwards. Each calculator
+    // owns a device and applies the configuration (including the memory budget) to it.
+    static void setDefaultEmbreeConfig(const EmbreeConfig& config);
+    static EmbreeConfig getDefaultEmbreeConfig();
+
+    // BVH, geometry-buffer and model memory per scene, plus device totals
+    EmbreeMemoryStats getMemoryStats() const;
+
     // Cleanup resources
     void cleanup();
 
 private:
-    // Embree objects
+    // Embree objects, indexed by ModelId (null for models that are not negatives)
     RTCDevice device;
-    std::map<std::string, RTCScene> scenes;           // One scene per positive-negative pair
-    std::map<std::string, RTCGeometry> negativeGeoms; // Negative geometries
-
-    // Processed model data
-    std::map<std::string, std::vector<Triangle>> positiveTriangles;
-    std::map<std::string, std::string> modelPairings; // positive -> negative mapping
+    bool scenesReady;                          // Geometry extracted and scenes built
+    uint64_t geometryVersion;
+    std::vector<RTCScene> scenes;              // One scene per negative model (shared by its positives)
+    std::vector<RTCGeometry> negativeGeoms;    // Negative geometries
+
+    // Memory accounting, indexed by ModelId like the scenes. When a build does not fit the
+    // budget it is retried with the frugal settings; if that fails too, scenes are streamed:
+    // only the scene in use keeps its BVH and the others are rebuilt when next needed.
+    EmbreeMemoryMonitor memoryMonitor;
+    std::vector<SceneMemory> sceneMemory;
+    bool streamScenes;
+    size_t fallbackBuilds;
+    size_t sceneEvictions;
+    EmbreeConfig embreeConfig;
+    unsigned int threadLimit;
+    static EmbreeConfig defaultEmbreeConfig;
+    static std::mutex defaultEmbreeConfigMutex;
+
+    // Scene build settings; level 0 is the configured policy, level 1 the frugal fallback
+    struct SceneBuildSettings {
+        RTCBuildQuality quality;
+        RTCSceneFlags flags;
+    };
+    static constexpr size_t SCENE_BUILD_LEVELS = 2;
+    SceneBuildSettings getSceneBuildSettings(ModelId negativeId, size_t level) const;
+
+    // Transform version each model's geometry was last built from, indexed by ModelId
+    std::vector<uint64_t> builtVersions;
+    static constexpr uint64_t UNBUILT_VERSION = ~uint64_t(0);
+
+    // Processed model data, indexed by positive slot (POSITIVE_MODEL_NAMES order)
+    std::vector<std::vector<Triangle>> positiveTriangles;
+    std::vector<Triangle> sampledTriangles;   // Strided subset of a stale positive in a sampled pass
+    std::vector<ModelId> positiveModelIds;
+    std::vector<ModelId> pairedNegativeIds;   // positive slot -> negative model ID
+    std::vector<ModelId> negativeModelIds;    // Unique negative models
+    std::map<std::string, std::string> modelPairings; // positive -> negative mapping (names, resolved at init)
+    
+    // Per-slot triangle fields, filled only while recording is enabled
+    bool recordTriangleFields;
+    std::vector<TriangleFields> triangleFields;
+    
+    RayCapture* rayCapture;
 
     // Model data storage
     std::vector<Model> allModels;
@@ -73,15 +174,27 @@ private:
     bool setupEmbreeDevice();
     bool extractTransformedGeometry();
     bool createEmbreeScenes();
+    bool updateEmbreeScenes();
+    void releaseEmbreeScenes();
+    bool buildScene(ModelId negativeId);
+    bool commitScene(ModelId negativeId, const SceneBuildSettings& settings);
+    void releaseScene(ModelId negativeId);
+    void releaseEmbreeScenesExcept(ModelId keptId);
+    RTCScene acquireScene(ModelId negativeId);
     void setupModelPairings();
+    bool resolveModelIds();
+    const Model* getModel(ModelId id) const;
 
-    // Geometry processing
-    std::vector<Triangle> extractTrianglesFromModel(const Model& model, const glm::mat4& transform);
+    // Geometry processing (fills the output in place so its storage is reused)
+    void extractTrianglesFromModel(const Model& model, const glm::mat4& transform, std::vector<Triangle>& triangles,
+                                   size_t stride = 1);
     RTCGeometry createEmbreeGeometry(const Model& model, const glm::mat4& transform);
+    void updateEmbreeGeometry(RTCGeometry geom, const Model& model, const glm::mat4& transform);
 
     // Ray shooting and calculation
-    CapacitanceResult calculateModelCapacitance(const std::string& positiveModelName);
-    double shootRayAndCalculateContribution(const Triangle& triangle, RTCScene scene);
+    void calculateSlotCapacitance(size_t slot, CapacitanceResult& result, size_t sampleStride = 1);
+    double shootRayAndCalculateContribution(const Triangle& triangle, RTCScene scene, float& hitDistance,
+                                            RayCapture* capture = nullptr);
     
     // Utility functions
     glm::vec3 calculateTriangleNormal(const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2);
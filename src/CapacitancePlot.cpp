@@ -0,0 +1,444 @@
+#include "CapacitancePlot.h"
+#include <glad/glad.h>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <iterator>
+#include <limits>
+
+namespace {
+
+const char* PLOT_VERTEX_SHADER = R"(#version 330 core
+layout (location = 0) in vec2 aPos;
+
+uniform vec4 range;   // xMin, xMax, yMin, yMax
+
+void main()
+{
+    vec2 ndc = (aPos - range.xz) / (range.yw - range.xz) * 2.0 - 1.0;
+    gl_Position = vec4(ndc, 0.0, 1.0);
+}
+)";
+
+const char* PLOT_FRAGMENT_SHADER = R"(#version 330 core
+out vec4 FragColor;
+
+uniform vec4 color;
+
+void main()
+{
+    FragColor = color;
+}
+)";
+
+// A1, A2, B1, B2, C1, C2, total
+const float CHANNEL_COLORS[][3] = {
+    {1.0f, 0.35f, 0.35f}, {1.0f, 0.65f, 0.3f},
+    {0.35f, 0.85f, 0.35f}, {0.3f, 0.85f, 0.85f},
+    {0.45f, 0.55f, 1.0f}, {0.85f, 0.45f, 1.0f},
+    {1.0f, 1.0f, 1.0f}
+};
+
+const size_t UNIT_QUAD_FIRST = 0;
+const size_t UNIT_QUAD_COUNT = 6;
+const size_t UNIT_LINE_FIRST = 6;
+const size_t UNIT_LINE_COUNT = 2;
+
+unsigned int compilePlotShader(const char* source, unsigned int type)
+{
+    unsigned int shader = glCreateShader(type);
+    glShaderSource(shader, 1, &source, NULL);
+    glCompileShader(shader);
+    
+    int success;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+    if (!success) {
+        char infoLog[1024];
+        glGetShaderInfoLog(shader, 1024, NULL, infoLog);
+        std::cerr << "Plot shader compilation error: " << infoLog << std::endl;
+        glDeleteShader(shader);
+        return 0;
+    }
+    return shader;
+}
+
+} // namespace
+
+CapacitancePlot::CapacitancePlot() : shaderProgram(0), VAO(0), VBO(0), rangeLoc(-1), colorLoc(-1),
+                                     rowCount(0), viewStart(0.0), viewEnd(0.0), cursorRow(0),
+                                     channelFirst(), channelCount(), valueMin(0.0f), valueMax(1.0f),
+                                     builtForWidth(0), viewDirty(false)
+{
+}
+
+CapacitancePlot::~CapacitancePlot()
+{
+    cleanup();
+}
+
+bool CapacitancePlot::initialize()
+{
+    unsigned int vertexShader = compilePlotShader(PLOT_VERTEX_SHADER, GL_VERTEX_SHADER);
+    unsigned int fragmentShader = compilePlotShader(PLOT_FRAGMENT_SHADER, GL_FRAGMENT_SHADER);
+    if (vertexShader == 0 || fragmentShader == 0) {
+        return false;
+    }
+    
+    shaderProgram = glCreateProgram();
+    glAttachShader(shaderProgram, vertexShader);
+    glAttachShader(shaderProgram, fragmentShader);
+    glLinkProgram(shaderProgram);
+    glDeleteShader(vertexShader);
+    glDeleteShader(fragmentShader);
+    
+    int success;
+    glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success);
+    if (!success) {
+        char infoLog[1024];
+        glGetProgramInfoLog(shaderProgram, 1024, NULL, infoLog);
+        std::cerr << "Plot program linking error: " << infoLog << std::endl;
+        return false;
+    }
+    
+    rangeLoc = glGetUniformLocation(shaderProgram, "range");
+    colorLoc = glGetUniformLocation(shaderProgram, "color");
+    
+    glGenVertexArrays(1, &VAO);
+    glGenBuffers(1, &VBO);
+    glBindVertexArray(VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    
+    return true;
+}
+
+void CapacitancePlot::cleanup()
+{
+    if (VAO != 0) {
+        glDeleteVertexArrays(1, &VAO);
+        VAO = 0;
+    }
+    if (VBO != 0) {
+        glDeleteBuffers(1, &VBO);
+        VBO = 0;
+    }
+    if (shaderProgram != 0) {
+        glDeleteProgram(shaderProgram);
+        shaderProgram = 0;
+    }
+}
+
+bool CapacitancePlot::load(const RunFile& runFile)
+{
+    clear();
+    if (!runFile.isOpen() || runFile.getRowCount() == 0) {
+        return false;
+    }
+    
+    rowCount = runFile.getRowCount();
+    const float missing = std::numeric_limits<float>::quiet_NaN();
+    
+    // Level 0: the rows themselves
+    Level base;
+    base.bucketRows = 1;
+    base.bucketCount = rowCount;
+    base.minValues.assign(CHANNEL_COUNT * rowCount, missing);
+    for (size_t row = 0; row < rowCount; row++) {
+        RunRecord record = runFile.getRecord(row);
+        if (!(record.flags & RUN_ROW_COMPUTED)) {
+            continue;
+        }
+        
+        double totalPF = 0.0;
+        for (size_t channel = 0; channel < RUN_CAPACITANCE_COLUMNS; channel++) {
+            double capacitancePF = record.capacitances[channel] * 1e12;
+            base.minValues[channel * rowCount + row] = static_cast<float>(capacitancePF);
+            totalPF += capacitancePF;
+        }
+        base.minValues[RUN_CAPACITANCE_COLUMNS * rowCount + row] = static_cast<float>(totalPF);
+    }
+    levels.push_back(std::move(base));
+    
+    // Coarser levels reduce PYRAMID_FACTOR buckets of the previous level each (NaN-aware)
+    while (levels.back().bucketCount > 1) {
+        const Level& fine = levels.back();
+        Level coarse;
+        coarse.bucketRows = fine.bucketRows * PYRAMID_FACTOR;
+        coarse.bucketCount = (fine.bucketCount + PYRAMID_FACTOR - 1) / PYRAMID_FACTOR;
+        coarse.minValues.assign(CHANNEL_COUNT * coarse.bucketCount, missing);
+        coarse.maxValues.assign(CHANNEL_COUNT * coarse.bucketCount, missing);
+        
+        for (size_t channel = 0; channel < CHANNEL_COUNT; channel++) {
+            for (size_t bucket = 0; bucket < coarse.bucketCount; bucket++) {
+                float low = missing;
+                float high = missing;
+                size_t first = bucket * PYRAMID_FACTOR;
+                size_t last = std::min(first + PYRAMID_FACTOR, fine.bucketCount);
+                for (size_t i = first; i < last; i++) {
+                    size_t index = channel * fine.bucketCount + i;
+                    float fineMin = fine.minValues[index];
+                    if (std::isnan(fineMin)) {
+                        continue;
+                    }
+                    float fineMax = getMax(fine, index);
+                    low = std::isnan(low) ? fineMin : std::min(low, fineMin);
+                    high = std::isnan(high) ? fineMax : std::max(high, fineMax);
+                }
+                coarse.minValues[channel * coarse.bucketCount + bucket] = low;
+                coarse.maxValues[channel * coarse.bucketCount + bucket] = high;
+            }
+        }
+        levels.push_back(std::move(coarse));
+    }
+    
+    std::cout << "Capacitance plot: " << rowCount << " rows, " << runFile.getComputedRowCount() 
+              << " computed, " << levels.size() << " pyramid levels" << std::endl;
+    
+    resetView();
+    return true;
+}
+
+void CapacitancePlot::clear()
+{
+    levels.clear();
+    rowCount = 0;
+    viewStart = 0.0;
+    viewEnd = 0.0;
+    vertices.clear();
+    viewDirty = true;
+}
+
+bool CapacitancePlot::hasData() const
+{
+    return rowCount > 0;
+}
+
+void CapacitancePlot::setCursorRow(size_t row)
+{
+    cursorRow = row;
+}
+
+bool CapacitancePlot::containsPoint(double x, double y, int viewportWidth, int viewportHeight) const
+{
+    if (!hasData()) {
+        return false;
+    }
+    
+    float left, top, width, height;
+    getPanelRect(viewportWidth, viewportHeight, left, top, width, height);
+    return x >= left && x < left + width && y >= top && y < top + height;
+}
+
+size_t CapacitancePlot::getRowAt(double x, int viewportWidth) const
+{
+    float left, top, width, height;
+    getPanelRect(viewportWidth, 0, left, top, width, height);
+    
+    double fraction = std::max(0.0, std::min(1.0, (x - left) / width));
+    double row = std::floor(viewStart + fraction * (viewEnd - viewStart));
+    return static_cast<size_t>(std::max(0.0, std::min(row, static_cast<double>(rowCount - 1))));
+}
+
+void CapacitancePlot::zoom(double x, int viewportWidth, double steps)
+{
+    float left, top, width, height;
+    getPanelRect(viewportWidth, 0, left, top, width, height);
+    
+    // Keep the row under the cursor in place
+    double fraction = std::max(0.0, std::min(1.0, (x - left) / width));
+    double anchorRow = viewStart + fraction * (viewEnd - viewStart);
+    double span = (viewEnd - viewStart) * std::pow(0.8, steps);
+    span = std::max(static_cast<double>(MIN_VISIBLE_ROWS), std::min(span, static_cast<double>(rowCount)));
+    
+    viewStart = anchorRow - fraction * span;
+    viewEnd = viewStart + span;
+    clampView();
+}
+
+void CapacitancePlot::pan(double deltaX, int viewportWidth)
+{
+    float left, top, width, height;
+    getPanelRect(viewportWidth, 0, left, top, width, height);
+    
+    double rows = -deltaX / width * (viewEnd - viewStart);
+    viewStart += rows;
+    viewEnd += rows;
+    clampView();
+}
+
+void CapacitancePlot::resetView()
+{
+    viewStart = 0.0;
+    viewEnd = static_cast<double>(rowCount);
+    viewDirty = true;
+}
+
+void CapacitancePlot::render(int viewportWidth, int viewportHeight)
+{
+    if (shaderProgram == 0 || !hasData() || viewportWidth <= 0 || viewportHeight <= 0) {
+        return;
+    }
+    
+    float left, top, width, height;
+    getPanelRect(viewportWidth, viewportHeight, left, top, width, height);
+    if (width < 1.0f || height < 1.0f) {
+        return;
+    }
+    
+    glBindVertexArray(VAO);
+    if (viewDirty || builtForWidth != static_cast<int>(width)) {
+        buildVertices(static_cast<int>(width));
+        
+        // Orphan the previous contents; the driver streams the new view in
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), nullptr, GL_STREAM_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, vertices.size() * sizeof(float), vertices.data());
+    }
+    
+    // Draw into the panel only (GL viewport origin is bottom-left)
+    glViewport(static_cast<int>(left), static_cast<int>(viewportHeight - top - height),
+               static_cast<int>(width), static_cast<int>(height));
+    glUseProgram(shaderProgram);
+    glDisable(GL_DEPTH_TEST);
+    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    
+    glUniform4f(rangeLoc, 0.0f, 1.0f, 0.0f, 1.0f);
+    glUniform4f(colorLoc, 0.0f, 0.0f, 0.0f, 0.6f);
+    glDrawArrays(GL_TRIANGLES, UNIT_QUAD_FIRST, UNIT_QUAD_COUNT);
+    
+    glUniform4f(rangeLoc, static_cast<float>(viewStart), static_cast<float>(viewEnd), valueMin, valueMax);
+    for (size_t channel = 0; channel < CHANNEL_COUNT; channel++) {
+        if (channelCount[channel] == 0) {
+            continue;
+        }
+        const float* rgb = CHANNEL_COLORS[channel];
+        glUniform4f(colorLoc, rgb[0], rgb[1], rgb[2], 1.0f);
+        glDrawArrays(GL_LINES, static_cast<int>(channelFirst[channel]), static_cast<int>(channelCount[channel]));
+    }
+    
+    // Cursor: the unit line moved to the cursor row
+    double cursorX = cursorRow + 0.5;
+    if (cursorX >= viewStart && cursorX <= viewEnd) {
+        glUniform4f(rangeLoc, static_cast<float>(viewStart - cursorX), static_cast<float>(viewEnd - cursorX), 0.0f, 1.0f);
+        glUniform4f(colorLoc, 1.0f, 1.0f, 0.0f, 0.8f);
+        glDrawArrays(GL_LINES, UNIT_LINE_FIRST, UNIT_LINE_COUNT);
+    }
+    
+    glDisable(GL_BLEND);
+    glEnable(GL_DEPTH_TEST);
+    glViewport(0, 0, viewportWidth, viewportHeight);
+    glBindVertexArray(0);
+}
+
+void CapacitancePlot::getPanelRect(int viewportWidth, int viewportHeight, float& left, float& top,
+                                   float& width, float& height) const
+{
+    // Full width along the bottom of the viewport
+    left = MARGIN;
+    width = std::max(0.0f, viewportWidth - 2.0f * MARGIN);
+    height = viewportHeight * PANEL_HEIGHT_FRACTION;
+    top = viewportHeight - MARGIN - height;
+}
+
+void CapacitancePlot::clampView()
+{
+    double span = viewEnd - viewStart;
+    if (viewStart < 0.0) {
+        viewStart = 0.0;
+    }
+    if (viewStart + span > rowCount) {
+        viewStart = std::max(0.0, rowCount - span);
+    }
+    viewEnd = std::min(viewStart + span, static_cast<double>(rowCount));
+    viewDirty = true;
+}
+
+void CapacitancePlot::buildVertices(int panelWidth)
+{
+    vertices.clear();
+    builtForWidth = panelWidth;
+    viewDirty = false;
+    
+    // Unit quad and unit vertical line
+    const float unitGeometry[] = {
+        0.0f, 0.0f,  1.0f, 0.0f,  1.0f, 1.0f,
+        0.0f, 0.0f,  1.0f, 1.0f,  0.0f, 1.0f,
+        0.0f, 0.0f,  0.0f, 1.0f
+    };
+    vertices.insert(vertices.end(), std::begin(unitGeometry), std::end(unitGeometry));
+    
+    // Finest level that keeps the visible buckets within budget (about two per pixel column)
+    size_t maxBuckets = std::min(MAX_POINTS_PER_CHANNEL, static_cast<size_t>(std::max(panelWidth, 1)) * 2);
+    double span = viewEnd - viewStart;
+    size_t levelIndex = 0;
+    while (levelIndex + 1 < levels.size() && span / levels[levelIndex].bucketRows > maxBuckets) {
+        levelIndex++;
+    }
+    const Level& level = levels[levelIndex];
+    
+    size_t firstBucket = static_cast<size_t>(std::max(0.0, viewStart) / level.bucketRows);
+    size_t endBucket = std::min(level.bucketCount, static_cast<size_t>(std::ceil(viewEnd / level.bucketRows)) + 1);
+    
+    // Shared value axis over the visible buckets of every channel
+    float low = std::numeric_limits<float>::max();
+    float high = std::numeric_limits<float>::lowest();
+    for (size_t channel = 0; channel < CHANNEL_COUNT; channel++) {
+        for (size_t bucket = firstBucket; bucket < endBucket; bucket++) {
+            size_t index = channel * level.bucketCount + bucket;
+            if (!std::isnan(level.minValues[index])) {
+                low = std::min(low, level.minValues[index]);
+                high = std::max(high, getMax(level, index));
+            }
+        }
+    }
+    if (low > high) {
+        low = 0.0f;
+        high = 1.0f;
+    }
+    float padding = std::max((high - low) * 0.05f, 1e-6f);
+    valueMin = low - padding;
+    valueMax = high + padding;
+    
+    // Per bucket: its min-max extent, and a segment joining its midpoint to the previous bucket's
+    for (size_t channel = 0; channel < CHANNEL_COUNT; channel++) {
+        channelFirst[channel] = vertices.size() / 2;
+        bool havePrevious = false;
+        float previousX = 0.0f;
+        float previousMid = 0.0f;
+        
+        for (size_t bucket = firstBucket; bucket < endBucket; bucket++) {
+            size_t index = channel * level.bucketCount + bucket;
+            float bucketMin = level.minValues[index];
+            if (std::isnan(bucketMin)) {
+                havePrevious = false;
+                continue;
+            }
+            float bucketMax = getMax(level, index);
+            float x = (bucket + 0.5f) * level.bucketRows;
+            float mid = 0.5f * (bucketMin + bucketMax);
+            
+            if (bucketMax > bucketMin) {
+                float extent[] = {x, bucketMin, x, bucketMax};
+                vertices.insert(vertices.end(), std::begin(extent), std::end(extent));
+            }
+            if (havePrevious) {
+                float join[] = {previousX, previousMid, x, mid};
+                vertices.insert(vertices.end(), std::begin(join), std::end(join));
+            }
+            havePrevious = true;
+            previousX = x;
+            previousMid = mid;
+        }
+        channelCount[channel] = vertices.size() / 2 - channelFirst[channel];
+    }
+}
+
+float CapacitancePlot::getMax(const Level& level, size_t index) const
+{
+    return level.maxValues.empty() ? level.minValues[index] : level.maxValues[index];
+}
@@ -0,0 +1,80 @@
+#ifndef CAPACITANCEPLOT_H
+#define CAPACITANCEPLOT_H
+
+#include <cstddef>
+#include <vector>
+#include "RunFile.h"
+
+// Time-series panel of a bulk run's capacitances (six electrodes plus the total) along the
+// bottom of the viewport. Values are kept in a min/max decimation pyramid, so any zoom level
+// draws at most MAX_POINTS_PER_CHANNEL buckets per channel; the line vertices are rebuilt
+// into a streamed buffer only when the view or the data changes.
+class CapacitancePlot
+{
+public:
+    CapacitancePlot();
+    ~CapacitancePlot();
+
+    bool initialize();
+    void cleanup();
+
+    // Build the pyramid from a run file's computed rows (uncomputed rows leave gaps)
+    bool load(const RunFile& runFile);
+    void clear();
+    bool hasData() const;
+
+    // Row marked by the cursor line (the step mode row)
+    void setCursorRow(size_t row);
+
+    // Interaction; positions in framebuffer pixels, origin top-left
+    bool containsPoint(double x, double y, int viewportWidth, int viewportHeight) const;
+    size_t getRowAt(double x, int viewportWidth) const;
+    void zoom(double x, int viewportWidth, double steps);   // Positive steps zoom in around x
+    void pan(double deltaX, int viewportWidth);
+    void resetView();
+
+    void render(int viewportWidth, int viewportHeight);
+
+private:
+    static constexpr size_t CHANNEL_COUNT = RUN_CAPACITANCE_COLUMNS + 1;   // Electrodes, then the total
+    static constexpr size_t PYRAMID_FACTOR = 4;             // Rows per bucket grow by this per level
+    static constexpr size_t MAX_POINTS_PER_CHANNEL = 4096;
+    static constexpr size_t MIN_VISIBLE_ROWS = 16;
+    static constexpr float PANEL_HEIGHT_FRACTION = 0.3f;
+    static constexpr float MARGIN = 10.0f;                  // Pixels around the panel
+
+    // One pyramid level; values are channel-major (channel * bucketCount + bucket), in pF,
+    // NaN where a bucket has no computed rows. Level 0 holds the rows themselves (max == min).
+    struct Level {
+        size_t bucketRows = 1;
+        size_t bucketCount = 0;
+        std::vector<float> minValues;
+        std::vector<float> maxValues;
+    };
+
+    unsigned int shaderProgram;
+    unsigned int VAO, VBO;
+    int rangeLoc;
+    int colorLoc;
+
+    std::vector<Level> levels;
+    size_t rowCount;
+    double viewStart, viewEnd;   // Visible rows [viewStart, viewEnd)
+    size_t cursorRow;
+
+    // Vertices of the current view: a unit quad and a unit vertical line (background and cursor,
+    // placed through the range uniform), then each channel's line segments in (row, pF)
+    std::vector<float> vertices;
+    size_t channelFirst[CHANNEL_COUNT];
+    size_t channelCount[CHANNEL_COUNT];
+    float valueMin, valueMax;
+    int builtForWidth;
+    bool viewDirty;
+
+    void getPanelRect(int viewportWidth, int viewportHeight, float& left, float& top, float& width, float& height) const;
+    void clampView();
+    void buildVertices(int panelWidth);
+    float getMax(const Level& level, size_t index) const;
+};
+
+#endif
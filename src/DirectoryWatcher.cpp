@@ -0,0 +1,181 @@
+#include "DirectoryWatcher.h"
+#include <iostream>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+DirectoryWatcher::DirectoryWatcher()
+    : watching(false), inotifyDescriptor(-1), watchDescriptor(-1)
+{
+}
+
+DirectoryWatcher::~DirectoryWatcher()
+{
+    stop();
+}
+
+bool DirectoryWatcher::start(const std::string& directory)
+{
+    stop();
+    
+    std::error_code error;
+    if (!std::filesystem::is_directory(directory, error)) {
+        std::cerr << "Cannot watch missing directory: " << directory << std::endl;
+        return false;
+    }
+    
+    watchedDirectory = directory;
+    watching = true;
+    
+    if (startInotify()) {
+        std::cout << "Watching " << directory << " for changes (inotify)" << std::endl;
+        return true;
+    }
+    
+    // Fallback: remember the current state and compare against it periodically
+    scanTimestamps(nullptr);
+    lastScan = std::chrono::steady_clock::now();
+    std::cout << "Watching " << directory << " for changes (polling)" << std::endl;
+    return true;
+}
+
+void DirectoryWatcher::stop()
+{
+#ifdef __linux__
+    if (inotifyDescriptor >= 0) {
+        if (watchDescriptor >= 0) {
+            inotify_rm_watch(inotifyDescriptor, watchDescriptor);
+        }
+        close(inotifyDescriptor);
+    }
+#endif
+    inotifyDescriptor = -1;
+    watchDescriptor = -1;
+    fileStamps.clear();
+    watching = false;
+}
+
+bool DirectoryWatcher::poll(std::vector<std::string>& changedFiles)
+{
+    if (!watching) {
+        return false;
+    }
+    
+    return inotifyDescriptor >= 0 ? pollInotify(changedFiles) : pollTimestamps(changedFiles);
+}
+
+bool DirectoryWatcher::isWatching() const
+{
+    return watching;
+}
+
+bool DirectoryWatcher::isPolling() const
+{
+    return watching && inotifyDescriptor < 0;
+}
+
+bool DirectoryWatcher::startInotify()
+{
+#ifdef __linux__
+    inotifyDescriptor = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotifyDescriptor < 0) {
+        return false;
+    }
+    
+    // Close-after-write and rename-into cover both in-place saves and atomic replace
+    watchDescriptor = inotify_add_watch(inotifyDescriptor, watchedDirectory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+    if (watchDescriptor < 0) {
+        close(inotifyDescriptor);
+        inotifyDescriptor = -1;
+        return false;
+    }
+    
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool DirectoryWatcher::pollInotify(std::vector<std::string>& changedFiles)
+{
+#ifdef __linux__
+    alignas(inotify_event) char buffer[4096];
+    size_t firstNew = changedFiles.size();
+    
+    while (true) {
+        ssize_t length = read(inotifyDescriptor, buffer, sizeof(buffer));
+        if (length <= 0) {
+            break; // EAGAIN: no more pending events
+        }
+        
+        for (char* p = buffer; p < buffer + length; ) {
+            const inotify_event* event = reinterpret_cast<const inotify_event*>(p);
+            if (event->len > 0 && !(event->mask & IN_ISDIR)) {
+                std::string path = (std::filesystem::path(watchedDirectory) / event->name).string();
+                
+                // Editors often write several times; report each file once per poll
+                bool alreadyReported = false;
+                for (size_t i = firstNew; i < changedFiles.size(); i++) {
+                    if (changedFiles[i] == path) {
+                        alreadyReported = true;
+                        break;
+                    }
+                }
+                if (!alreadyReported) {
+                    changedFiles.push_back(path);
+                }
+            }
+            p += sizeof(inotify_event) + event->len;
+        }
+    }
+    
+    return changedFiles.size() > firstNew;
+#else
+    (void)changedFiles;
+    return false;
+#endif
+}
+
+bool DirectoryWatcher::pollTimestamps(std::vector<std::string>& changedFiles)
+{
+    auto now = std::chrono::steady_clock::now();
+    if (now - lastScan < POLL_INTERVAL) {
+        return false;
+    }
+    lastScan = now;
+    
+    size_t firstNew = changedFiles.size();
+    scanTimestamps(&changedFiles);
+    return changedFiles.size() > firstNew;
+}
+
+void DirectoryWatcher::scanTimestamps(std::vector<std::string>* changedFiles)
+{
+    std::error_code error;
+    for (const auto& entry : std::filesystem::directory_iterator(watchedDirectory, error)) {
+        if (!entry.is_regular_file(error)) {
+            continue;
+        }
+        
+        FileStamp stamp;
+        stamp.size = entry.file_size(error);
+        stamp.modified = entry.last_write_time(error);
+        if (error) {
+            continue; // File vanished or is being replaced; pick it up next scan
+        }
+        
+        std::string path = entry.path().string();
+        auto it = fileStamps.find(path);
+        bool changed = it == fileStamps.end() || it->second.size != stamp.size || it->second.modified != stamp.modified;
+        
+        if (changed) {
+            fileStamps[path] = stamp;
+            if (changedFiles) {
+                changedFiles->push_back(path);
+            }
+        }
+    }
+}
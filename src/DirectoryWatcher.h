@@ -0,0 +1,58 @@
+#ifndef DIRECTORYWATCHER_H
+#define DIRECTORYWATCHER_H
+
+#include <chrono>
+#include <filesystem>
+#include <map>
+#include <string>
+#include <vector>
+
+// Reports files in a directory that were written or replaced. Uses inotify on
+// Linux; elsewhere (or if inotify is unavailable) it polls file timestamps.
+// poll() never blocks, so it can be called once per frame.
+class DirectoryWatcher
+{
+public:
+    DirectoryWatcher();
+    ~DirectoryWatcher();
+
+    DirectoryWatcher(const DirectoryWatcher&) = delete;
+    DirectoryWatcher& operator=(const DirectoryWatcher&) = delete;
+
+    // Start watching a directory (non-recursive)
+    bool start(const std::string& directory);
+
+    // Stop watching
+    void stop();
+
+    // Append paths of files changed since the last call; true if any changed
+    bool poll(std::vector<std::string>& changedFiles);
+
+    bool isWatching() const;
+    bool isPolling() const;
+
+private:
+    std::string watchedDirectory;
+    bool watching;
+
+    // inotify state (Linux); -1 when the polling fallback is used
+    int inotifyDescriptor;
+    int watchDescriptor;
+
+    // Polling fallback: last seen size and write time per file
+    struct FileStamp {
+        uintmax_t size = 0;
+        std::filesystem::file_time_type modified;
+    };
+    std::map<std::string, FileStamp> fileStamps;
+    std::chrono::steady_clock::time_point lastScan;
+
+    static constexpr std::chrono::milliseconds POLL_INTERVAL{500};
+
+    bool startInotify();
+    bool pollInotify(std::vector<std::string>& changedFiles);
+    bool pollTimestamps(std::vector<std::string>& changedFiles);
+    void scanTimestamps(std::vector<std::string>* changedFiles);
+};
+
+#endif
@@ -0,0 +1,164 @@
+#include "EmbreeBenchmark.h"
+#include "BulkCapacitanceProcessor.h"
+#include "CapacitanceCalculator.h"
+#include "ModelManager.h"
+#include "RunFile.h"
+#include "Tracer.h"
+#include "Transform.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+    constexpr size_t DEFAULT_BENCHMARK_ROWS = 20;
+    
+    struct BenchmarkConfig {
+        std::string name;
+        EmbreeConfig config;
+    };
+    
+    struct BenchmarkResult {
+        double buildMs = 0.0;
+        double updateMs = 0.0;      // refreshGeometry per row
+        double traceMs = 0.0;       // calculateCapacitances per row
+        size_t peakBytes = 0;
+        double totalCapacitance = 0.0;  // pF, last row
+    };
+    
+    // The command line policy first, then the presets with the same device options
+    std::vector<BenchmarkConfig> getBenchmarkConfigs(const EmbreeConfig& baseConfig)
+    {
+        auto preset = [&](RTCBuildQuality staticQuality, RTCBuildQuality dynamicQuality, bool compact, bool robust) {
+            EmbreeConfig config = baseConfig;
+            config.staticQuality = staticQuality;
+            config.dynamicQuality = dynamicQuality;
+            config.compact = compact;
+            config.robust = robust;
+            return BenchmarkConfig{config.describe(), config};
+        };
+        
+        return {
+            {"configured (" + baseConfig.describe() + ")", baseConfig},
+            preset(RTC_BUILD_QUALITY_HIGH, RTC_BUILD_QUALITY_REFIT, false, false),
+            preset(RTC_BUILD_QUALITY_HIGH, RTC_BUILD_QUALITY_LOW, false, false),
+            preset(RTC_BUILD_QUALITY_MEDIUM, RTC_BUILD_QUALITY_MEDIUM, false, false),
+            preset(RTC_BUILD_QUALITY_LOW, RTC_BUILD_QUALITY_LOW, true, false),
+            preset(RTC_BUILD_QUALITY_HIGH, RTC_BUILD_QUALITY_LOW, false, true)
+        };
+    }
+    
+    double elapsedMs(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+bool parseBenchmarkArguments(int argc, char** argv, size_t& rowCount)
+{
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--embree-benchmark") == 0) {
+            rowCount = DEFAULT_BENCHMARK_ROWS;
+            if (i + 1 < argc && argv[i + 1][0] >= '0' && argv[i + 1][0] <= '9') {
+                rowCount = std::max<size_t>(1, std::strtoul(argv[i + 1], nullptr, 10));
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+int runEmbreeBenchmark(const EmbreeConfig& baseConfig, size_t rowCount)
+{
+    ModelManager modelManager;
+    if (!modelManager.loadAllModels("models/")) {
+        std::cerr << "Failed to load models" << std::endl;
+        return -1;
+    }
+    
+    // Poses come from the run file of the last bulk run, or from the CSVs directly
+    std::string csvDirectory = "csv_data";
+    RunFile runFile;
+    BulkCapacitanceProcessor bulkProcessor;
+    bool useRunFile = runFile.open(RunFile::getRunPath(csvDirectory));
+    bool useStepMode = !useRunFile && bulkProcessor.initializeStepMode(csvDirectory);
+    if (useRunFile) {
+        rowCount = std::min(rowCount, runFile.getRowCount());
+    } else if (useStepMode) {
+        rowCount = std::min(rowCount, bulkProcessor.getMaxRows());
+    } else {
+        std::cout << "No run in " << csvDirectory << "; benchmarking the rest pose" << std::endl;
+    }
+    
+    std::vector<BenchmarkConfig> configs = getBenchmarkConfigs(baseConfig);
+    std::vector<BenchmarkResult> results(configs.size());
+    std::vector<CapacitanceResult> rowResults;
+    
+    for (size_t c = 0; c < configs.size(); c++) {
+        FT_TRACE_SCOPE("benchmark", configs[c].name);
+        std::cout << "\n=== Embree benchmark: " << configs[c].name << " ===" << std::endl;
+        CapacitanceCalculator::setDefaultEmbreeConfig(configs[c].config);
+        
+        TransformManager transformManager;
+        modelManager.assignModelGroups(transformManager);
+        CapacitanceCalculator calculator;
+        if (!calculator.initialize(modelManager.getModels(), transformManager)) {
+            std::cerr << "Skipping configuration: " << configs[c].name << std::endl;
+            continue;
+        }
+        
+        BenchmarkResult& result = results[c];
+        auto buildStart = std::chrono::steady_clock::now();
+        calculator.refreshGeometry();
+        result.buildMs = elapsedMs(buildStart);
+        
+        for (size_t row = 0; row < rowCount; row++) {
+            if (useRunFile) {
+                BulkCapacitanceProcessor::applyRunRecord(runFile.getRecord(row), transformManager);
+            } else if (useStepMode) {
+                bulkProcessor.stepToRow(row, transformManager);
+            }
+            
+            auto updateStart = std::chrono::steady_clock::now();
+            calculator.refreshGeometry();
+            result.updateMs += elapsedMs(updateStart);
+            
+            auto traceStart = std::chrono::steady_clock::now();
+            calculator.calculateCapacitances(rowResults);
+            result.traceMs += elapsedMs(traceStart);
+        }
+        
+        result.updateMs /= rowCount;
+        result.traceMs /= rowCount;
+        result.peakBytes = calculator.getMemoryStats().peakBytes;
+        result.totalCapacitance = 0.0;
+        for (const CapacitanceResult& rowResult : rowResults) {
+            result.totalCapacitance += rowResult.capacitance * 1e12;
+        }
+        calculator.cleanup();
+    }
+    
+    CapacitanceCalculator::setDefaultEmbreeConfig(baseConfig);
+    
+    // Totals differ slightly between policies (robust traversal catches edge hits)
+    std::cout << "\n=== Embree benchmark (" << rowCount << " rows, device "
+              << (baseConfig.getDeviceString().empty() ? "defaults" : baseConfig.getDeviceString()) << ") ===" << std::endl;
+    std::cout << std::left << std::setw(44) << "Configuration" << std::right << std::setw(12) << "Build ms"
+              << std::setw(14) << "Update ms/row" << std::setw(14) << "Trace ms/row" << std::setw(10) << "Rows/s"
+              << std::setw(10) << "Peak MB" << std::setw(14) << "Total pF" << std::endl;
+    for (size_t c = 0; c < configs.size(); c++) {
+        const BenchmarkResult& result = results[c];
+        double rowMs = result.updateMs + result.traceMs;
+        std::cout << std::left << std::setw(44) << configs[c].name << std::right << std::fixed << std::setprecision(2)
+                  << std::setw(12) << result.buildMs << std::setw(14) << result.updateMs << std::setw(14) << result.traceMs
+                  << std::setw(10) << std::setprecision(1) << (rowMs > 0.0 ? 1000.0 / rowMs : 0.0)
+                  << std::setw(10) << result.peakBytes / (1024.0 * 1024.0)
+                  << std::setw(14) << std::setprecision(6) << result.totalCapacitance << std::endl;
+    }
+    
+    return 0;
+}
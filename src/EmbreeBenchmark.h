@@ -0,0 +1,18 @@
+#ifndef EMBREEBENCHMARK_H
+#define EMBREEBENCHMARK_H
+
+#include "EmbreeConfig.h"
+#include <cstddef>
+
+// Comparison of Embree build policies on the current models. For each configuration a fresh
+// calculator builds the scenes, then poses rows of the last run (the rest pose if there is
+// none) and times the scene updates and ray casts. Device options (threads, affinity, ISA,
+// memory budget) come from the command line and are shared by all configurations.
+
+// Parse "--embree-benchmark [rows]"; returns false if the option is absent
+bool parseBenchmarkArguments(int argc, char** argv, size_t& rowCount);
+
+// Run the comparison and print a table; returns the process exit code
+int runEmbreeBenchmark(const EmbreeConfig& baseConfig, size_t rowCount);
+
+#endif
@@ -0,0 +1,186 @@
+#include "EmbreeConfig.h"
+#include <cctype>
+#include <cerrno>
+#include <climits>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+
+namespace {
+    // ISA names accepted by Embree's "isa" device option
+    const char* const SUPPORTED_ISAS[] = {"sse2", "sse4.2", "avx", "avx2", "avx512"};
+    
+    bool parseSceneFlags(const std::string& value, bool& compact, bool& robust)
+    {
+        compact = false;
+        robust = false;
+        std::istringstream flags(value);
+        std::string flag;
+        while (std::getline(flags, flag, ',')) {
+            if (flag == "compact") {
+                compact = true;
+            } else if (flag == "robust") {
+                robust = true;
+            } else if (flag != "none") {
+                return false;
+            }
+        }
+        return true;
+    }
+    
+    // Whole decimal number up to maxValue; strtoull alone accepts signs, trailing text and overflow
+    bool parseCount(const char* text, unsigned long long maxValue, unsigned long long& value)
+    {
+        if (!std::isdigit(static_cast<unsigned char>(*text))) {
+            return false;
+        }
+        char* end = nullptr;
+        errno = 0;
+        value = std::strtoull(text, &end, 10);
+        return errno == 0 && *end == '\0' && value <= maxValue;
+    }
+}
+
+std::string EmbreeConfig::getDeviceString() const
+{
+    std::string deviceString;
+    auto append = [&](const std::string& option) {
+        deviceString += (deviceString.empty() ? "" : ",") + option;
+    };
+    
+    if (threads > 0) {
+        append("threads=" + std::to_string(threads));
+    }
+    if (setAffinity) {
+        append("set_affinity=1");
+    }
+    if (!isa.empty()) {
+        append("isa=" + isa);
+    }
+    return deviceString;
+}
+
+RTCSceneFlags EmbreeConfig::getSceneFlags(bool dynamic) const
+{
+    int flags = RTC_SCENE_FLAG_NONE;
+    if (compact) {
+        flags |= RTC_SCENE_FLAG_COMPACT;
+    }
+    if (robust) {
+        flags |= RTC_SCENE_FLAG_ROBUST;
+    }
+    if (dynamic) {
+        flags |= RTC_SCENE_FLAG_DYNAMIC;
+    }
+    return static_cast<RTCSceneFlags>(flags);
+}
+
+RTCBuildQuality EmbreeConfig::getSceneQuality(bool dynamic) const
+{
+    RTCBuildQuality quality = dynamic ? dynamicQuality : staticQuality;
+    
+    // Refitting is a geometry setting; the scene's own build uses low quality
+    return quality == RTC_BUILD_QUALITY_REFIT ? RTC_BUILD_QUALITY_LOW : quality;
+}
+
+std::string EmbreeConfig::describe() const
+{
+    std::string description = std::string(getBuildQualityName(staticQuality)) + "/" + getBuildQualityName(dynamicQuality);
+    if (compact) {
+        description += " compact";
+    }
+    if (robust) {
+        description += " robust";
+    }
+    return description;
+}
+
+bool parseEmbreeArguments(int argc, char** argv, EmbreeConfig& config)
+{
+    for (int i = 1; i < argc; i++) {
+        const char* argument = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+        
+        if (std::strcmp(argument, "--embree-affinity") == 0) {
+            config.setAffinity = true;
+            continue;
+        }
+        
+        if (std::strcmp(argument, "--embree-threads") == 0 && value) {
+            unsigned long long threads = 0;
+            if (!parseCount(value, UINT_MAX, threads)) {
+                std::cerr << "Invalid Embree thread count: " << value << " (expected a whole number, 0 for all hardware threads)" << std::endl;
+                return false;
+            }
+            config.threads = static_cast<unsigned int>(threads);
+        } else if (std::strcmp(argument, "--embree-isa") == 0 && value) {
+            bool supported = false;
+            for (const char* isa : SUPPORTED_ISAS) {
+                supported = supported || std::strcmp(value, isa) == 0;
+            }
+            if (!supported) {
+                std::cerr << "Unknown Embree ISA: " << value << " (expected sse2, sse4.2, avx, avx2 or avx512)" << std::endl;
+                return false;
+            }
+            config.isa = value;
+        } else if (std::strcmp(argument, "--embree-scene-flags") == 0 && value) {
+            if (!parseSceneFlags(value, config.compact, config.robust)) {
+                std::cerr << "Invalid Embree scene flags: " << value << " (expected none, compact, robust or compact,robust)" << std::endl;
+                return false;
+            }
+        } else if (std::strcmp(argument, "--embree-quality") == 0 && value) {
+            // Static negatives are built once, so refitting them has nothing to update
+            std::string qualities(value);
+            size_t separator = qualities.find(':');
+            std::string staticName = qualities.substr(0, separator);
+            std::string dynamicName = separator == std::string::npos ? staticName : qualities.substr(separator + 1);
+            if (!parseBuildQuality(staticName, config.staticQuality) || config.staticQuality == RTC_BUILD_QUALITY_REFIT ||
+                !parseBuildQuality(dynamicName, config.dynamicQuality)) {
+                std::cerr << "Invalid Embree build quality: " << value
+                          << " (expected STATIC[:DYNAMIC] with low, medium or high, and refit for DYNAMIC)" << std::endl;
+                return false;
+            }
+        } else if (std::strcmp(argument, "--embree-budget-mb") == 0 && value) {
+            unsigned long long budgetMb = 0;
+            if (!parseCount(value, SIZE_MAX >> 20, budgetMb)) {
+                std::cerr << "Invalid Embree memory budget: " << value << " (expected a whole number of MB, 0 for unlimited)" << std::endl;
+                return false;
+            }
+            config.memoryBudgetBytes = static_cast<size_t>(budgetMb) << 20;
+        } else {
+            continue;
+        }
+        i++;  // Skip the option value
+    }
+    
+    return true;
+}
+
+const char* getBuildQualityName(RTCBuildQuality quality)
+{
+    switch (quality) {
+        case RTC_BUILD_QUALITY_LOW:    return "low";
+        case RTC_BUILD_QUALITY_MEDIUM: return "medium";
+        case RTC_BUILD_QUALITY_HIGH:   return "high";
+        case RTC_BUILD_QUALITY_REFIT:  return "refit";
+        default:                       return "unknown";
+    }
+}
+
+bool parseBuildQuality(const std::string& name, RTCBuildQuality& quality)
+{
+    if (name == "low") {
+        quality = RTC_BUILD_QUALITY_LOW;
+    } else if (name == "medium") {
+        quality = RTC_BUILD_QUALITY_MEDIUM;
+    } else if (name == "high") {
+        quality = RTC_BUILD_QUALITY_HIGH;
+    } else if (name == "refit") {
+        quality = RTC_BUILD_QUALITY_REFIT;
+    } else {
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,42 @@
+#ifndef EMBREECONFIG_H
+#define EMBREECONFIG_H
+
+#include <cstddef>
+#include <string>
+#include <embree4/rtcore.h>
+
+// Embree device and BVH build policy of the capacitance calculators. Negatives are built
+// once with the static quality; a negative whose pose changes is rebuilt on every such
+// change and switches to the dynamic policy (REFIT updates the existing BVH in place).
+struct EmbreeConfig {
+    unsigned int threads = 0;          // Embree worker threads; 0: all hardware threads
+    bool setAffinity = false;          // Pin the worker threads to cores
+    std::string isa;                   // sse2, sse4.2, avx, avx2 or avx512; empty: best supported
+    bool compact = false;              // RTC_SCENE_FLAG_COMPACT
+    bool robust = false;               // RTC_SCENE_FLAG_ROBUST
+    RTCBuildQuality staticQuality = RTC_BUILD_QUALITY_HIGH;
+    RTCBuildQuality dynamicQuality = RTC_BUILD_QUALITY_LOW;
+    size_t memoryBudgetBytes = 0;      // Per device; 0: unlimited. Every calculator (viewer, live
+                                       // readout, row prefetch, bulk run) has its own device and
+                                       // budget, so the process may use a multiple of it.
+
+    // rtcNewDevice configuration string (empty for Embree's defaults)
+    std::string getDeviceString() const;
+
+    // Scene flags and build quality of a static or dynamic negative scene
+    RTCSceneFlags getSceneFlags(bool dynamic) const;
+    RTCBuildQuality getSceneQuality(bool dynamic) const;
+
+    // One-line summary, e.g. "high/refit compact"
+    std::string describe() const;
+};
+
+// Parse "[--embree-threads N] [--embree-affinity] [--embree-isa NAME]
+// [--embree-scene-flags none|compact|robust|compact,robust] [--embree-quality STATIC[:DYNAMIC]]
+// [--embree-budget-mb N]"; returns false if an option is malformed.
+bool parseEmbreeArguments(int argc, char** argv, EmbreeConfig& config);
+
+const char* getBuildQualityName(RTCBuildQuality quality);
+bool parseBuildQuality(const std::string& name, RTCBuildQuality& quality);
+
+#endif
@@ -0,0 +1,121 @@
+#include "EmbreeMemory.h"
+#include "EmbreeConfig.h"
+#include <iomanip>
+#include <iostream>
+
+namespace {
+    double toMegabytes(size_t bytes)
+    {
+        return bytes / (1024.0 * 1024.0);
+    }
+}
+
+void EmbreeMemoryStats::print() const
+{
+    std::cout << "\nEmbree memory: " << std::fixed << std::setprecision(1) << toMegabytes(currentBytes)
+              << " MB (peak " << toMegabytes(peakBytes) << " MB, budget ";
+    if (budgetBytes > 0) {
+        std::cout << toMegabytes(budgetBytes) << " MB per device)" << std::endl;
+    } else {
+        std::cout << "unlimited)" << std::endl;
+    }
+    
+    for (const SceneMemory& scene : scenes) {
+        std::cout << "  " << std::left << std::setw(24) << scene.name << std::right
+                  << " BVH " << std::setw(7) << toMegabytes(scene.bvhBytes) << " MB"
+                  << "  geometry " << std::setw(7) << toMegabytes(scene.geometryBytes) << " MB"
+                  << "  mesh " << std::setw(7) << toMegabytes(scene.meshBytes) << " MB"
+                  << "  (" << getBuildQualityName(scene.quality) << (scene.compact ? ", compact" : "")
+                  << (scene.dynamic ? ", dynamic" : "")
+                  << (scene.resident ? "" : ", evicted") << ")" << std::endl;
+    }
+    std::cout << "  Positive triangles: " << toMegabytes(triangleBytes) << " MB" << std::endl;
+    
+    if (deniedAllocations > 0 || fallbackBuilds > 0 || streamingScenes) {
+        std::cout << "  Budget fallbacks: " << deniedAllocations << " refused allocations, " << fallbackBuilds
+                  << " frugal builds, " << sceneEvictions << " scene evictions"
+                  << (streamingScenes ? " (scenes built one at a time)" : "") << std::endl;
+    }
+}
+
+void EmbreeMemoryStats::writeJson(std::ostream& out, const char* indent) const
+{
+    out << indent << "\"embree_memory\": {\n";
+    out << indent << "  \"budget_bytes\": " << budgetBytes << ",\n";
+    out << indent << "  \"budget_scope\": \"per_device\",\n";
+    out << indent << "  \"current_bytes\": " << currentBytes << ",\n";
+    out << indent << "  \"peak_bytes\": " << peakBytes << ",\n";
+    out << indent << "  \"positive_triangle_bytes\": " << triangleBytes << ",\n";
+    out << indent << "  \"denied_allocations\": " << deniedAllocations << ",\n";
+    out << indent << "  \"fallback_builds\": " << fallbackBuilds << ",\n";
+    out << indent << "  \"scene_evictions\": " << sceneEvictions << ",\n";
+    out << indent << "  \"streaming_scenes\": " << (streamingScenes ? "true" : "false") << ",\n";
+    out << indent << "  \"scenes\": {\n";
+    for (size_t i = 0; i < scenes.size(); i++) {
+        const SceneMemory& scene = scenes[i];
+        out << indent << "    \"" << scene.name << "\": {\"bvh_bytes\": " << scene.bvhBytes
+            << ", \"geometry_bytes\": " << scene.geometryBytes << ", \"mesh_bytes\": " << scene.meshBytes
+            << ", \"build_quality\": \"" << getBuildQualityName(scene.quality) << "\", \"compact\": "
+            << (scene.compact ? "true" : "false") << ", \"dynamic\": " << (scene.dynamic ? "true" : "false")
+            << ", \"resident\": " << (scene.resident ? "true" : "false")
+            << "}" << (i + 1 < scenes.size() ? ",\n" : "\n");
+    }
+    out << indent << "  }\n";
+    out << indent << "}";
+}
+
+EmbreeMemoryMonitor::EmbreeMemoryMonitor() : currentBytes(0), peakBytes(0), budget(0), deniedAllocations(0)
+{
+}
+
+void EmbreeMemoryMonitor::attach(RTCDevice device)
+{
+    rtcSetDeviceMemoryMonitorFunction(device, &EmbreeMemoryMonitor::onAllocation, this);
+}
+
+void EmbreeMemoryMonitor::setBudget(size_t bytes)
+{
+    budget.store(bytes, std::memory_order_relaxed);
+}
+
+size_t EmbreeMemoryMonitor::getBudget() const
+{
+    return budget.load(std::memory_order_relaxed);
+}
+
+int64_t EmbreeMemoryMonitor::getCurrentBytes() const
+{
+    return currentBytes.load(std::memory_order_relaxed);
+}
+
+size_t EmbreeMemoryMonitor::getPeakBytes() const
+{
+    return static_cast<size_t>(peakBytes.load(std::memory_order_relaxed));
+}
+
+size_t EmbreeMemoryMonitor::getDeniedAllocations() const
+{
+    return deniedAllocations.load(std::memory_order_relaxed);
+}
+
+bool EmbreeMemoryMonitor::onAllocation(void* userPtr, ssize_t bytes, bool post)
+{
+    EmbreeMemoryMonitor* monitor = static_cast<EmbreeMemoryMonitor*>(userPtr);
+    int64_t limit = static_cast<int64_t>(monitor->budget.load(std::memory_order_relaxed));
+    int64_t current = monitor->currentBytes.load(std::memory_order_relaxed);
+    int64_t updated;
+    
+    // Frees and post-allocation notifications cannot be refused; allocations reserve under the budget
+    do {
+        updated = current + bytes;
+        if (bytes > 0 && !post && limit > 0 && updated > limit) {
+            monitor->deniedAllocations.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+    } while (!monitor->currentBytes.compare_exchange_weak(current, updated, std::memory_order_relaxed));
+    
+    int64_t peak = monitor->peakBytes.load(std::memory_order_relaxed);
+    while (updated > peak && !monitor->peakBytes.compare_exchange_weak(peak, updated, std::memory_order_relaxed)) {
+    }
+    return true;
+}
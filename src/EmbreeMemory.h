@@ -0,0 +1,71 @@
+#ifndef EMBREEMEMORY_H
+#define EMBREEMEMORY_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+#include <embree4/rtcore.h>
+
+// Memory of one Embree scene (one per negative model)
+struct SceneMemory {
+    std::string name;
+    size_t geometryBytes = 0;     // Embree vertex and index buffers
+    size_t bvhBytes = 0;          // BVH retained after the last build (0 while evicted)
+    size_t meshBytes = 0;         // Host mesh of the negative model (shared with the renderer; a mesh
+                                  // used by several negatives is counted for the first only)
+    RTCBuildQuality quality = RTC_BUILD_QUALITY_MEDIUM;
+    bool compact = false;
+    bool dynamic = false;         // Rebuilt after pose changes (dynamic build policy)
+    bool resident = false;
+};
+
+// Memory summary of a capacitance calculator
+struct EmbreeMemoryStats {
+    size_t budgetBytes = 0;       // Of this calculator's device; 0: unlimited
+    size_t currentBytes = 0;      // Embree device allocations
+    size_t peakBytes = 0;
+    size_t triangleBytes = 0;     // Positive triangle arrays of the calculator
+    size_t deniedAllocations = 0;
+    size_t fallbackBuilds = 0;    // Scene builds that needed the frugal build settings
+    size_t sceneEvictions = 0;
+    bool streamingScenes = false; // Only the scene in use keeps its BVH
+    std::vector<SceneMemory> scenes;
+
+    void print() const;
+
+    // "embree_memory" object for the run report
+    void writeJson(std::ostream& out, const char* indent) const;
+};
+
+// Device allocation tracking through rtcSetDeviceMemoryMonitorFunction. Embree calls the
+// monitor from its build threads before each allocation and after each free; with a budget,
+// allocations that would exceed it are refused, so the Embree call fails with
+// RTC_ERROR_OUT_OF_MEMORY and the caller can retry with cheaper settings instead of the
+// process being OOM-killed.
+class EmbreeMemoryMonitor
+{
+public:
+    EmbreeMemoryMonitor();
+
+    void attach(RTCDevice device);
+
+    void setBudget(size_t bytes);
+    size_t getBudget() const;
+
+    int64_t getCurrentBytes() const;
+    size_t getPeakBytes() const;
+    size_t getDeniedAllocations() const;
+
+private:
+    static bool onAllocation(void* userPtr, ssize_t bytes, bool post);
+
+    std::atomic<int64_t> currentBytes;
+    std::atomic<int64_t> peakBytes;
+    std::atomic<size_t> budget;
+    std::atomic<size_t> deniedAllocations;
+};
+
+#endif
@@ -0,0 +1,295 @@
+#include "FrameTimer.h"
+#include <glad/glad.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+void FrameTimer::SampleWindow::add(double value)
+{
+    values[next] = value;
+    next = (next + 1) % WINDOW_SAMPLES;
+    count = std::min(count + 1, WINDOW_SAMPLES);
+}
+
+std::vector<double> FrameTimer::SampleWindow::ordered() const
+{
+    std::vector<double> samples(count);
+    size_t first = (next + WINDOW_SAMPLES - count) % WINDOW_SAMPLES;
+    for (size_t i = 0; i < count; i++) {
+        samples[i] = values[(first + i) % WINDOW_SAMPLES];
+    }
+    return samples;
+}
+
+FrameTimer::FrameTimer() : enabled(false), queries{}, queryIssued{}, queryBuffer(0), droppedQueries(0)
+{
+}
+
+FrameTimer::~FrameTimer()
+{
+    cleanup();
+}
+
+bool FrameTimer::initialize()
+{
+    glGenQueries(static_cast<GLsizei>(QUERY_BUFFERS * GPU_STAGES), &queries[0][0]);
+    return queries[0][0] != 0;
+}
+
+void FrameTimer::cleanup()
+{
+    if (queries[0][0] != 0) {
+        glDeleteQueries(static_cast<GLsizei>(QUERY_BUFFERS * GPU_STAGES), &queries[0][0]);
+        for (size_t buffer = 0; buffer < QUERY_BUFFERS; buffer++) {
+            for (size_t stage = 0; stage < GPU_STAGES; stage++) {
+                queries[buffer][stage] = 0;
+                queryIssued[buffer][stage] = false;
+            }
+        }
+    }
+}
+
+void FrameTimer::setEnabled(bool enable)
+{
+    enabled = enable;
+    
+    // Start each session with fresh windows
+    if (enabled) {
+        for (SampleWindow& window : cpuSamples) window = SampleWindow();
+        for (SampleWindow& window : gpuSamples) window = SampleWindow();
+        for (size_t buffer = 0; buffer < QUERY_BUFFERS; buffer++) {
+            for (size_t stage = 0; stage < GPU_STAGES; stage++) {
+                queryIssued[buffer][stage] = false;
+            }
+        }
+        droppedQueries = 0;
+    }
+}
+
+bool FrameTimer::isEnabled() const
+{
+    return enabled;
+}
+
+void FrameTimer::beginFrame()
+{
+    if (!enabled || queries[0][0] == 0) {
+        return;
+    }
+    
+    // This frame reuses the query set of two frames ago; take its results if they are in
+    for (size_t stage = 0; stage < GPU_STAGES; stage++) {
+        if (!queryIssued[queryBuffer][stage]) {
+            continue;
+        }
+        queryIssued[queryBuffer][stage] = false;
+        
+        GLint available = 0;
+        glGetQueryObjectiv(queries[queryBuffer][stage], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) {
+            droppedQueries++;
+            continue;
+        }
+        
+        GLuint64 nanoseconds = 0;
+        glGetQueryObjectui64v(queries[queryBuffer][stage], GL_QUERY_RESULT, &nanoseconds);
+        gpuSamples[stage].add(nanoseconds / 1.0e6);
+    }
+}
+
+void FrameTimer::endFrame()
+{
+    queryBuffer = (queryBuffer + 1) % QUERY_BUFFERS;
+}
+
+void FrameTimer::beginCpu(CpuStage stage)
+{
+    if (enabled) {
+        cpuStart[static_cast<size_t>(stage)] = std::chrono::steady_clock::now();
+    }
+}
+
+void FrameTimer::endCpu(CpuStage stage)
+{
+    if (enabled) {
+        size_t index = static_cast<size_t>(stage);
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - cpuStart[index];
+        cpuSamples[index].add(elapsed.count());
+    }
+}
+
+void FrameTimer::beginGpu(GpuStage stage)
+{
+    if (enabled && queries[0][0] != 0) {
+        glBeginQuery(GL_TIME_ELAPSED, queries[queryBuffer][static_cast<size_t>(stage)]);
+    }
+}
+
+void FrameTimer::endGpu(GpuStage stage)
+{
+    if (enabled && queries[0][0] != 0) {
+        glEndQuery(GL_TIME_ELAPSED);
+        queryIssued[queryBuffer][static_cast<size_t>(stage)] = true;
+    }
+}
+
+TimingStats FrameTimer::getCpuStats(CpuStage stage) const
+{
+    return computeStats(cpuSamples[static_cast<size_t>(stage)]);
+}
+
+TimingStats FrameTimer::getGpuStats(GpuStage stage) const
+{
+    return computeStats(gpuSamples[static_cast<size_t>(stage)]);
+}
+
+TimingStats FrameTimer::computeStats(const SampleWindow& window)
+{
+    TimingStats stats;
+    std::vector<double> samples = window.ordered();
+    if (samples.empty()) {
+        return stats;
+    }
+    
+    std::sort(samples.begin(), samples.end());
+    double sum = 0.0;
+    for (double sample : samples) {
+        sum += sample;
+    }
+    
+    // Nearest-rank percentiles
+    auto percentile = [&](double fraction) {
+        size_t rank = static_cast<size_t>(fraction * (samples.size() - 1) + 0.5);
+        return samples[std::min(rank, samples.size() - 1)];
+    };
+    
+    stats.samples = samples.size();
+    stats.average = sum / samples.size();
+    stats.p50 = percentile(0.50);
+    stats.p95 = percentile(0.95);
+    stats.p99 = percentile(0.99);
+    stats.max = samples.back();
+    return stats;
+}
+
+const char* FrameTimer::getStageName(CpuStage stage)
+{
+    switch (stage) {
+        case CpuStage::Input:      return "CPU INPUT";
+        case CpuStage::Transforms: return "CPU TRANSFORMS";
+        case CpuStage::Submit:     return "CPU SUBMIT";
+        default:                   return "CPU";
+    }
+}
+
+const char* FrameTimer::getStageName(GpuStage stage)
+{
+    switch (stage) {
+        case GpuStage::Axes:   return "GPU AXES";
+        case GpuStage::Models: return "GPU MODELS";
+        default:               return "GPU";
+    }
+}
+
+std::vector<std::string> FrameTimer::formatLines() const
+{
+    std::vector<std::string> lines;
+    lines.push_back("FRAME TIMING (MS)   AVG    P50    P95    P99");
+    
+    char line[96];
+    auto addLine = [&](const char* name, const TimingStats& stats) {
+        if (stats.samples == 0) {
+            std::snprintf(line, sizeof(line), "%-16s     -", name);
+        } else {
+            std::snprintf(line, sizeof(line), "%-16s %6.2f %6.2f %6.2f %6.2f",
+                          name, stats.average, stats.p50, stats.p95, stats.p99);
+        }
+        lines.push_back(line);
+    };
+    
+    for (size_t stage = 0; stage < CPU_STAGES; stage++) {
+        addLine(getStageName(static_cast<CpuStage>(stage)), computeStats(cpuSamples[stage]));
+    }
+    for (size_t stage = 0; stage < GPU_STAGES; stage++) {
+        addLine(getStageName(static_cast<GpuStage>(stage)), computeStats(gpuSamples[stage]));
+    }
+    if (queries[0][0] == 0) {
+        lines.push_back("GPU TIMER QUERIES UNAVAILABLE");
+    } else if (droppedQueries > 0) {
+        lines.push_back("DROPPED GPU RESULTS: " + std::to_string(droppedQueries));
+    }
+    
+    return lines;
+}
+
+bool FrameTimer::exportToFile(const std::string& filePath) const
+{
+    std::ofstream file(filePath);
+    if (!file.is_open()) {
+        std::cerr << "Error: Cannot create timing file: " << filePath << std::endl;
+        return false;
+    }
+    
+    file << "stage,samples,average_ms,p50_ms,p95_ms,p99_ms,max_ms\n";
+    auto writeSummary = [&](const char* name, const TimingStats& stats) {
+        file << name << "," << stats.samples << "," << stats.average << "," << stats.p50 << ","
+             << stats.p95 << "," << stats.p99 << "," << stats.max << "\n";
+    };
+    for (size_t stage = 0; stage < CPU_STAGES; stage++) {
+        writeSummary(getStageName(static_cast<CpuStage>(stage)), computeStats(cpuSamples[stage]));
+    }
+    for (size_t stage = 0; stage < GPU_STAGES; stage++) {
+        writeSummary(getStageName(static_cast<GpuStage>(stage)), computeStats(gpuSamples[stage]));
+    }
+    
+    // Raw windows, oldest first; the series are sampled independently, so rows are not frames
+    std::vector<std::vector<double>> series;
+    file << "\nsample";
+    for (size_t stage = 0; stage < CPU_STAGES; stage++) {
+        file << "," << getStageName(static_cast<CpuStage>(stage));
+        series.push_back(cpuSamples[stage].ordered());
+    }
+    for (size_t stage = 0; stage < GPU_STAGES; stage++) {
+        file << "," << getStageName(static_cast<GpuStage>(stage));
+        series.push_back(gpuSamples[stage].ordered());
+    }
+    file << "\n";
+    
+    for (size_t i = 0; i < WINDOW_SAMPLES; i++) {
+        bool any = false;
+        for (const std::vector<double>& samples : series) {
+            any = any || i < samples.size();
+        }
+        if (!any) {
+            break;
+        }
+        
+        file << i;
+        for (const std::vector<double>& samples : series) {
+            file << ",";
+            if (i < samples.size()) {
+                file << samples[i];
+            }
+        }
+        file << "\n";
+    }
+    
+    std::cout << "Frame timing written to " << filePath << std::endl;
+    return file.good();
+}
+
+ScopedCpuTimer::ScopedCpuTimer(FrameTimer* timer, CpuStage stage) : timer(timer), stage(stage)
+{
+    if (timer) {
+        timer->beginCpu(stage);
+    }
+}
+
+ScopedCpuTimer::~ScopedCpuTimer()
+{
+    if (timer) {
+        timer->endCpu(stage);
+    }
+}
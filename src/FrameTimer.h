@@ -0,0 +1,117 @@
+#ifndef FRAMETIMER_H
+#define FRAMETIMER_H
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// CPU stages of a viewer frame
+enum class CpuStage {
+    Input,          // Input handling and per-frame updates
+    Transforms,     // Instance data rebuild (getCombinedTransform per model)
+    Submit,         // GL command submission for the scene
+    Count
+};
+
+// GPU passes measured with GL_TIME_ELAPSED queries
+enum class GpuStage {
+    Axes,
+    Models,
+    Count
+};
+
+struct TimingStats {
+    size_t samples = 0;
+    double average = 0.0;   // ms
+    double p50 = 0.0;
+    double p95 = 0.0;
+    double p99 = 0.0;
+    double max = 0.0;
+};
+
+// Frame timing for the viewer: CPU stage times from steady_clock and GPU pass times from
+// timer queries, each kept in a rolling window of the last WINDOW_SAMPLES values. Queries
+// are double-buffered per pass and only read back once GL_QUERY_RESULT_AVAILABLE is set, so
+// timing never stalls the pipeline; a result that is still pending when its query is reused
+// is dropped. Disabled timers cost a branch per stage.
+class FrameTimer
+{
+public:
+    FrameTimer();
+    ~FrameTimer();
+
+    // Needs a current GL context (creates the queries)
+    bool initialize();
+    void cleanup();
+
+    void setEnabled(bool enabled);
+    bool isEnabled() const;
+
+    // Bracket a drawn frame: beginFrame collects finished GPU results, endFrame flips the query set
+    void beginFrame();
+    void endFrame();
+
+    void beginCpu(CpuStage stage);
+    void endCpu(CpuStage stage);
+
+    // GPU passes may not overlap (one GL_TIME_ELAPSED query can be active at a time)
+    void beginGpu(GpuStage stage);
+    void endGpu(GpuStage stage);
+
+    TimingStats getCpuStats(CpuStage stage) const;
+    TimingStats getGpuStats(GpuStage stage) const;
+
+    // One line per stage for the overlay
+    std::vector<std::string> formatLines() const;
+
+    // Summary (one row per stage) and the raw sample windows, as CSV
+    bool exportToFile(const std::string& filePath) const;
+
+private:
+    static constexpr size_t WINDOW_SAMPLES = 240;
+    static constexpr size_t QUERY_BUFFERS = 2;
+    static constexpr size_t CPU_STAGES = static_cast<size_t>(CpuStage::Count);
+    static constexpr size_t GPU_STAGES = static_cast<size_t>(GpuStage::Count);
+
+    // Fixed-size ring of samples in ms
+    struct SampleWindow {
+        double values[WINDOW_SAMPLES] = {};
+        size_t next = 0;
+        size_t count = 0;
+
+        void add(double value);
+        std::vector<double> ordered() const;   // Oldest first
+    };
+
+    static TimingStats computeStats(const SampleWindow& window);
+    static const char* getStageName(CpuStage stage);
+    static const char* getStageName(GpuStage stage);
+
+    bool enabled;
+    SampleWindow cpuSamples[CPU_STAGES];
+    SampleWindow gpuSamples[GPU_STAGES];
+    std::chrono::steady_clock::time_point cpuStart[CPU_STAGES];
+
+    unsigned int queries[QUERY_BUFFERS][GPU_STAGES];
+    bool queryIssued[QUERY_BUFFERS][GPU_STAGES];
+    size_t queryBuffer;
+    size_t droppedQueries;
+};
+
+// Times a CPU stage for the enclosing scope; a null timer does nothing
+class ScopedCpuTimer
+{
+public:
+    ScopedCpuTimer(FrameTimer* timer, CpuStage stage);
+    ~ScopedCpuTimer();
+
+    ScopedCpuTimer(const ScopedCpuTimer&) = delete;
+    ScopedCpuTimer& operator=(const ScopedCpuTimer&) = delete;
+
+private:
+    FrameTimer* timer;
+    CpuStage stage;
+};
+
+#endif
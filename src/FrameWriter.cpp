@@ -0,0 +1,270 @@
+#include "FrameWriter.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+
+namespace {
+
+uint32_t crc32(uint32_t crc, const unsigned char* data, size_t size)
+{
+    static uint32_t table[256];
+    static bool tableReady = [] {
+        for (uint32_t n = 0; n < 256; n++) {
+            uint32_t c = n;
+            for (int k = 0; k < 8; k++) {
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            table[n] = c;
+        }
+        return true;
+    }();
+    (void)tableReady;
+    
+    crc = ~crc;
+    for (size_t i = 0; i < size; i++) {
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+void appendBigEndian(std::vector<unsigned char>& out, uint32_t value)
+{
+    out.push_back(static_cast<unsigned char>(value >> 24));
+    out.push_back(static_cast<unsigned char>(value >> 16));
+    out.push_back(static_cast<unsigned char>(value >> 8));
+    out.push_back(static_cast<unsigned char>(value));
+}
+
+void appendChunk(std::vector<unsigned char>& out, const char* type, const std::vector<unsigned char>& data)
+{
+    appendBigEndian(out, static_cast<uint32_t>(data.size()));
+    size_t typeOffset = out.size();
+    out.insert(out.end(), type, type + 4);
+    out.insert(out.end(), data.begin(), data.end());
+    appendBigEndian(out, crc32(0, out.data() + typeOffset, data.size() + 4));
+}
+
+} // namespace
+
+FrameWriter::FrameWriter() : format(FrameFormat::Png), width(0), height(0), rawStream(nullptr),
+                             stopping(false), failed(false), framesWritten(0)
+{
+}
+
+FrameWriter::~FrameWriter()
+{
+    finish();
+}
+
+bool FrameWriter::start(const std::string& directory, FrameFormat frameFormat, int frameWidth, int frameHeight,
+                        size_t threadCount)
+{
+    outputDirectory = directory;
+    format = frameFormat;
+    width = frameWidth;
+    height = frameHeight;
+    stopping = false;
+    failed = false;
+    framesWritten = 0;
+    
+    std::error_code error;
+    std::filesystem::create_directories(outputDirectory, error);
+    if (error) {
+        std::cerr << "Failed to create export directory " << outputDirectory << ": " << error.message() << std::endl;
+        return false;
+    }
+    
+    if (format == FrameFormat::Raw) {
+        std::string rawPath = outputDirectory + "/frames.rgb";
+        rawStream = std::fopen(rawPath.c_str(), "wb");
+        if (!rawStream) {
+            std::cerr << "Failed to open " << rawPath << " for writing" << std::endl;
+            return false;
+        }
+        // Frames must land in order, so the stream has a single writer
+        threadCount = 1;
+    }
+    
+    threadCount = std::max<size_t>(threadCount, 1);
+    for (size_t i = 0; i < threadCount; i++) {
+        workers.emplace_back(&FrameWriter::run, this);
+    }
+    return true;
+}
+
+std::vector<unsigned char> FrameWriter::acquireBuffer()
+{
+    std::vector<unsigned char> buffer;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!freeBuffers.empty()) {
+            buffer.swap(freeBuffers.back());
+            freeBuffers.pop_back();
+        }
+    }
+    buffer.resize(static_cast<size_t>(width) * height * 3);
+    return buffer;
+}
+
+bool FrameWriter::submit(size_t frameIndex, std::vector<unsigned char>&& pixels)
+{
+    if (workers.empty() || failed) {
+        return false;
+    }
+    
+    std::unique_lock<std::mutex> lock(mutex);
+    frameTaken.wait(lock, [this]() { return queue.size() < MAX_QUEUED_FRAMES; });
+    
+    Frame frame;
+    frame.index = frameIndex;
+    frame.pixels.swap(pixels);
+    queue.push_back(std::move(frame));
+    lock.unlock();
+    
+    frameQueued.notify_one();
+    return true;
+}
+
+bool FrameWriter::finish()
+{
+    if (workers.empty()) {
+        return !failed;
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    frameQueued.notify_all();
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    workers.clear();
+    
+    if (rawStream) {
+        if (std::fclose(rawStream) != 0) {
+            failed = true;
+        }
+        rawStream = nullptr;
+    }
+    freeBuffers.clear();
+    return !failed;
+}
+
+size_t FrameWriter::getFramesWritten() const
+{
+    return framesWritten;
+}
+
+void FrameWriter::run()
+{
+    while (true) {
+        Frame frame;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            frameQueued.wait(lock, [this]() { return stopping || !queue.empty(); });
+            if (queue.empty()) {
+                break;
+            }
+            frame = std::move(queue.front());
+            queue.pop_front();
+        }
+        frameTaken.notify_one();
+        
+        if (!writeFrame(frame)) {
+            failed = true;
+        } else {
+            framesWritten++;
+        }
+        
+        std::lock_guard<std::mutex> lock(mutex);
+        freeBuffers.push_back(std::move(frame.pixels));
+    }
+}
+
+bool FrameWriter::writeFrame(const Frame& frame)
+{
+    if (format == FrameFormat::Raw) {
+        // rawvideo expects the top row first
+        size_t rowBytes = static_cast<size_t>(width) * 3;
+        for (int y = height - 1; y >= 0; y--) {
+            if (std::fwrite(frame.pixels.data() + y * rowBytes, 1, rowBytes, rawStream) != rowBytes) {
+                std::cerr << "Failed to write frame " << frame.index << " to the raw stream" << std::endl;
+                return false;
+            }
+        }
+        return true;
+    }
+    
+    std::ostringstream path;
+    path << outputDirectory << "/frame_" << std::setw(6) << std::setfill('0') << frame.index << ".png";
+    if (!writePng(path.str(), width, height, frame.pixels.data())) {
+        std::cerr << "Failed to write " << path.str() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool FrameWriter::writePng(const std::string& filePath, int width, int height, const unsigned char* pixelsBottomUp)
+{
+    size_t rowBytes = static_cast<size_t>(width) * 3;
+    
+    // Scanlines: filter type 0 (none), then the row, top row first
+    std::vector<unsigned char> scanlines;
+    scanlines.reserve((rowBytes + 1) * height);
+    for (int y = height - 1; y >= 0; y--) {
+        scanlines.push_back(0);
+        const unsigned char* row = pixelsBottomUp + y * rowBytes;
+        scanlines.insert(scanlines.end(), row, row + rowBytes);
+    }
+    
+    // zlib stream of stored deflate blocks (no compression keeps encoding cheap), then Adler-32
+    std::vector<unsigned char> zlib;
+    zlib.reserve(scanlines.size() + scanlines.size() / 65535 * 5 + 16);
+    zlib.push_back(0x78);
+    zlib.push_back(0x01);
+    size_t offset = 0;
+    do {
+        size_t blockSize = std::min<size_t>(scanlines.size() - offset, 65535);
+        bool last = offset + blockSize == scanlines.size();
+        zlib.push_back(last ? 1 : 0);
+        zlib.push_back(static_cast<unsigned char>(blockSize & 0xFF));
+        zlib.push_back(static_cast<unsigned char>(blockSize >> 8));
+        zlib.push_back(static_cast<unsigned char>(~blockSize & 0xFF));
+        zlib.push_back(static_cast<unsigned char>((~blockSize >> 8) & 0xFF));
+        zlib.insert(zlib.end(), scanlines.begin() + offset, scanlines.begin() + offset + blockSize);
+        offset += blockSize;
+    } while (offset < scanlines.size());
+    
+    uint32_t a = 1, b = 0;
+    for (unsigned char byte : scanlines) {
+        a = (a + byte) % 65521;
+        b = (b + a) % 65521;
+    }
+    appendBigEndian(zlib, (b << 16) | a);
+    
+    std::vector<unsigned char> header;
+    appendBigEndian(header, static_cast<uint32_t>(width));
+    appendBigEndian(header, static_cast<uint32_t>(height));
+    const unsigned char headerTail[] = {8, 2, 0, 0, 0};   // 8-bit RGB, deflate, no filter, no interlace
+    header.insert(header.end(), std::begin(headerTail), std::end(headerTail));
+    
+    const unsigned char signature[] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    std::vector<unsigned char> png(std::begin(signature), std::end(signature));
+    png.reserve(zlib.size() + 64);
+    appendChunk(png, "IHDR", header);
+    appendChunk(png, "IDAT", zlib);
+    appendChunk(png, "IEND", {});
+    
+    FILE* file = std::fopen(filePath.c_str(), "wb");
+    if (!file) {
+        return false;
+    }
+    bool written = std::fwrite(png.data(), 1, png.size(), file) == png.size();
+    return std::fclose(file) == 0 && written;
+}
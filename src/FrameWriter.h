@@ -0,0 +1,72 @@
+#ifndef FRAMEWRITER_H
+#define FRAMEWRITER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+enum class FrameFormat {
+    Png,    // One numbered PNG per frame (frame_000000.png, ...)
+    Raw     // One rgb24 stream (frames.rgb), e.g. for ffmpeg -f rawvideo
+};
+
+// Writes rendered frames on worker threads so the render loop only hands over pixels.
+// PNG frames are independent and encoded in parallel; the raw stream is written in frame
+// order by a single worker. Pixel buffers are recycled, and submit() blocks while
+// MAX_QUEUED_FRAMES are waiting, which bounds memory when encoding is the bottleneck.
+class FrameWriter
+{
+public:
+    FrameWriter();
+    ~FrameWriter();
+
+    bool start(const std::string& outputDirectory, FrameFormat format, int width, int height, size_t threadCount);
+
+    // A buffer of width * height * 3 bytes to fill and submit
+    std::vector<unsigned char> acquireBuffer();
+
+    // Queue a frame of RGB pixels, bottom row first (as read back from OpenGL)
+    bool submit(size_t frameIndex, std::vector<unsigned char>&& pixels);
+
+    // Wait for every queued frame and stop the workers; false if any frame failed to write
+    bool finish();
+
+    size_t getFramesWritten() const;
+
+    // Uncompressed (stored-deflate) RGB PNG; rows are flipped to PNG's top-down order
+    static bool writePng(const std::string& filePath, int width, int height, const unsigned char* pixelsBottomUp);
+
+private:
+    struct Frame {
+        size_t index = 0;
+        std::vector<unsigned char> pixels;
+    };
+
+    void run();
+    bool writeFrame(const Frame& frame);
+
+    static constexpr size_t MAX_QUEUED_FRAMES = 8;
+
+    std::string outputDirectory;
+    FrameFormat format;
+    int width, height;
+    FILE* rawStream;
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable frameQueued;
+    std::condition_variable frameTaken;
+    std::deque<Frame> queue;
+    std::vector<std::vector<unsigned char>> freeBuffers;
+    bool stopping;
+
+    std::atomic<bool> failed;
+    std::atomic<size_t> framesWritten;
+};
+
+#endif
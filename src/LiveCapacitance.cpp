@@ -0,0 +1,200 @@
+#include "LiveCapacitance.h"
+#include "Tracer.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+LiveCapacitance::LiveCapacitance() : stopRequested(false), abortPass(false), failed(false), rayCapture(nullptr),
+                                     hasPendingTransforms(false)
+{
+}
+
+LiveCapacitance::~LiveCapacitance()
+{
+    stop();
+}
+
+bool LiveCapacitance::start(const std::vector<Model>& models, const TransformManager& transforms,
+                            std::function<void()> resultCallback)
+{
+    if (worker.joinable()) {
+        if (!failed) {
+            return true;
+        }
+        worker.join();  // The failed worker has already exited
+    }
+    
+    initialModels = models;
+    onResult = resultCallback;
+    stopRequested = false;
+    abortPass = false;
+    failed = false;
+    latest = LiveCapacitanceResult();
+    
+    // The initial state is the first job
+    pendingTransforms = transforms;
+    hasPendingTransforms = true;
+    
+    worker = std::thread(&LiveCapacitance::run, this);
+    return true;
+}
+
+void LiveCapacitance::stop()
+{
+    if (!worker.joinable()) {
+        return;
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopRequested = true;
+    }
+    abortPass = true;
+    wake.notify_one();
+    worker.join();
+}
+
+bool LiveCapacitance::isRunning() const
+{
+    return worker.joinable() && !failed;
+}
+
+void LiveCapacitance::submit(const TransformManager& transforms)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pendingTransforms = transforms;
+        hasPendingTransforms = true;
+    }
+    abortPass = true;
+    wake.notify_one();
+}
+
+void LiveCapacitance::updateModelMeshes(const std::vector<Model>& models, const std::vector<ModelId>& changedModels)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pendingModels = models;
+        pendingChangedModels.insert(pendingChangedModels.end(), changedModels.begin(), changedModels.end());
+    }
+    abortPass = true;
+    wake.notify_one();
+}
+
+void LiveCapacitance::setRayCapture(RayCapture* capture)
+{
+    rayCapture = capture;
+}
+
+bool LiveCapacitance::getLatest(LiveCapacitanceResult& result, uint64_t lastGeneration) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (latest.generation <= lastGeneration) {
+        return false;
+    }
+    
+    result = latest;
+    return true;
+}
+
+void LiveCapacitance::run()
+{
+    Tracer::setThreadName("live capacitance");
+    TransformManager transforms;
+    CapacitanceCalculator calculator;
+    calculator.setTriangleFieldRecording(true);
+    // The viewer's own calculator and render loop keep the other half of the cores
+    calculator.setThreadLimit(std::max(1u, std::thread::hardware_concurrency() / 2));
+    bool initialized = false;
+    std::vector<CapacitanceResult> results;
+    std::vector<Model> changedMeshModels;
+    std::vector<ModelId> changedModels;
+    
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this]() {
+                return stopRequested || hasPendingTransforms || !pendingChangedModels.empty();
+            });
+            if (stopRequested) {
+                break;
+            }
+            
+            if (hasPendingTransforms) {
+                transforms = pendingTransforms;
+                hasPendingTransforms = false;
+            }
+            changedMeshModels.swap(pendingModels);
+            changedModels.swap(pendingChangedModels);
+            pendingModels.clear();
+            pendingChangedModels.clear();
+            abortPass = false;
+        }
+        
+        auto passStart = std::chrono::steady_clock::now();
+        auto elapsedMs = [&passStart]() {
+            return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - passStart).count();
+        };
+        
+        if (!initialized) {
+            if (!calculator.initialize(initialModels, transforms)) {
+                std::cerr << "Live capacitance: calculator failed to initialize" << std::endl;
+                failed = true;
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    latest.results.clear();
+                    latest.triangleFields.clear();
+                    latest.failed = true;
+                    latest.generation++;
+                }
+                if (onResult) {
+                    onResult();
+                }
+                return;
+            }
+            initialized = true;
+        }
+        if (!changedModels.empty()) {
+            calculator.updateModelMeshes(changedMeshModels, changedModels);
+        }
+        
+        // Negatives whose transforms changed are updated now; moved positives are re-extracted by
+        // the passes below (the coarse one transforms only its sampled triangles)
+        calculator.refreshScenes();
+        calculator.setRayCapture(rayCapture);
+        uint64_t transformVersion = transforms.getTransformVersion();
+        
+        // Coarse estimate first, so the readout follows interaction within a frame or two
+        calculator.calculateCapacitances(results, COARSE_SAMPLES_PER_MODEL, nullptr);
+        publish(results, true, transformVersion, elapsedMs(), nullptr);
+        
+        // Full result, unless a newer state arrived meanwhile
+        if (!calculator.calculateCapacitances(results, 0, &abortPass)) {
+            continue;
+        }
+        publish(results, false, transformVersion, elapsedMs(), &calculator.getTriangleFields());
+    }
+}
+
+void LiveCapacitance::publish(const std::vector<CapacitanceResult>& results, bool coarse,
+                              uint64_t transformVersion, double computeMs,
+                              const std::vector<TriangleFields>* triangleFields)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        latest.results = results;
+        latest.coarse = coarse;
+        latest.transformVersion = transformVersion;
+        latest.computeMs = computeMs;
+        if (triangleFields) {
+            latest.triangleFields = *triangleFields;
+        } else {
+            latest.triangleFields.clear();
+        }
+        latest.generation++;
+    }
+    
+    if (onResult) {
+        onResult();
+    }
+}
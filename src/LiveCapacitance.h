@@ -0,0 +1,84 @@
+#ifndef LIVECAPACITANCE_H
+#define LIVECAPACITANCE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "CapacitanceCalculator.h"
+#include "ModelManager.h"
+#include "Transform.h"
+
+// Latest live result for one submitted transform state
+struct LiveCapacitanceResult {
+    std::vector<CapacitanceResult> results;
+    bool coarse = false;            // Sampled estimate; the full result follows unless transforms change again
+    uint64_t transformVersion = 0;  // Version of the transform state the values belong to
+    double computeMs = 0.0;         // Time from picking up the state to publishing this result
+    uint64_t generation = 0;        // Bumped on every publish
+    std::vector<TriangleFields> triangleFields;   // Per-triangle values; full results only
+    bool failed = false;            // The worker could not initialize its calculator and has exited
+};
+
+// Recomputes capacitance on a background thread whenever new transforms are submitted.
+// Each state first publishes a coarse estimate from a subset of triangles, then the full
+// result; a newer submission abandons a full pass in progress. The worker owns its own
+// transform manager and calculator, so the viewer's state is never touched off-thread.
+class LiveCapacitance
+{
+public:
+    LiveCapacitance();
+    ~LiveCapacitance();
+
+    // Start the worker on a copy of the models and transforms; onResult is called from the
+    // worker after every publish (e.g. to wake the render loop), including a failed start.
+    // isRunning is false once the worker has failed; start tries again.
+    bool start(const std::vector<Model>& models, const TransformManager& transforms,
+               std::function<void()> onResult);
+    void stop();
+    bool isRunning() const;
+
+    // Queue a transform state; only the latest pending state is computed
+    void submit(const TransformManager& transforms);
+
+    // Queue replaced meshes (see CapacitanceCalculator::updateModelMeshes)
+    void updateModelMeshes(const std::vector<Model>& models, const std::vector<ModelId>& changedModels);
+
+    // Debug ray capture for the worker's passes (nullptr disables); picked up at the next pass
+    void setRayCapture(RayCapture* capture);
+
+    // Copy out the latest result if its generation is newer than lastGeneration
+    bool getLatest(LiveCapacitanceResult& result, uint64_t lastGeneration) const;
+
+private:
+    void run();
+    void publish(const std::vector<CapacitanceResult>& results, bool coarse,
+                 uint64_t transformVersion, double computeMs, const std::vector<TriangleFields>* triangleFields);
+
+    // Triangles traced per positive model in the coarse pass
+    static constexpr size_t COARSE_SAMPLES_PER_MODEL = 2048;
+
+    std::thread worker;
+    mutable std::mutex mutex;
+    std::condition_variable wake;
+    bool stopRequested;
+    std::atomic<bool> abortPass;   // Set when a newer state arrives during a full pass
+    std::atomic<bool> failed;      // Set before the worker exits on an initialization failure
+    std::atomic<RayCapture*> rayCapture;
+
+    // Pending work, guarded by mutex
+    bool hasPendingTransforms;
+    TransformManager pendingTransforms;
+    std::vector<Model> pendingModels;
+    std::vector<ModelId> pendingChangedModels;
+
+    // Models the worker's calculator is initialized with
+    std::vector<Model> initialModels;
+
+    LiveCapacitanceResult latest;  // Guarded by mutex
+    std::function<void()> onResult;
+};
+
+#endif
@@ -0,0 +1,209 @@
+#include "MeshAsset.h"
+#include "MeshCache.h"
+#include "MappedFile.h"
+#include "ObjLoader.h"
+#include "PlyLoader.h"
+#include "StlLoader.h"
+#include "Tracer.h"
+#include <algorithm>
+#include <atomic>
+#include <future>
+#include <iostream>
+#include <thread>
+
+MeshAssetStore::MeshAssetStore()
+{
+}
+
+MeshAssetStore::~MeshAssetStore()
+{
+    clear();
+}
+
+MeshAssetPtr MeshAssetStore::loadFile(const std::string& filePath)
+{
+    MeshAssetPtr existing = find(filePath);
+    if (existing) {
+        return existing;
+    }
+    
+    MeshAssetPtr mesh = loadUncached(filePath);
+    if (!mesh) {
+        return nullptr;
+    }
+    
+    // Another thread may have loaded the same file meanwhile; keep the first one
+    std::lock_guard<std::mutex> lock(assetsMutex);
+    return assets.emplace(filePath, mesh).first->second;
+}
+
+MeshAssetPtr MeshAssetStore::reloadFile(const std::string& filePath)
+{
+    MeshAssetPtr mesh = loadUncached(filePath);
+    if (!mesh) {
+        return nullptr; // Keep the resident mesh; the file may still be mid-write
+    }
+    
+    // Models holding the old mesh keep it alive until they are switched over
+    std::lock_guard<std::mutex> lock(assetsMutex);
+    assets[filePath] = mesh;
+    return mesh;
+}
+
+MeshAssetPtr MeshAssetStore::loadUncached(const std::string& filePath)
+{
+    // Points into filePath (npos + 1 is 0), so no name is built while tracing is off
+    FT_TRACE_SCOPE("models", filePath.c_str() + (filePath.find_last_of("/\\") + 1));
+    auto mesh = std::make_shared<MeshAsset>();
+    mesh->source = filePath;
+    
+    // Prefer the binary cache; parse the source and regenerate the cache when it is stale
+    if (!MeshCache::load(filePath, *mesh)) {
+        FT_TRACE_SCOPE("models", "parse and cache");
+        
+        // Read the source once: the cache stamp hashes the same mapped bytes the loader parses
+        MappedFile source;
+        if (!source.open(filePath)) {
+            std::cerr << "Failed to open mesh file: " << filePath << std::endl;
+            return nullptr;
+        }
+        MeshCache::SourceStamp stamp;
+        bool stamped = MeshCache::getSourceStamp(filePath, source.data(), source.size(), stamp);
+        
+        if (!loadSourceFile(filePath, source.data(), source.size(), *mesh)) {
+            return nullptr;
+        }
+        
+        MeshCache::prepareMesh(*mesh);
+        if (!stamped || !MeshCache::save(filePath, stamp, *mesh)) {
+            std::cerr << "Warning: mesh cache not written for " << filePath << std::endl;
+        }
+    }
+    
+    return mesh;
+}
+
+bool MeshAssetStore::loadFiles(const std::vector<std::string>& filePaths)
+{
+    // A fixed pool of workers takes files in turn, so many files do not start a thread each
+    size_t workerCount = std::min<size_t>(filePaths.size(), std::max(1u, std::thread::hardware_concurrency()));
+    std::atomic<size_t> nextFile{0};
+    std::atomic<bool> allLoaded{true};
+    
+    auto loadNext = [&]() {
+        for (size_t i = nextFile++; i < filePaths.size(); i = nextFile++) {
+            if (!loadFile(filePaths[i])) {
+                allLoaded = false;
+            }
+        }
+    };
+    
+    std::vector<std::future<void>> workers;
+    for (size_t i = 1; i < workerCount; i++) {
+        workers.push_back(std::async(std::launch::async, loadNext));
+    }
+    loadNext();
+    for (std::future<void>& worker : workers) {
+        worker.get();
+    }
+    
+    return allLoaded;
+}
+
+bool MeshAssetStore::loadSourceFile(const std::string& filePath, const char* data, size_t size, MeshAsset& mesh)
+{
+    std::string extension = getFileExtension(filePath);
+    
+    if (extension == ".stl") {
+        if (!StlLoader::loadSTL(filePath, data, size, mesh.vertices, mesh.indices, mesh.vertexCount, mesh.triangleCount)) {
+            std::cerr << "Failed to load STL: " << filePath << std::endl;
+            std::cerr << "Error: " << StlLoader::getLastError() << std::endl;
+            return false;
+        }
+        return true;
+    }
+    
+    if (extension == ".ply") {
+        if (!PlyLoader::loadPLY(filePath, data, size, mesh.vertices, mesh.indices, mesh.vertexCount, mesh.triangleCount)) {
+            std::cerr << "Failed to load PLY: " << filePath << std::endl;
+            std::cerr << "Error: " << PlyLoader::getLastError() << std::endl;
+            return false;
+        }
+        return true;
+    }
+    
+    if (!ObjLoader::loadOBJ(filePath, data, size, mesh.vertices, mesh.indices, mesh.vertexCount, mesh.triangleCount)) {
+        std::cerr << "Failed to load OBJ: " << filePath << std::endl;
+        std::cerr << "Error: " << ObjLoader::getLastError() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool MeshAssetStore::isSupportedFile(const std::string& filePath)
+{
+    std::string extension = getFileExtension(filePath);
+    return extension == ".obj" || extension == ".stl" || extension == ".ply";
+}
+
+std::string MeshAssetStore::getFileExtension(const std::string& filePath)
+{
+    size_t lastDot = filePath.find_last_of('.');
+    size_t lastSlash = filePath.find_last_of("/\\");
+    if (lastDot == std::string::npos || (lastSlash != std::string::npos && lastDot < lastSlash)) {
+        return "";
+    }
+    
+    std::string extension = filePath.substr(lastDot);
+    std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+    return extension;
+}
+
+MeshAssetPtr MeshAssetStore::addGenerated(const std::string& key,
+                                          std::vector<float>&& vertices,
+                                          std::vector<unsigned int>&& indices)
+{
+    MeshAssetPtr existing = find(key);
+    if (existing) {
+        return existing;
+    }
+    
+    auto mesh = std::make_shared<MeshAsset>();
+    mesh->source = key;
+    mesh->vertices = std::move(vertices);
+    mesh->indices = std::move(indices);
+    MeshCache::prepareMesh(*mesh);
+    
+    std::lock_guard<std::mutex> lock(assetsMutex);
+    return assets.emplace(key, mesh).first->second;
+}
+
+MeshAssetPtr MeshAssetStore::find(const std::string& key) const
+{
+    std::lock_guard<std::mutex> lock(assetsMutex);
+    auto it = assets.find(key);
+    return it != assets.end() ? it->second : nullptr;
+}
+
+size_t MeshAssetStore::size() const
+{
+    std::lock_guard<std::mutex> lock(assetsMutex);
+    return assets.size();
+}
+
+size_t MeshAssetStore::getResidentBytes() const
+{
+    std::lock_guard<std::mutex> lock(assetsMutex);
+    size_t bytes = 0;
+    for (const auto& entry : assets) {
+        bytes += entry.second->vertices.size() * sizeof(float);
+        bytes += entry.second->indices.size() * sizeof(unsigned int);
+    }
+    return bytes;
+}
+
+void MeshAssetStore::clear()
+{
+    std::lock_guard<std::mutex> lock(assetsMutex);
+    assets.clear();
+}
@@ -0,0 +1,74 @@
+#ifndef MESHASSET_H
+#define MESHASSET_H
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Immutable CPU-side mesh data, shared by every model instance that uses it
+struct MeshAsset {
+    std::vector<float> vertices;        // Vertex positions (x, y, z)
+    std::vector<unsigned int> indices;  // Triangle indices (spatially sorted)
+    std::vector<float> triangleNormals; // Unit normal per triangle (x, y, z)
+    std::vector<float> triangleAreas;   // Area per triangle
+    std::string source;                 // File path or generator key the mesh was created from
+    
+    // Mesh statistics
+    size_t vertexCount = 0;
+    size_t triangleCount = 0;
+};
+
+using MeshAssetPtr = std::shared_ptr<const MeshAsset>;
+
+// Ref-counted store holding one mesh per unique file (or generated shape).
+// Loading the same source twice returns the already resident mesh.
+// All methods are safe to call from several threads.
+class MeshAssetStore
+{
+public:
+    MeshAssetStore();
+    ~MeshAssetStore();
+
+    // Load a mesh file, or return the cached mesh (nullptr on failure)
+    MeshAssetPtr loadFile(const std::string& filePath);
+
+    // Re-read a mesh file that changed on disk and replace the resident mesh
+    // (nullptr on failure, in which case the previous mesh stays resident)
+    MeshAssetPtr reloadFile(const std::string& filePath);
+
+    // Load several mesh files concurrently; returns false if any failed
+    bool loadFiles(const std::vector<std::string>& filePaths);
+
+    // Store generated geometry under a key, or return the mesh already stored under it
+    MeshAssetPtr addGenerated(const std::string& key,
+                              std::vector<float>&& vertices,
+                              std::vector<unsigned int>&& indices);
+
+    // Look up a mesh by file path or generator key (nullptr if not resident)
+    MeshAssetPtr find(const std::string& key) const;
+
+    // Number of unique meshes and the bytes of vertex/index data they hold
+    size_t size() const;
+    size_t getResidentBytes() const;
+
+    // Drop the store's references (meshes stay alive while models still use them)
+    void clear();
+
+    // True for mesh formats loadFile understands (.obj, .stl, .ply)
+    static bool isSupportedFile(const std::string& filePath);
+
+private:
+    std::unordered_map<std::string, MeshAssetPtr> assets;
+    mutable std::mutex assetsMutex;  // Guards assets; loading itself runs unlocked
+
+    // Load through the binary cache without consulting the resident meshes
+    static MeshAssetPtr loadUncached(const std::string& filePath);
+
+    // Parse a mapped source file with the loader matching its extension
+    static bool loadSourceFile(const std::string& filePath, const char* data, size_t size, MeshAsset& mesh);
+    static std::string getFileExtension(const std::string& filePath);
+};
+
+#endif
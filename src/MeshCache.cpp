@@ -0,0 +1,381 @@
+#include "MeshCache.h"
+#include "MappedFile.h"
+#include <algorithm>
+#include <cfloat>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <unordered_map>
+#include <utility>
+
+namespace {
+
+// On-disk layout: header, then positions (3 floats per vertex), indices
+// (3 per triangle), normals (3 floats per triangle) and areas (1 per triangle)
+struct MeshCacheHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t sourceSize;
+    int64_t sourceModifiedTime;
+    uint64_t sourceHash;
+    uint64_t vertexCount;
+    uint64_t triangleCount;
+};
+
+constexpr char CACHE_MAGIC[4] = {'F', 'T', 'M', 'C'};
+
+size_t getPayloadSize(uint64_t vertexCount, uint64_t triangleCount)
+{
+    return static_cast<size_t>(vertexCount * 3 * sizeof(float) +
+                               triangleCount * 3 * sizeof(unsigned int) +
+                               triangleCount * 3 * sizeof(float) +
+                               triangleCount * sizeof(float));
+}
+
+// Bitwise key for welding; +0.0f folds -0.0 into 0.0
+struct PositionKey {
+    uint32_t bits[3];
+    
+    bool operator==(const PositionKey& other) const
+    {
+        return bits[0] == other.bits[0] && bits[1] == other.bits[1] && bits[2] == other.bits[2];
+    }
+};
+
+struct PositionKeyHash {
+    size_t operator()(const PositionKey& key) const
+    {
+        uint64_t h = key.bits[0];
+        h = h * 0x9E3779B97F4A7C15ull ^ key.bits[1];
+        h = h * 0x9E3779B97F4A7C15ull ^ key.bits[2];
+        return static_cast<size_t>(h ^ (h >> 29));
+    }
+};
+
+} // namespace
+
+bool MeshCache::load(const std::string& sourcePath, MeshAsset& mesh)
+{
+    MappedFile cacheFile;
+    if (!cacheFile.open(getCachePath(sourcePath)) || cacheFile.size() < sizeof(MeshCacheHeader)) {
+        return false;
+    }
+    
+    MeshCacheHeader header;
+    std::memcpy(&header, cacheFile.data(), sizeof(header));
+    
+    if (std::memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0 || header.version != CACHE_VERSION) {
+        return false;
+    }
+    
+    if (cacheFile.size() != sizeof(MeshCacheHeader) + getPayloadSize(header.vertexCount, header.triangleCount)) {
+        std::cerr << "Ignoring truncated mesh cache for: " << sourcePath << std::endl;
+        return false;
+    }
+    
+    // Cheap check first; only hash the source when the timestamp moved (e.g. fresh checkout)
+    SourceStamp stamp;
+    if (!getSourceStamp(sourcePath, stamp) || stamp.size != header.sourceSize) {
+        return false;
+    }
+    if (stamp.modifiedTime != header.sourceModifiedTime) {
+        uint64_t hash = 0;
+        if (!hashSourceFile(sourcePath, hash) || hash != header.sourceHash) {
+            return false;
+        }
+    }
+    
+    // The payload is copied out: MeshAsset owns its arrays, which outlive the mapping and are
+    // shared by the renderer and the calculators. Mapping saves the read into a staging buffer.
+    const char* cursor = cacheFile.data() + sizeof(MeshCacheHeader);
+    
+    mesh.vertices.resize(header.vertexCount * 3);
+    std::memcpy(mesh.vertices.data(), cursor, mesh.vertices.size() * sizeof(float));
+    cursor += mesh.vertices.size() * sizeof(float);
+    
+    mesh.indices.resize(header.triangleCount * 3);
+    std::memcpy(mesh.indices.data(), cursor, mesh.indices.size() * sizeof(unsigned int));
+    cursor += mesh.indices.size() * sizeof(unsigned int);
+    
+    mesh.triangleNormals.resize(header.triangleCount * 3);
+    std::memcpy(mesh.triangleNormals.data(), cursor, mesh.triangleNormals.size() * sizeof(float));
+    cursor += mesh.triangleNormals.size() * sizeof(float);
+    
+    mesh.triangleAreas.resize(header.triangleCount);
+    std::memcpy(mesh.triangleAreas.data(), cursor, mesh.triangleAreas.size() * sizeof(float));
+    
+    mesh.vertexCount = static_cast<size_t>(header.vertexCount);
+    mesh.triangleCount = static_cast<size_t>(header.triangleCount);
+    
+    // The content matched under a new timestamp (checkout, touch): record the new timestamp so
+    // the next load does not hash the source again
+    if (stamp.modifiedTime != header.sourceModifiedTime) {
+        cacheFile.close();
+        std::fstream file(getCachePath(sourcePath), std::ios::binary | std::ios::in | std::ios::out);
+        if (file.is_open()) {
+            file.seekp(offsetof(MeshCacheHeader, sourceModifiedTime));
+            file.write(reinterpret_cast<const char*>(&stamp.modifiedTime), sizeof(stamp.modifiedTime));
+        }
+    }
+    
+    return true;
+}
+
+bool MeshCache::getSourceStamp(const std::string& sourcePath, const char* data, size_t size, SourceStamp& stamp)
+{
+    if (!getSourceStamp(sourcePath, stamp) || stamp.size != size) {
+        return false; // Changed since it was read
+    }
+    
+    stamp.contentHash = hashBytes(data, size);
+    return true;
+}
+
+bool MeshCache::save(const std::string& sourcePath, const SourceStamp& stamp, const MeshAsset& mesh)
+{
+    MeshCacheHeader header;
+    std::memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    header.version = CACHE_VERSION;
+    header.sourceSize = stamp.size;
+    header.sourceModifiedTime = stamp.modifiedTime;
+    header.sourceHash = stamp.contentHash;
+    header.vertexCount = mesh.vertices.size() / 3;
+    header.triangleCount = mesh.indices.size() / 3;
+    
+    std::string cachePath = getCachePath(sourcePath);
+    std::string tempPath = cachePath + ".tmp";
+    
+    std::error_code error;
+    std::filesystem::create_directories(std::filesystem::path(cachePath).parent_path(), error);
+    
+    // Write to a temporary file and rename, so a crash never leaves a half-written cache
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            std::cerr << "Could not write mesh cache: " << tempPath << std::endl;
+            return false;
+        }
+        
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(mesh.vertices.data()), mesh.vertices.size() * sizeof(float));
+        file.write(reinterpret_cast<const char*>(mesh.indices.data()), mesh.indices.size() * sizeof(unsigned int));
+        file.write(reinterpret_cast<const char*>(mesh.triangleNormals.data()), mesh.triangleNormals.size() * sizeof(float));
+        file.write(reinterpret_cast<const char*>(mesh.triangleAreas.data()), mesh.triangleAreas.size() * sizeof(float));
+        
+        if (!file.good()) {
+            std::cerr << "Failed writing mesh cache: " << tempPath << std::endl;
+            file.close();
+            std::filesystem::remove(tempPath, error);
+            return false;
+        }
+    }
+    
+    std::filesystem::rename(tempPath, cachePath, error);
+    if (error) {
+        std::cerr << "Could not replace mesh cache " << cachePath << ": " << error.message() << std::endl;
+        std::filesystem::remove(tempPath, error);
+        return false;
+    }
+    
+    return true;
+}
+
+void MeshCache::prepareMesh(MeshAsset& mesh)
+{
+    weldVertices(mesh);
+    sortTrianglesSpatially(mesh);
+    computeTriangleAttributes(mesh);
+    
+    mesh.vertexCount = mesh.vertices.size() / 3;
+    mesh.triangleCount = mesh.indices.size() / 3;
+}
+
+std::string MeshCache::getCachePath(const std::string& sourcePath)
+{
+    std::filesystem::path source(sourcePath);
+    return (source.parent_path() / ".meshcache" / (source.filename().string() + ".ftmesh")).string();
+}
+
+bool MeshCache::getSourceStamp(const std::string& sourcePath, SourceStamp& stamp)
+{
+    std::error_code error;
+    stamp.size = std::filesystem::file_size(sourcePath, error);
+    if (error) {
+        return false;
+    }
+    
+    auto modified = std::filesystem::last_write_time(sourcePath, error);
+    if (error) {
+        return false;
+    }
+    
+    stamp.modifiedTime = static_cast<int64_t>(modified.time_since_epoch().count());
+    return true;
+}
+
+bool MeshCache::hashSourceFile(const std::string& sourcePath, uint64_t& hash)
+{
+    MappedFile source;
+    if (!source.open(sourcePath)) {
+        return false;
+    }
+    
+    hash = hashBytes(source.data(), source.size());
+    return true;
+}
+
+uint64_t MeshCache::hashBytes(const char* data, size_t size)
+{
+    // FNV-1a, 64-bit
+    uint64_t hash = 0xCBF29CE484222325ull;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= 0x100000001B3ull;
+    }
+    return hash;
+}
+
+void MeshCache::weldVertices(MeshAsset& mesh)
+{
+    size_t vertexCount = mesh.vertices.size() / 3;
+    
+    std::unordered_map<PositionKey, unsigned int, PositionKeyHash> uniquePositions;
+    uniquePositions.reserve(vertexCount);
+    
+    std::vector<unsigned int> remap(vertexCount);
+    std::vector<float> welded;
+    welded.reserve(mesh.vertices.size());
+    
+    for (size_t i = 0; i < vertexCount; i++) {
+        PositionKey key;
+        for (int axis = 0; axis < 3; axis++) {
+            float value = mesh.vertices[i * 3 + axis] + 0.0f;
+            std::memcpy(&key.bits[axis], &value, sizeof(float));
+        }
+        
+        auto inserted = uniquePositions.emplace(key, static_cast<unsigned int>(welded.size() / 3));
+        if (inserted.second) {
+            welded.push_back(mesh.vertices[i * 3]);
+            welded.push_back(mesh.vertices[i * 3 + 1]);
+            welded.push_back(mesh.vertices[i * 3 + 2]);
+        }
+        remap[i] = inserted.first->second;
+    }
+    
+    // Drop triangles with out-of-range indices while remapping
+    size_t validIndices = 0;
+    for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3) {
+        if (mesh.indices[i] >= vertexCount || mesh.indices[i + 1] >= vertexCount || mesh.indices[i + 2] >= vertexCount) {
+            continue;
+        }
+        mesh.indices[validIndices++] = remap[mesh.indices[i]];
+        mesh.indices[validIndices++] = remap[mesh.indices[i + 1]];
+        mesh.indices[validIndices++] = remap[mesh.indices[i + 2]];
+    }
+    mesh.indices.resize(validIndices);
+    
+    mesh.vertices = std::move(welded);
+}
+
+void MeshCache::sortTrianglesSpatially(MeshAsset& mesh)
+{
+    size_t triangleCount = mesh.indices.size() / 3;
+    if (triangleCount == 0) {
+        return;
+    }
+    
+    auto vertexAt = [&mesh](unsigned int index) {
+        return glm::vec3(mesh.vertices[index * 3], mesh.vertices[index * 3 + 1], mesh.vertices[index * 3 + 2]);
+    };
+    
+    // Bounds of the triangle centroids
+    std::vector<glm::vec3> centroids(triangleCount);
+    glm::vec3 minBound(FLT_MAX);
+    glm::vec3 maxBound(-FLT_MAX);
+    for (size_t t = 0; t < triangleCount; t++) {
+        centroids[t] = (vertexAt(mesh.indices[t * 3]) + vertexAt(mesh.indices[t * 3 + 1]) + vertexAt(mesh.indices[t * 3 + 2])) / 3.0f;
+        minBound = glm::min(minBound, centroids[t]);
+        maxBound = glm::max(maxBound, centroids[t]);
+    }
+    
+    glm::vec3 extent = maxBound - minBound;
+    glm::vec3 scale(extent.x > 0.0f ? 1.0f / extent.x : 0.0f,
+                    extent.y > 0.0f ? 1.0f / extent.y : 0.0f,
+                    extent.z > 0.0f ? 1.0f / extent.z : 0.0f);
+    
+    std::vector<std::pair<uint32_t, uint32_t>> order(triangleCount); // (Morton code, triangle)
+    for (size_t t = 0; t < triangleCount; t++) {
+        order[t].first = mortonCode((centroids[t] - minBound) * scale);
+        order[t].second = static_cast<uint32_t>(t);
+    }
+    std::sort(order.begin(), order.end());
+    
+    // Reorder triangles, and renumber vertices by first use so they follow the same order
+    const unsigned int unassigned = 0xFFFFFFFFu;
+    std::vector<unsigned int> vertexRemap(mesh.vertices.size() / 3, unassigned);
+    std::vector<unsigned int> sortedIndices(mesh.indices.size());
+    std::vector<float> sortedVertices;
+    sortedVertices.reserve(mesh.vertices.size());
+    
+    for (size_t t = 0; t < triangleCount; t++) {
+        size_t source = order[t].second;
+        for (int corner = 0; corner < 3; corner++) {
+            unsigned int oldIndex = mesh.indices[source * 3 + corner];
+            if (vertexRemap[oldIndex] == unassigned) {
+                vertexRemap[oldIndex] = static_cast<unsigned int>(sortedVertices.size() / 3);
+                sortedVertices.push_back(mesh.vertices[oldIndex * 3]);
+                sortedVertices.push_back(mesh.vertices[oldIndex * 3 + 1]);
+                sortedVertices.push_back(mesh.vertices[oldIndex * 3 + 2]);
+            }
+            sortedIndices[t * 3 + corner] = vertexRemap[oldIndex];
+        }
+    }
+    
+    mesh.indices = std::move(sortedIndices);
+    mesh.vertices = std::move(sortedVertices); // Unreferenced vertices are dropped
+}
+
+void MeshCache::computeTriangleAttributes(MeshAsset& mesh)
+{
+    size_t triangleCount = mesh.indices.size() / 3;
+    mesh.triangleNormals.resize(triangleCount * 3);
+    mesh.triangleAreas.resize(triangleCount);
+    
+    for (size_t t = 0; t < triangleCount; t++) {
+        const float* p0 = &mesh.vertices[mesh.indices[t * 3] * 3];
+        const float* p1 = &mesh.vertices[mesh.indices[t * 3 + 1] * 3];
+        const float* p2 = &mesh.vertices[mesh.indices[t * 3 + 2] * 3];
+        
+        glm::vec3 v0(p0[0], p0[1], p0[2]);
+        glm::vec3 cross = glm::cross(glm::vec3(p1[0], p1[1], p1[2]) - v0, glm::vec3(p2[0], p2[1], p2[2]) - v0);
+        float length = glm::length(cross);
+        
+        // Same conventions as CapacitanceCalculator: degenerate triangles face +Z
+        glm::vec3 normal = length > 0.0f ? cross / length : glm::vec3(0.0f, 0.0f, 1.0f);
+        mesh.triangleNormals[t * 3] = normal.x;
+        mesh.triangleNormals[t * 3 + 1] = normal.y;
+        mesh.triangleNormals[t * 3 + 2] = normal.z;
+        mesh.triangleAreas[t] = 0.5f * length;
+    }
+}
+
+uint32_t MeshCache::mortonCode(const glm::vec3& unitPosition)
+{
+    // 10 bits per axis
+    uint32_t x = static_cast<uint32_t>(glm::clamp(unitPosition.x * 1023.0f, 0.0f, 1023.0f));
+    uint32_t y = static_cast<uint32_t>(glm::clamp(unitPosition.y * 1023.0f, 0.0f, 1023.0f));
+    uint32_t z = static_cast<uint32_t>(glm::clamp(unitPosition.z * 1023.0f, 0.0f, 1023.0f));
+    return (expandBits(x) << 2) | (expandBits(y) << 1) | expandBits(z);
+}
+
+uint32_t MeshCache::expandBits(uint32_t value)
+{
+    // Spread the low 10 bits so there are two zero bits between each
+    value = (value * 0x00010001u) & 0xFF0000FFu;
+    value = (value * 0x00000101u) & 0x0F00F00Fu;
+    value = (value * 0x00000011u) & 0xC30C30C3u;
+    value = (value * 0x00000005u) & 0x49249249u;
+    return value;
+}
@@ -0,0 +1,56 @@
+#ifndef MESHCACHE_H
+#define MESHCACHE_H
+
+#include <cstdint>
+#include <string>
+#include <glm/glm.hpp>
+#include "MeshAsset.h"
+
+// Versioned binary cache of prepared meshes, stored next to the source file in
+// a .meshcache directory. A cache entry is valid while the source file's size
+// and modification time (or, failing that, its content hash) still match.
+class MeshCache
+{
+public:
+    // Identity of the source file a cache entry was built from
+    struct SourceStamp {
+        uint64_t size = 0;
+        int64_t modifiedTime = 0;
+        uint64_t contentHash = 0;
+    };
+
+    // Load a prepared mesh from the cache; false if missing, stale or corrupt. When only the
+    // timestamp moved and the content hash still matches, the entry's timestamp is updated
+    // so later loads take the cheap check again.
+    static bool load(const std::string& sourcePath, MeshAsset& mesh);
+
+    // Stamp of a source file whose bytes are in memory (hashed here, while they are hot)
+    static bool getSourceStamp(const std::string& sourcePath, const char* data, size_t size, SourceStamp& stamp);
+
+    // Write the cache entry for a mesh prepared from a source with the given stamp
+    static bool save(const std::string& sourcePath, const SourceStamp& stamp, const MeshAsset& mesh);
+
+    // Weld duplicate positions, sort triangles along a Morton curve and
+    // compute per-triangle normals and areas
+    static void prepareMesh(MeshAsset& mesh);
+
+    // Cache file used for a source file
+    static std::string getCachePath(const std::string& sourcePath);
+
+private:
+    // Bump whenever the file layout or the preparation steps change
+    static constexpr uint32_t CACHE_VERSION = 1;
+
+    static bool getSourceStamp(const std::string& sourcePath, SourceStamp& stamp);
+    static bool hashSourceFile(const std::string& sourcePath, uint64_t& hash);
+    static uint64_t hashBytes(const char* data, size_t size);
+
+    // Mesh preparation steps
+    static void weldVertices(MeshAsset& mesh);
+    static void sortTrianglesSpatially(MeshAsset& mesh);
+    static void computeTriangleAttributes(MeshAsset& mesh);
+    static uint32_t mortonCode(const glm::vec3& unitPosition);
+    static uint32_t expandBits(uint32_t value);
+};
+
+#endif
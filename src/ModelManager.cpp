@@ -1,5 +1,5 @@
 #include "ModelManager.h"
-#include "ObjLoader.h"
+#include "Tracer.h"
 #include <iostream>
 #include <filesystem>
 #include <algorithm>
@@ -21,24 +21,32 @@ ModelManager::~ModelManager()
 
 bool ModelManager::loadAllModels(const std::string& directory)
 {
+    FT_TRACE_SCOPE("models", "loadAllModels");
     std::cout << "Loading models from directory: " << directory << std::endl;
     
-    // Get all .obj files in the directory
-    std::vector<std::string> objFiles = getObjFilesInDirectory(directory);
+    // Get all mesh files (.obj, .stl, .ply) in the directory
+    std::vector<std::string> meshFiles = getMeshFilesInDirectory(directory);
     
-    if (objFiles.empty()) {
-        std::cerr << "No .obj files found in directory: " << directory << std::endl;
+    if (meshFiles.empty()) {
+        std::cerr << "No mesh files found in directory: " << directory << std::endl;
         return false;
     }
     
-    // Load each OBJ file with specific positioning and colors
+    // Parse all mesh files concurrently; the placements below then reuse the loaded meshes
     bool allLoaded = true;
+    if (!meshStore.loadFiles(meshFiles)) {
+        std::cerr << "Some mesh files failed to load" << std::endl;
+    }
+    
+    // Load each mesh file with specific positioning and colors
+    std::string stationaryPath;
     
-    for (const std::string& filePath : objFiles) {
+    for (const std::string& filePath : meshFiles) {
         std::string fileName = getFileNameWithoutExtension(filePath);
         
         // Skip stationary_negative here, we'll load it separately
         if (fileName == "stationary_negative") {
+            stationaryPath = filePath;
             continue;
         }
         
@@ -52,12 +60,11 @@ bool ModelManager::loadAllModels(const std::string& directory)
         }
     }
     
-    // Load 3 copies of stationary_negative at group positions
-    std::string stationaryPath = directory;
-    if (!stationaryPath.empty() && stationaryPath.back() != '/' && stationaryPath.back() != '\\') {
-        stationaryPath += "/";
+    // Load 3 copies of stationary_negative at group positions (they share one mesh)
+    if (stationaryPath.empty()) {
+        std::cerr << "No stationary_negative mesh found in directory: " << directory << std::endl;
+        allLoaded = false;
     }
-    stationaryPath += "stationary_negative.obj";
     
     // Load stationary_negative at A group position
     glm::vec3 posA = getModelPosition("A1_model");
@@ -91,14 +98,13 @@ bool ModelManager::loadAllModels(const std::string& directory)
         sphereModel.subGroupType = SubGroupType::Individual;
         sphereModel.parentGroupType = ParentGroupType::Positiv;
         
-        // Generate sphere geometry (2mm diameter = 1mm radius)
-        if (!generateSphere(1.0f, 16, sphereModel.vertices, sphereModel.indices)) {
+        // All spheres share one generated mesh (2mm diameter = 1mm radius)
+        sphereModel.mesh = getSphereMesh(1.0f, 16);
+        if (!sphereModel.mesh) {
             std::cerr << "Failed to generate " << sphereName << " sphere" << std::endl;
             allLoaded = false;
-        } else {
-            sphereModel.vertexCount = sphereModel.vertices.size() / 3;
-            sphereModel.triangleCount = sphereModel.indices.size() / 3;
-            models.push_back(sphereModel);
+        } else if (!addModel(sphereModel)) {
+            allLoaded = false;
         }
     }
     
@@ -113,14 +119,13 @@ bool ModelManager::loadAllModels(const std::string& directory)
         sphereModel.subGroupType = SubGroupType::Individual;
         sphereModel.parentGroupType = ParentGroupType::Positiv;
         
-        // Generate sphere geometry (2mm diameter = 2mm radius)
-        if (!generateSphere(1.0f, 16, sphereModel.vertices, sphereModel.indices)) {
+        // All spheres share one generated mesh (2mm diameter = 1mm radius)
+        sphereModel.mesh = getSphereMesh(1.0f, 16);
+        if (!sphereModel.mesh) {
             std::cerr << "Failed to generate " << sphereName << " sphere" << std::endl;
             allLoaded = false;
-        } else {
-            sphereModel.vertexCount = sphereModel.vertices.size() / 3;
-            sphereModel.triangleCount = sphereModel.indices.size() / 3;
-            models.push_back(sphereModel);
+        } else if (!addModel(sphereModel)) {
+            allLoaded = false;
         }
     }
     
@@ -135,14 +140,13 @@ bool ModelManager::loadAllModels(const std::string& directory)
         sphereModel.subGroupType = SubGroupType::Individual;
         sphereModel.parentGroupType = ParentGroupType::Positiv;
         
-        // Generate sphere geometry (2mm diameter = 2mm radius)
-        if (!generateSphere(1.0f, 16, sphereModel.vertices, sphereModel.indices)) {
+        // All spheres share one generated mesh (2mm diameter = 1mm radius)
+        sphereModel.mesh = getSphereMesh(1.0f, 16);
+        if (!sphereModel.mesh) {
             std::cerr << "Failed to generate " << sphereName << " sphere" << std::endl;
             allLoaded = false;
-        } else {
-            sphereModel.vertexCount = sphereModel.vertices.size() / 3;
-            sphereModel.triangleCount = sphereModel.indices.size() / 3;
-            models.push_back(sphereModel);
+        } else if (!addModel(sphereModel)) {
+            allLoaded = false;
         }
     }
     
@@ -166,19 +170,46 @@ bool ModelManager::loadModelAtPosition(const std::string& filePath, const std::s
     model.subGroupType = SubGroupType::Individual; // Will be assigned later
     model.parentGroupType = ParentGroupType::Positiv; // Will be assigned later
     
-    // Load OBJ file
-    if (!ObjLoader::loadOBJ(filePath, model.vertices, model.indices, model.vertexCount, model.triangleCount)) {
-        std::cerr << "Failed to load OBJ: " << filePath << std::endl;
-        std::cerr << "Error: " << ObjLoader::getLastError() << std::endl;
+    // Load OBJ file (models placed from the same file share one mesh)
+    model.mesh = meshStore.loadFile(filePath);
+    if (!model.mesh) {
         return false;
     }
     
     // Add to models list
-    models.push_back(model);
+    return addModel(model);
+}
+
+bool ModelManager::addModel(Model& model)
+{
+    // IDs are dense and follow load order, so a model's ID is also its index
+    model.id = registry.registerModel(model.name);
+    if (model.id != models.size()) {
+        std::cerr << "Duplicate model name: " << model.name << std::endl;
+        return false;
+    }
     
+    models.push_back(model);
     return true;
 }
 
+MeshAssetPtr ModelManager::getSphereMesh(float radius, int subdivisions)
+{
+    std::string key = "sphere:" + std::to_string(radius) + ":" + std::to_string(subdivisions);
+    MeshAssetPtr mesh = meshStore.find(key);
+    if (mesh) {
+        return mesh;
+    }
+    
+    std::vector<float> vertices;
+    std::vector<unsigned int> indices;
+    if (!generateSphere(radius, subdivisions, vertices, indices)) {
+        return nullptr;
+    }
+    
+    return meshStore.addGenerated(key, std::move(vertices), std::move(indices));
+}
+
 bool ModelManager::generateSphere(float radius, int subdivisions, std::vector<float>& vertices, std::vector<unsigned int>& indices)
 {
     vertices.clear();
@@ -226,19 +257,63 @@ bool ModelManager::generateSphere(float radius, int subdivisions, std::vector<fl
 void ModelManager::assignModelGroups(TransformManager& transformManager)
 {
     for (Model& model : models) {
+        // Resolve name-based placement once so later lookups can use the ID
+        transformManager.registerModel(model.id, model.name);
+        
         // Assign sub-group
-        model.subGroupType = transformManager.getModelSubGroup(model.name);
+        model.subGroupType = transformManager.getModelSubGroup(model.id);
         
         // Assign parent group based on sub-group
         model.parentGroupType = transformManager.getSubGroupParent(model.subGroupType);
     }
 }
 
+bool ModelManager::reloadMeshFile(const std::string& filePath, std::vector<ModelId>& changedModels)
+{
+    changedModels.clear();
+    std::filesystem::path changedPath = std::filesystem::path(filePath).lexically_normal();
+    
+    // Find the resident mesh loaded from this file
+    std::string sourcePath;
+    for (const Model& model : models) {
+        if (model.mesh && std::filesystem::path(model.mesh->source).lexically_normal() == changedPath) {
+            sourcePath = model.mesh->source;
+            break;
+        }
+    }
+    
+    if (sourcePath.empty()) {
+        return false; // Not a loaded model (new files need a restart)
+    }
+    
+    MeshAssetPtr mesh = meshStore.reloadFile(sourcePath);
+    if (!mesh) {
+        std::cerr << "Failed to reload " << filePath << "; keeping the previous mesh" << std::endl;
+        return false;
+    }
+    
+    for (Model& model : models) {
+        if (model.mesh && model.mesh->source == sourcePath) {
+            model.mesh = mesh;
+            changedModels.push_back(model.id);
+        }
+    }
+    
+    std::cout << "Reloaded " << filePath << " (" << mesh->triangleCount << " triangles, " 
+              << changedModels.size() << " models)" << std::endl;
+    return true;
+}
+
 const std::vector<Model>& ModelManager::getModels() const
 {
     return models;
 }
 
+const ModelRegistry& ModelManager::getRegistry() const
+{
+    return registry;
+}
+
 size_t ModelManager::getModelCount() const
 {
     return models.size();
@@ -264,16 +339,19 @@ void ModelManager::printModelStats() const
     
     for (size_t i = 0; i < models.size(); i++) {
         const Model& model = models[i];
-        totalVertices += model.vertexCount;
-        totalTriangles += model.triangleCount;
+        totalVertices += model.mesh->vertexCount;
+        totalTriangles += model.mesh->triangleCount;
     }
     
     std::cout << "Total: " << totalVertices << " vertices, " << totalTriangles << " triangles across " << models.size() << " models" << std::endl;
+    std::cout << "Unique meshes: " << meshStore.size() << " (" << meshStore.getResidentBytes() / 1024 << " KB resident)" << std::endl;
 }
 
 void ModelManager::clear()
 {
     models.clear();
+    registry.clear();
+    meshStore.clear();
 }
 
 void ModelManager::initializeColors()
@@ -308,27 +386,17 @@ std::string ModelManager::getFileNameWithoutExtension(const std::string& filePat
     return filePath.substr(start, end - start);
 }
 
-bool ModelManager::isObjFile(const std::string& fileName)
-{
-    if (fileName.length() < 4) return false;
-    
-    std::string extension = fileName.substr(fileName.length() - 4);
-    std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
-    
-    return extension == ".obj";
-}
-
-std::vector<std::string> ModelManager::getObjFilesInDirectory(const std::string& directory)
+std::vector<std::string> ModelManager::getMeshFilesInDirectory(const std::string& directory)
 {
-    std::vector<std::string> objFiles;
+    std::vector<std::string> foundFiles;
     
     try {
         // Use filesystem to iterate through directory
         for (const auto& entry : std::filesystem::directory_iterator(directory)) {
             if (entry.is_regular_file()) {
                 std::string fileName = entry.path().filename().string();
-                if (isObjFile(fileName)) {
-                    objFiles.push_back(entry.path().string());
+                if (MeshAssetStore::isSupportedFile(fileName)) {
+                    foundFiles.push_back(entry.path().string());
                 }
             }
         }
@@ -347,16 +415,27 @@ std::vector<std::string> ModelManager::getObjFilesInDirectory(const std::string&
                 fullPath += "/";
             }
             fullPath += file;
-            objFiles.push_back(fullPath);
+            foundFiles.push_back(fullPath);
         }
         
-        std::cout << "Using fallback file list with " << objFiles.size() << " files" << std::endl;
+        std::cout << "Using fallback file list with " << foundFiles.size() << " files" << std::endl;
     }
     
     // Sort the files for consistent loading order
-    std::sort(objFiles.begin(), objFiles.end());
+    std::sort(foundFiles.begin(), foundFiles.end());
+    
+    // One file per model name: the first format in sort order (.obj, .ply, .stl) wins
+    std::vector<std::string> meshFiles;
+    for (const std::string& filePath : foundFiles) {
+        if (!meshFiles.empty() && 
+            getFileNameWithoutExtension(meshFiles.back()) == getFileNameWithoutExtension(filePath)) {
+            std::cout << "Skipping duplicate model file: " << filePath << std::endl;
+            continue;
+        }
+        meshFiles.push_back(filePath);
+    }
     
-    return objFiles;
+    return meshFiles;
 }
 
 glm::vec3 ModelManager::getModelPosition(const std::string& modelName)
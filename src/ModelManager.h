@@ -4,29 +4,22 @@
 #include <vector>
 #include <string>
 #include <glm/glm.hpp>
+#include "MeshAsset.h"
+#include "ModelRegistry.h"
 #include "Transform.h"
 
-// Structure to hold model data
+// Lightweight model instance; geometry lives in a shared MeshAsset
 struct Model {
-    std::vector<float> vertices;        // Vertex positions (x, y, z)
-    std::vector<unsigned int> indices;  // Face indices
+    MeshAssetPtr mesh;                 // Shared immutable mesh data
     glm::vec3 color;                   // Model color
     glm::vec3 position;                // Model position in world space
-    std::string name;                  // Model name
+    std::string name;                  // Model name (I/O only; use id for lookups)
+    ModelId id = INVALID_MODEL_ID;     // Dense ID, equal to the model's index in ModelManager
     SubGroupType subGroupType;         // Sub-group assignment
     ParentGroupType parentGroupType;   // Parent group assignment
-    
-    // OpenGL buffer objects (will be set by renderer)
-    unsigned int VAO = 0;
-    unsigned int VBO = 0;
-    unsigned int EBO = 0;
-    
-    // Model statistics
-    size_t vertexCount = 0;
-    size_t triangleCount = 0;
 };
 
-// Class to manage loading and storing multiple OBJ models
+// Class to manage loading and storing multiple mesh models
 class ModelManager
 {
 public:
@@ -43,6 +36,9 @@ public:
     bool loadModelAtPosition(const std::string& filePath, const std::string& modelName, 
                             const glm::vec3& color, const glm::vec3& position);
 
+    // Shared sphere mesh, generated on first use
+    MeshAssetPtr getSphereMesh(float radius, int subdivisions);
+
     // Generate sphere geometry
     bool generateSphere(float radius, int subdivisions, std::vector<float>& vertices, std::vector<unsigned int>& indices);
 
@@ -52,9 +48,16 @@ public:
     // Get model count
     size_t getModelCount() const;
 
-    // Get model by index
+    // Get model by index (same as by ModelId)
     const Model& getModel(size_t index) const;
 
+    // Name <-> ID mapping for loaded models
+    const ModelRegistry& getRegistry() const;
+
+    // Reload a changed mesh file and point every model using it at the new mesh.
+    // Returns false if the file is not used by any model or failed to load.
+    bool reloadMeshFile(const std::string& filePath, std::vector<ModelId>& changedModels);
+
     // Print model statistics
     void printModelStats() const;
 
@@ -66,6 +69,11 @@ public:
 
 private:
     std::vector<Model> models;
+    ModelRegistry registry;
+    MeshAssetStore meshStore;
+
+    // Assign the next dense ID and store the model
+    bool addModel(Model& model);
 
     // Predefined colors for models
     std::vector<glm::vec3> modelColors;
@@ -76,11 +84,8 @@ private:
     // Get file name without extension
     std::string getFileNameWithoutExtension(const std::string& filePath);
 
-    // Check if file has .obj extension
-    bool isObjFile(const std::string& fileName);
-
-    // Get all .obj files in directory
-    std::vector<std::string> getObjFilesInDirectory(const std::string& directory);
+    // Get all supported mesh files (.obj, .stl, .ply) in directory
+    std::vector<std::string> getMeshFilesInDirectory(const std::string& directory);
 
     // Get model position based on name
     glm::vec3 getModelPosition(const std::string& modelName);
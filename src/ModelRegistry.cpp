@@ -0,0 +1,48 @@
+#include "ModelRegistry.h"
+#include <stdexcept>
+
+ModelRegistry::ModelRegistry()
+{
+}
+
+ModelRegistry::~ModelRegistry()
+{
+}
+
+ModelId ModelRegistry::registerModel(const std::string& name)
+{
+    auto it = ids.find(name);
+    if (it != ids.end()) {
+        return it->second;
+    }
+    
+    ModelId id = static_cast<ModelId>(names.size());
+    names.push_back(name);
+    ids[name] = id;
+    return id;
+}
+
+ModelId ModelRegistry::findModel(const std::string& name) const
+{
+    auto it = ids.find(name);
+    return it != ids.end() ? it->second : INVALID_MODEL_ID;
+}
+
+const std::string& ModelRegistry::getName(ModelId id) const
+{
+    if (id >= names.size()) {
+        throw std::out_of_range("Model ID out of range");
+    }
+    return names[id];
+}
+
+size_t ModelRegistry::size() const
+{
+    return names.size();
+}
+
+void ModelRegistry::clear()
+{
+    names.clear();
+    ids.clear();
+}
@@ -0,0 +1,41 @@
+#ifndef MODELREGISTRY_H
+#define MODELREGISTRY_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Dense integer model identity, assigned at load time
+using ModelId = uint32_t;
+constexpr ModelId INVALID_MODEL_ID = 0xFFFFFFFFu;
+
+// Interns model names into dense IDs so per-frame and per-row code can index
+// flat arrays instead of comparing strings. Names are only used for I/O.
+class ModelRegistry
+{
+public:
+    ModelRegistry();
+    ~ModelRegistry();
+
+    // Register a model name and return its ID (existing ID if already registered)
+    ModelId registerModel(const std::string& name);
+
+    // Look up the ID of a registered name (INVALID_MODEL_ID if unknown)
+    ModelId findModel(const std::string& name) const;
+
+    // Name of a registered model
+    const std::string& getName(ModelId id) const;
+
+    // Number of registered models (IDs are 0..size()-1)
+    size_t size() const;
+
+    // Forget all registrations
+    void clear();
+
+private:
+    std::vector<std::string> names;
+    std::unordered_map<std::string, ModelId> ids;
+};
+
+#endif
@@ -1,16 +1,194 @@
 #define TINYOBJLOADER_IMPLEMENTATION
 #include "tiny_obj_loader.h"
 #include "ObjLoader.h"
+#include "MappedFile.h"
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <cstring>
+#include <future>
 #include <iostream>
+#include <thread>
 
 // Static member initialization
-std::string ObjLoader::lastError = "";
+thread_local std::string ObjLoader::lastError = "";
+
+namespace {
+
+// Face references are stored either as absolute zero-based indices (>= 0) or,
+// for negative OBJ indices, relative to the first vertex of the chunk plus this bias
+constexpr int64_t RELATIVE_INDEX_BIAS = int64_t(1) << 40;
+
+// Counts the OBJ files being parsed at once, so concurrent loads share the cores instead of
+// each starting one worker per core
+std::atomic<size_t> activeParses{0};
+
+struct ActiveParse {
+    size_t count;
+    ActiveParse() : count(++activeParses) {}
+    ~ActiveParse() { --activeParses; }
+};
+
+// Result of parsing one line-aligned chunk of the file
+struct ObjChunk {
+    const char* begin = nullptr;
+    const char* end = nullptr;
+    std::vector<float> positions;        // x, y, z per vertex
+    std::vector<int64_t> corners;        // Triangulated face references, 3 per triangle
+    bool needsFallback = false;          // Chunk uses something only tinyobj understands
+};
+
+inline const char* skipSpaces(const char* p, const char* end)
+{
+    while (p < end && (*p == ' ' || *p == '\t')) {
+        p++;
+    }
+    return p;
+}
+
+// True if the line starts with the keyword followed by whitespace or the end of the line
+inline bool hasKeyword(const char* line, const char* end, const char* keyword)
+{
+    size_t length = strlen(keyword);
+    if (static_cast<size_t>(end - line) < length || memcmp(line, keyword, length) != 0) {
+        return false;
+    }
+    return line + length == end || line[length] == ' ' || line[length] == '\t';
+}
+
+// Parse "v x y z [w | r g b]" (only the position is kept)
+bool parseVertex(const char* p, const char* end, std::vector<float>& positions)
+{
+    for (int axis = 0; axis < 3; axis++) {
+        p = skipSpaces(p, end);
+        float value = 0.0f;
+        std::from_chars_result result = std::from_chars(p, end, value);
+        if (result.ec != std::errc()) {
+            return false;
+        }
+        positions.push_back(value);
+        p = result.ptr;
+    }
+    return true;
+}
+
+// Parse "f a b c ..." where each corner is v, v/vt, v//vn or v/vt/vn; fan-triangulates polygons
+bool parseFace(const char* p, const char* end, int64_t chunkVertexCount, std::vector<int64_t>& corners)
+{
+    int64_t first = 0;
+    int64_t previous = 0;
+    int cornerCount = 0;
+    
+    while (true) {
+        p = skipSpaces(p, end);
+        if (p >= end) {
+            break;
+        }
+        
+        long long raw = 0;
+        std::from_chars_result result = std::from_chars(p, end, raw);
+        if (result.ec != std::errc() || raw == 0) {
+            return false;
+        }
+        
+        // Skip texture/normal references
+        p = result.ptr;
+        while (p < end && *p != ' ' && *p != '\t') {
+            p++;
+        }
+        
+        int64_t corner = raw > 0 ? raw - 1 : chunkVertexCount + raw - RELATIVE_INDEX_BIAS;
+        
+        if (cornerCount == 0) {
+            first = corner;
+        } else if (cornerCount >= 2) {
+            corners.push_back(first);
+            corners.push_back(previous);
+            corners.push_back(corner);
+        }
+        previous = corner;
+        cornerCount++;
+    }
+    
+    return cornerCount >= 3;
+}
+
+void parseChunk(ObjChunk& chunk)
+{
+    const char* p = chunk.begin;
+    
+    while (p < chunk.end && !chunk.needsFallback) {
+        const char* lineEnd = static_cast<const char*>(memchr(p, '\n', chunk.end - p));
+        if (!lineEnd) {
+            lineEnd = chunk.end;
+        }
+        
+        const char* contentEnd = lineEnd;
+        if (contentEnd > p && contentEnd[-1] == '\r') {
+            contentEnd--;
+        }
+        
+        const char* line = skipSpaces(p, contentEnd);
+        if (line < contentEnd) {
+            // Line continuations are rare and not worth handling here
+            if (contentEnd[-1] == '\\') {
+                chunk.needsFallback = true;
+                break;
+            }
+            
+            char c0 = line[0];
+            char c1 = line + 1 < contentEnd ? line[1] : '\0';
+            bool keyword = c1 == ' ' || c1 == '\t';
+            
+            if (c0 == 'v' && keyword) {
+                if (!parseVertex(line + 2, contentEnd, chunk.positions)) {
+                    chunk.needsFallback = true;
+                }
+            }
+            else if (c0 == 'f' && keyword) {
+                int64_t chunkVertexCount = static_cast<int64_t>(chunk.positions.size() / 3);
+                if (!parseFace(line + 2, contentEnd, chunkVertexCount, chunk.corners)) {
+                    chunk.needsFallback = true;
+                }
+            }
+            else if (hasKeyword(line, contentEnd, "cstype") || hasKeyword(line, contentEnd, "curv") ||
+                     hasKeyword(line, contentEnd, "surf") || hasKeyword(line, contentEnd, "parm")) {
+                // Free-form geometry
+                chunk.needsFallback = true;
+            }
+            // Everything else (comments, vt/vn, groups, materials, lines) does not affect the mesh
+        }
+        
+        p = lineEnd + 1;
+    }
+}
+
+} // namespace
 
 bool ObjLoader::loadOBJ(const std::string& filePath,
                         std::vector<float>& vertices,
                         std::vector<unsigned int>& indices,
                         size_t& vertexCount,
                         size_t& triangleCount)
+{
+    MappedFile file;
+    if (!file.open(filePath)) {
+        vertices.clear();
+        indices.clear();
+        vertexCount = 0;
+        triangleCount = 0;
+        lastError = "Failed to open " + filePath;
+        return false;
+    }
+    
+    return loadOBJ(filePath, file.data(), file.size(), vertices, indices, vertexCount, triangleCount);
+}
+
+bool ObjLoader::loadOBJ(const std::string& filePath, const char* data, size_t size,
+                        std::vector<float>& vertices,
+                        std::vector<unsigned int>& indices,
+                        size_t& vertexCount,
+                        size_t& triangleCount)
 {
     // Clear output vectors
     vertices.clear();
@@ -18,83 +196,197 @@ bool ObjLoader::loadOBJ(const std::string& filePath,
     vertexCount = 0;
     triangleCount = 0;
     lastError = "";
+    
+    bool needsFallback = false;
+    bool success = loadOBJParallel(filePath, data, size, vertices, indices, needsFallback);
+    
+    if (!success && needsFallback) {
+        std::cout << "Using tinyobjloader for " << filePath << std::endl;
+        vertices.clear();
+        indices.clear();
+        lastError = "";
+        success = loadOBJTinyObj(filePath, vertices, indices);
+    }
+    
+    if (!success) {
+        return false;
+    }
+    
+    if (vertices.empty() || indices.empty()) {
+        lastError = "No vertex data found in " + filePath;
+        return false;
+    }
+    
+    vertexCount = vertices.size() / 3;
+    triangleCount = indices.size() / 3;
+    
+    return true;
+}
+
+bool ObjLoader::loadOBJParallel(const std::string& filePath, const char* data, size_t size,
+                                std::vector<float>& vertices,
+                                std::vector<unsigned int>& indices,
+                                bool& needsFallback)
+{
+    needsFallback = false;
+    const char* dataEnd = data + size;
+    
+    // Split into line-aligned chunks, one per worker
+    ActiveParse activeParse;
+    size_t workerCount = std::max<size_t>(1, std::thread::hardware_concurrency() / activeParse.count);
+    size_t chunkCount = std::max<size_t>(1, std::min(workerCount, size / MIN_CHUNK_BYTES));
+    std::vector<ObjChunk> chunks(chunkCount);
+    
+    const char* chunkBegin = data;
+    for (size_t i = 0; i < chunkCount; i++) {
+        const char* chunkEnd = dataEnd;
+        if (i + 1 < chunkCount) {
+            chunkEnd = std::max(chunkBegin, data + size * (i + 1) / chunkCount);
+            const char* newline = static_cast<const char*>(memchr(chunkEnd, '\n', dataEnd - chunkEnd));
+            chunkEnd = newline ? newline + 1 : dataEnd;
+        }
+        chunks[i].begin = chunkBegin;
+        chunks[i].end = chunkEnd;
+        chunkBegin = chunkEnd;
+    }
+    
+    // Parse chunks in parallel (the first one on this thread)
+    std::vector<std::future<void>> workers;
+    for (size_t i = 1; i < chunkCount; i++) {
+        workers.push_back(std::async(std::launch::async, parseChunk, std::ref(chunks[i])));
+    }
+    if (chunkCount > 0) {
+        parseChunk(chunks[0]);
+    }
+    for (std::future<void>& worker : workers) {
+        worker.get();
+    }
+    
+    for (const ObjChunk& chunk : chunks) {
+        if (chunk.needsFallback) {
+            needsFallback = true;
+            lastError = "Unsupported OBJ content in " + filePath;
+            return false;
+        }
+    }
+    
+    // Prefix sums give each chunk its output range, so the merge needs no reallocation
+    std::vector<size_t> vertexStarts(chunkCount + 1, 0);
+    std::vector<size_t> cornerStarts(chunkCount + 1, 0);
+    for (size_t i = 0; i < chunkCount; i++) {
+        vertexStarts[i + 1] = vertexStarts[i] + chunks[i].positions.size() / 3;
+        cornerStarts[i + 1] = cornerStarts[i] + chunks[i].corners.size();
+    }
+    
+    size_t totalVertices = vertexStarts[chunkCount];
+    vertices.resize(totalVertices * 3);
+    indices.resize(cornerStarts[chunkCount]);
+    
+    // Merge: copy positions and resolve face references into global indices
+    std::vector<char> chunkHasInvalid(chunkCount, 0);
+    auto mergeChunk = [&](size_t i) {
+        const ObjChunk& chunk = chunks[i];
+        std::copy(chunk.positions.begin(), chunk.positions.end(), vertices.begin() + vertexStarts[i] * 3);
+        
+        unsigned int* out = indices.data() + cornerStarts[i];
+        for (size_t c = 0; c < chunk.corners.size(); c++) {
+            int64_t corner = chunk.corners[c];
+            int64_t index = corner >= 0 ? corner : static_cast<int64_t>(vertexStarts[i]) + corner + RELATIVE_INDEX_BIAS;
+            if (index < 0 || static_cast<size_t>(index) >= totalVertices) {
+                chunkHasInvalid[i] = 1;
+                index = 0;
+            }
+            out[c] = static_cast<unsigned int>(index);
+        }
+    };
+    
+    std::vector<std::future<void>> mergers;
+    for (size_t i = 1; i < chunkCount; i++) {
+        mergers.push_back(std::async(std::launch::async, mergeChunk, i));
+    }
+    mergeChunk(0);
+    for (std::future<void>& merger : mergers) {
+        merger.get();
+    }
+    
+    if (std::find(chunkHasInvalid.begin(), chunkHasInvalid.end(), 1) != chunkHasInvalid.end()) {
+        // Let tinyobj report or handle faces that reference missing vertices
+        needsFallback = true;
+        lastError = "Face index out of range in " + filePath;
+        return false;
+    }
+    
+    return true;
+}
 
+bool ObjLoader::loadOBJTinyObj(const std::string& filePath,
+                               std::vector<float>& vertices,
+                               std::vector<unsigned int>& indices)
+{
     // TinyObjLoader structures
     tinyobj::attrib_t attrib;
     std::vector<tinyobj::shape_t> shapes;
     std::vector<tinyobj::material_t> materials;
     std::string warn, err;
-
-    // Load the OBJ file
-    bool success = tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, filePath.c_str());
-
+    
+    // Load the OBJ file (keep polygons; they are fan-triangulated below)
+    bool success = tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, filePath.c_str(), nullptr, false);
+    
     // Handle errors (but suppress warnings about missing material files)
     if (!err.empty()) {
         lastError = "Error loading " + filePath + ": " + err;
         std::cerr << lastError << std::endl;
         return false;
     }
-
+    
     if (!success) {
         lastError = "Failed to load " + filePath;
         return false;
     }
-
+    
     if (shapes.empty()) {
         lastError = "No shapes found in " + filePath;
         return false;
     }
-
-    // Process all shapes into a single mesh
-    size_t indexOffset = 0;
+    
+    // Positions are shared; faces index into them directly
+    vertices = attrib.vertices;
+    size_t positionCount = vertices.size() / 3;
     
     for (size_t s = 0; s < shapes.size(); s++) {
         const auto& mesh = shapes[s].mesh;
+        size_t indexOffset = 0;
         
         // Process each face
         for (size_t f = 0; f < mesh.num_face_vertices.size(); f++) {
             size_t fv = mesh.num_face_vertices[f];
             
-            // We only handle triangulated faces (should be 3 vertices per face)
-            if (fv != 3) {
-                indexOffset += fv;
-                continue;
-            }
-            
-            // Process the 3 vertices of this triangle
-            for (size_t v = 0; v < fv; v++) {
-                tinyobj::index_t idx = mesh.indices[indexOffset + v];
+            // Fan-triangulate polygons: (0, i, i + 1)
+            for (size_t v = 1; v + 1 < fv; v++) {
+                int i0 = mesh.indices[indexOffset].vertex_index;
+                int i1 = mesh.indices[indexOffset + v].vertex_index;
+                int i2 = mesh.indices[indexOffset + v + 1].vertex_index;
                 
-                // Get vertex position
-                float vx = attrib.vertices[3 * idx.vertex_index + 0];
-                float vy = attrib.vertices[3 * idx.vertex_index + 1];
-                float vz = attrib.vertices[3 * idx.vertex_index + 2];
+                if (i0 < 0 || i1 < 0 || i2 < 0 ||
+                    static_cast<size_t>(i0) >= positionCount ||
+                    static_cast<size_t>(i1) >= positionCount ||
+                    static_cast<size_t>(i2) >= positionCount) {
+                    continue; // Skip invalid indices
+                }
                 
-                // Add vertex to our array
-                vertices.push_back(vx);
-                vertices.push_back(vy);
-                vertices.push_back(vz);
-                
-                // Add index (simple sequential indexing since we're creating a flat array)
-                indices.push_back(static_cast<unsigned int>(indices.size()));
+                indices.push_back(static_cast<unsigned int>(i0));
+                indices.push_back(static_cast<unsigned int>(i1));
+                indices.push_back(static_cast<unsigned int>(i2));
             }
             
             indexOffset += fv;
-            triangleCount++;
         }
     }
     
-    vertexCount = vertices.size() / 3;
-    
-    if (vertices.empty()) {
-        lastError = "No vertex data found in " + filePath;
-        return false;
-    }
-    
     return true;
 }
 
 std::string ObjLoader::getLastError()
 {
     return lastError;
-}
\ No newline at end of file
+}
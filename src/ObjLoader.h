@@ -1,32 +1,50 @@
 #ifndef OBJLOADER_H
 #define OBJLOADER_H
 
+#include <cstdint>
 #include <vector>
 #include <string>
 
-// Simple OBJ loader using tinyobjloader
+// OBJ loader: a parallel memory-mapped parser for plain v/f meshes, with
+// tinyobjloader as the fallback for anything it does not handle
 class ObjLoader
 {
 public:
-    // Load OBJ file and return vertex data
+    // Load OBJ file and return vertex data (polygons are fan-triangulated)
     static bool loadOBJ(const std::string& filePath,
                         std::vector<float>& vertices,
                         std::vector<unsigned int>& indices,
                         size_t& vertexCount,
                         size_t& triangleCount);
 
+    // Same, parsing a file that is already in memory (filePath is used in messages and
+    // by the tinyobjloader fallback)
+    static bool loadOBJ(const std::string& filePath, const char* data, size_t size,
+                        std::vector<float>& vertices,
+                        std::vector<unsigned int>& indices,
+                        size_t& vertexCount,
+                        size_t& triangleCount);
+
     // Get last error message
     static std::string getLastError();
 
 private:
-    static std::string lastError;
+    static thread_local std::string lastError; // Per thread: meshes are loaded concurrently
+    
+    // Fast path: parse line-aligned chunks of the mapped file on worker threads.
+    // Sets needsFallback when the file uses features the fast path does not parse.
+    static bool loadOBJParallel(const std::string& filePath, const char* data, size_t size,
+                                std::vector<float>& vertices,
+                                std::vector<unsigned int>& indices,
+                                bool& needsFallback);
+    
+    // Fallback path through tinyobjloader
+    static bool loadOBJTinyObj(const std::string& filePath,
+                               std::vector<float>& vertices,
+                               std::vector<unsigned int>& indices);
     
-    // Helper function to process tinyobj data
-    static void processTinyObjData(const void* attrib, const void* shapes, 
-                                  std::vector<float>& vertices, 
-                                  std::vector<unsigned int>& indices,
-                                  size_t& vertexCount,
-                                  size_t& triangleCount);
+    // Chunks smaller than this are not worth a thread
+    static constexpr size_t MIN_CHUNK_BYTES = 1 << 20;
 };
 
-#endif
\ No newline at end of file
+#endif
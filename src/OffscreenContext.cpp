@@ -0,0 +1,233 @@
+#include "OffscreenContext.h"
+#include <glad/glad.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <cstring>
+#include <iostream>
+
+#ifndef EGL_PLATFORM_SURFACELESS_MESA
+#define EGL_PLATFORM_SURFACELESS_MESA 0x31DD
+#endif
+
+namespace {
+
+constexpr EGLint MAX_EGL_DEVICES = 16;
+
+bool initializeDisplay(EGLDisplay candidate, EGLint& major, EGLint& minor)
+{
+    return candidate != EGL_NO_DISPLAY && eglInitialize(candidate, &major, &minor);
+}
+
+// Headless displays first: Mesa's surfaceless platform, then each EGL device. The default
+// display usually needs a window system, so it is only the last resort.
+EGLDisplay openDisplay(EGLint& major, EGLint& minor, const char*& platform)
+{
+    auto getPlatformDisplay = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+        eglGetProcAddress("eglGetPlatformDisplayEXT"));
+    auto queryDevices = reinterpret_cast<PFNEGLQUERYDEVICESEXTPROC>(eglGetProcAddress("eglQueryDevicesEXT"));
+    
+    if (getPlatformDisplay) {
+        EGLDisplay surfaceless = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+        if (initializeDisplay(surfaceless, major, minor)) {
+            platform = "surfaceless";
+            return surfaceless;
+        }
+        
+        EGLDeviceEXT devices[MAX_EGL_DEVICES];
+        EGLint deviceCount = 0;
+        if (queryDevices && queryDevices(MAX_EGL_DEVICES, devices, &deviceCount)) {
+            for (EGLint i = 0; i < deviceCount; i++) {
+                EGLDisplay device = getPlatformDisplay(EGL_PLATFORM_DEVICE_EXT, devices[i], nullptr);
+                if (initializeDisplay(device, major, minor)) {
+                    platform = "device";
+                    return device;
+                }
+            }
+        }
+    }
+    
+    EGLDisplay fallback = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    if (initializeDisplay(fallback, major, minor)) {
+        platform = "default";
+        return fallback;
+    }
+    return EGL_NO_DISPLAY;
+}
+
+} // namespace
+
+OffscreenContext::OffscreenContext() : display(nullptr), context(nullptr), surface(nullptr), width(0), height(0),
+                                       framebuffer(0), colorBuffer(0), depthBuffer(0), packBuffers{},
+                                       nextPackBuffer(0), pendingReadbacks(0)
+{
+}
+
+OffscreenContext::~OffscreenContext()
+{
+    destroy();
+}
+
+bool OffscreenContext::create(int frameWidth, int frameHeight)
+{
+    width = frameWidth;
+    height = frameHeight;
+    
+    EGLint major = 0, minor = 0;
+    const char* platform = "";
+    EGLDisplay eglDisplay = openDisplay(major, minor, platform);
+    if (eglDisplay == EGL_NO_DISPLAY) {
+        std::cerr << "Failed to initialize EGL (error 0x" << std::hex << eglGetError() << std::dec << "): no surfaceless "
+                  << "platform, EGL device or default display is available. With Mesa, run with "
+                  << "EGL_PLATFORM=surfaceless; otherwise check that the GPU driver installs EGL." << std::endl;
+        return false;
+    }
+    display = eglDisplay;
+    std::cout << "EGL " << major << "." << minor << " (" << eglQueryString(eglDisplay, EGL_VENDOR) << ", "
+              << platform << " display)" << std::endl;
+    
+    // The window-system surface is a tiny pbuffer; frames go to the framebuffer object
+    const EGLint configAttributes[] = {
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8,
+        EGL_NONE
+    };
+    EGLConfig config = nullptr;
+    EGLint configCount = 0;
+    if (!eglChooseConfig(eglDisplay, configAttributes, &config, 1, &configCount) || configCount == 0) {
+        std::cerr << "No EGL config with desktop OpenGL support" << std::endl;
+        return false;
+    }
+    
+    const EGLint surfaceAttributes[] = {EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE};
+    EGLSurface eglSurface = eglCreatePbufferSurface(eglDisplay, config, surfaceAttributes);
+    surface = eglSurface;
+    
+    eglBindAPI(EGL_OPENGL_API);
+    const EGLint contextAttributes[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 3,
+        EGL_CONTEXT_MINOR_VERSION, 3,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE
+    };
+    EGLContext eglContext = eglCreateContext(eglDisplay, config, EGL_NO_CONTEXT, contextAttributes);
+    if (eglContext == EGL_NO_CONTEXT) {
+        std::cerr << "Failed to create an OpenGL 3.3 core EGL context" << std::endl;
+        return false;
+    }
+    context = eglContext;
+    
+    if (!eglMakeCurrent(eglDisplay, eglSurface, eglSurface, eglContext)) {
+        std::cerr << "Failed to make the EGL context current" << std::endl;
+        return false;
+    }
+    if (!gladLoadGLLoader((GLADloadproc)eglGetProcAddress)) {
+        std::cerr << "Failed to initialize GLAD" << std::endl;
+        return false;
+    }
+    std::cout << "Offscreen renderer: " << glGetString(GL_RENDERER) << std::endl;
+    
+    glGenFramebuffers(1, &framebuffer);
+    glGenRenderbuffers(1, &colorBuffer);
+    glGenRenderbuffers(1, &depthBuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, colorBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "Offscreen framebuffer is incomplete" << std::endl;
+        return false;
+    }
+    
+    glGenBuffers(READBACK_BUFFERS, packBuffers);
+    for (int i = 0; i < READBACK_BUFFERS; i++) {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, packBuffers[i]);
+        glBufferData(GL_PIXEL_PACK_BUFFER, static_cast<size_t>(width) * height * 3, nullptr, GL_STREAM_READ);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    
+    return true;
+}
+
+void OffscreenContext::destroy()
+{
+    if (context) {
+        if (framebuffer != 0) {
+            glDeleteFramebuffers(1, &framebuffer);
+            glDeleteRenderbuffers(1, &colorBuffer);
+            glDeleteRenderbuffers(1, &depthBuffer);
+            glDeleteBuffers(READBACK_BUFFERS, packBuffers);
+            framebuffer = 0;
+        }
+        eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        eglDestroyContext(display, context);
+        context = nullptr;
+    }
+    if (surface) {
+        eglDestroySurface(display, surface);
+        surface = nullptr;
+    }
+    if (display) {
+        eglTerminate(display);
+        display = nullptr;
+    }
+    pendingReadbacks = 0;
+}
+
+void OffscreenContext::beginFrame()
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glViewport(0, 0, width, height);
+}
+
+bool OffscreenContext::readFrame(std::vector<unsigned char>& pixels)
+{
+    // Queue the copy of this frame; it completes while the next frame renders
+    int buffer = nextPackBuffer;
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, packBuffers[buffer]);
+    glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    nextPackBuffer = (nextPackBuffer + 1) % READBACK_BUFFERS;
+    
+    if (pendingReadbacks < READBACK_BUFFERS - 1) {
+        pendingReadbacks++;
+        return false;
+    }
+    
+    // The oldest pending copy is in the buffer written next
+    return mapReadback(nextPackBuffer, pixels);
+}
+
+bool OffscreenContext::flush(std::vector<unsigned char>& pixels)
+{
+    if (pendingReadbacks == 0) {
+        return false;
+    }
+    
+    pendingReadbacks--;
+    int buffer = (nextPackBuffer + READBACK_BUFFERS - 1 - pendingReadbacks) % READBACK_BUFFERS;
+    return mapReadback(buffer, pixels);
+}
+
+bool OffscreenContext::mapReadback(int buffer, std::vector<unsigned char>& pixels)
+{
+    size_t size = static_cast<size_t>(width) * height * 3;
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, packBuffers[buffer]);
+    const void* mapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size, GL_MAP_READ_BIT);
+    if (!mapped) {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        std::cerr << "Failed to map the readback buffer" << std::endl;
+        return false;
+    }
+    
+    pixels.resize(size);
+    std::memcpy(pixels.data(), mapped, size);
+    glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    return true;
+}
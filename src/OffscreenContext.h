@@ -0,0 +1,47 @@
+#ifndef OFFSCREENCONTEXT_H
+#define OFFSCREENCONTEXT_H
+
+#include <vector>
+
+// Headless OpenGL 3.3 core context through EGL (Mesa's surfaceless platform, e.g. llvmpipe,
+// or an EGL device such as an NVIDIA GPU without X) rendering into a framebuffer
+// object. Frames are read back through two pixel pack buffers, so the copy of one frame
+// overlaps the rendering of the next. Only built with FT_SIM_OFFSCREEN.
+class OffscreenContext
+{
+public:
+    OffscreenContext();
+    ~OffscreenContext();
+
+    // Create the context, make it current and load GL entry points
+    bool create(int width, int height);
+    void destroy();
+
+    // Bind the framebuffer and set the viewport for the next frame
+    void beginFrame();
+
+    // Start reading back the frame just rendered. Returns true and fills pixels
+    // (RGB, bottom row first) with the previous frame once one is available.
+    bool readFrame(std::vector<unsigned char>& pixels);
+
+    // Finish the last pending readback
+    bool flush(std::vector<unsigned char>& pixels);
+
+private:
+    void* display;
+    void* context;
+    void* surface;
+
+    int width, height;
+    unsigned int framebuffer;
+    unsigned int colorBuffer, depthBuffer;
+
+    static constexpr int READBACK_BUFFERS = 2;
+    unsigned int packBuffers[READBACK_BUFFERS];
+    int nextPackBuffer;
+    int pendingReadbacks;
+
+    bool mapReadback(int buffer, std::vector<unsigned char>& pixels);
+};
+
+#endif
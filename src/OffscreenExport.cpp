@@ -0,0 +1,200 @@
+#include "OffscreenExport.h"
+#include "Camera.h"
+#include "ModelManager.h"
+#include "Render.h"
+#include "Transform.h"
+#include "BulkCapacitanceProcessor.h"
+#include "RunFile.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#ifdef FT_SIM_OFFSCREEN
+#include "OffscreenContext.h"
+#include <glad/glad.h>
+#include <EGL/egl.h>
+#endif
+
+bool parseExportArguments(int argc, char** argv, ExportOptions& options)
+{
+    bool exportRequested = false;
+    
+    for (int i = 1; i < argc; i++) {
+        const char* argument = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+        
+        if (std::strcmp(argument, "--export") == 0 && value) {
+            options.outputDirectory = value;
+            exportRequested = true;
+        } else if (std::strcmp(argument, "--format") == 0 && value) {
+            if (std::strcmp(value, "png") == 0) {
+                options.format = FrameFormat::Png;
+            } else if (std::strcmp(value, "raw") == 0) {
+                options.format = FrameFormat::Raw;
+            } else {
+                std::cerr << "Unknown export format: " << value << " (expected png or raw)" << std::endl;
+                return false;
+            }
+        } else if (std::strcmp(argument, "--size") == 0 && value) {
+            if (std::sscanf(value, "%dx%d", &options.width, &options.height) != 2 ||
+                options.width <= 0 || options.height <= 0) {
+                std::cerr << "Invalid export size: " << value << " (expected WxH)" << std::endl;
+                return false;
+            }
+        } else if (std::strcmp(argument, "--rows") == 0 && value) {
+            unsigned long long first = 0, last = 0, step = 1;
+            int fields = std::sscanf(value, "%llu:%llu:%llu", &first, &last, &step);
+            if (fields < 2 || step == 0 || last < first) {
+                std::cerr << "Invalid export rows: " << value << " (expected first:last[:step])" << std::endl;
+                return false;
+            }
+            options.firstRow = static_cast<size_t>(first);
+            options.lastRow = static_cast<size_t>(last);
+            options.rowStep = static_cast<size_t>(step);
+        } else if (std::strcmp(argument, "--threads") == 0 && value) {
+            options.threadCount = static_cast<size_t>(std::strtoul(value, nullptr, 10));
+        } else {
+            continue;
+        }
+        i++;  // Skip the option value
+    }
+    
+    return exportRequested;
+}
+
+#ifdef FT_SIM_OFFSCREEN
+
+int runOffscreenExport(const ExportOptions& options)
+{
+    // Mesh loading runs while the context is created
+    ModelManager modelManager;
+    bool modelsLoaded = false;
+    std::thread loader([&]() { modelsLoaded = modelManager.loadAllModels("models/"); });
+    
+    OffscreenContext context;
+    bool contextReady = context.create(options.width, options.height);
+    loader.join();
+    if (!contextReady) {
+        return -1;
+    }
+    if (!modelsLoaded) {
+        std::cerr << "Failed to load models" << std::endl;
+        return -1;
+    }
+    
+    glEnable(GL_DEPTH_TEST);
+    
+    TransformManager transformManager;
+    modelManager.assignModelGroups(transformManager);
+    
+    Render renderer;
+    if (!renderer.initialize((GLProcLoader)eglGetProcAddress)) {
+        std::cerr << "Failed to initialize renderer" << std::endl;
+        return -1;
+    }
+    renderer.uploadModels(modelManager.getModels());
+    
+    // Poses come from the run file of the last bulk run, or from the CSVs directly
+    std::string csvDirectory = "csv_data";
+    RunFile runFile;
+    BulkCapacitanceProcessor bulkProcessor;
+    size_t rowCount = 0;
+    if (runFile.open(RunFile::getRunPath(csvDirectory))) {
+        rowCount = runFile.getRowCount();
+    } else if (bulkProcessor.initializeStepMode(csvDirectory)) {
+        rowCount = bulkProcessor.getMaxRows();
+    } else {
+        std::cerr << "No run to export in " << csvDirectory << std::endl;
+        return -1;
+    }
+    
+    size_t lastRow = std::min(options.lastRow, rowCount - 1);
+    if (rowCount == 0 || options.firstRow > lastRow) {
+        std::cerr << "Export rows are outside the run (" << rowCount << " rows)" << std::endl;
+        return -1;
+    }
+    
+    size_t threadCount = options.threadCount;
+    if (threadCount == 0) {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    
+    FrameWriter writer;
+    if (!writer.start(options.outputDirectory, options.format, options.width, options.height, threadCount)) {
+        return -1;
+    }
+    
+    Camera camera(glm::vec3(10.0f, 10.0f, 10.0f));
+    glm::mat4 view = camera.getViewMatrix();
+    glm::mat4 projection = camera.getProjectionMatrix(static_cast<float>(options.width),
+                                                      static_cast<float>(options.height));
+    
+    size_t frameCount = (lastRow - options.firstRow) / options.rowStep + 1;
+    std::cout << "Exporting " << frameCount << " frames (rows " << options.firstRow << "-" << lastRow
+              << ", step " << options.rowStep << ") to " << options.outputDirectory << std::endl;
+    
+    auto startTime = std::chrono::steady_clock::now();
+    bool success = true;
+    size_t readFrames = 0;
+    
+    for (size_t frame = 0; frame < frameCount && success; frame++) {
+        size_t row = options.firstRow + frame * options.rowStep;
+        if (runFile.isOpen()) {
+            BulkCapacitanceProcessor::applyRunRecord(runFile.getRecord(row), transformManager);
+        } else if (!bulkProcessor.stepToRow(row, transformManager)) {
+            success = false;
+            break;
+        }
+        
+        context.beginFrame();
+        glClearColor(0.2f, 0.2f, 0.2f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        renderer.render(view, projection, transformManager);
+        
+        // The readback lags one frame behind, so encoding overlaps the next render
+        std::vector<unsigned char> pixels = writer.acquireBuffer();
+        if (context.readFrame(pixels)) {
+            success = writer.submit(readFrames++, std::move(pixels));
+        }
+        
+        if ((frame + 1) % 100 == 0) {
+            std::cout << "Rendered " << frame + 1 << "/" << frameCount << " frames" << std::endl;
+        }
+    }
+    
+    std::vector<unsigned char> pixels = writer.acquireBuffer();
+    while (success && context.flush(pixels)) {
+        success = writer.submit(readFrames++, std::move(pixels));
+        pixels = writer.acquireBuffer();
+    }
+    
+    success = writer.finish() && success;
+    renderer.cleanup();
+    context.destroy();
+    
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    std::cout << "Exported " << writer.getFramesWritten() << " frames in " << seconds << " s ("
+              << (seconds > 0.0 ? writer.getFramesWritten() / seconds : 0.0) << " fps, "
+              << (options.format == FrameFormat::Raw ? std::string("raw stream") : std::to_string(threadCount) + " PNG encoders")
+              << ")" << std::endl;
+    if (options.format == FrameFormat::Raw) {
+        std::cout << "Encode with: ffmpeg -f rawvideo -pixel_format rgb24 -video_size " << options.width << "x"
+                  << options.height << " -framerate 30 -i frames.rgb export.mp4" << std::endl;
+    }
+    
+    return success ? 0 : -1;
+}
+
+#else
+
+int runOffscreenExport(const ExportOptions&)
+{
+    std::cerr << "Offscreen export needs a build with FT_SIM_OFFSCREEN=ON (EGL)" << std::endl;
+    return -1;
+}
+
+#endif
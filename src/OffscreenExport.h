@@ -0,0 +1,28 @@
+#ifndef OFFSCREENEXPORT_H
+#define OFFSCREENEXPORT_H
+
+#include "FrameWriter.h"
+#include <string>
+
+// Headless export of a batch run: every selected row of the run is posed and rendered
+// with the viewer's shaders into an offscreen framebuffer, and the frames are written
+// as PNGs or a raw video stream. Needs a build with FT_SIM_OFFSCREEN (EGL).
+struct ExportOptions {
+    std::string outputDirectory;
+    FrameFormat format = FrameFormat::Png;
+    int width = 1200;
+    int height = 800;
+    size_t firstRow = 0;
+    size_t lastRow = static_cast<size_t>(-1);   // Inclusive; clamped to the run
+    size_t rowStep = 1;
+    size_t threadCount = 0;                     // 0: one encoder per hardware thread
+};
+
+// Parse "--export <dir> [--format png|raw] [--size WxH] [--rows first:last[:step]]
+// [--threads N]"; returns false if --export is absent or an option is malformed.
+bool parseExportArguments(int argc, char** argv, ExportOptions& options);
+
+// Render and write the frames; returns the process exit code
+int runOffscreenExport(const ExportOptions& options);
+
+#endif
@@ -0,0 +1,304 @@
+#include "Overlay.h"
+#include <glad/glad.h>
+#include <algorithm>
+#include <cctype>
+#include <iterator>
+#include <iostream>
+
+namespace {
+
+// 5x7 font: one byte per row, top row first, bit 4 is the leftmost column
+struct Glyph {
+    char character;
+    unsigned char rows[7];
+};
+
+const Glyph FONT[] = {
+    {' ', {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}},
+    {'0', {0x0E, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0E}},
+    {'1', {0x04, 0x0C, 0x04, 0x04, 0x04, 0x04, 0x0E}},
+    {'2', {0x0E, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1F}},
+    {'3', {0x1F, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0E}},
+    {'4', {0x02, 0x06, 0x0A, 0x12, 0x1F, 0x02, 0x02}},
+    {'5', {0x1F, 0x10, 0x1E, 0x01, 0x01, 0x11, 0x0E}},
+    {'6', {0x06, 0x08, 0x10, 0x1E, 0x11, 0x11, 0x0E}},
+    {'7', {0x1F, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08}},
+    {'8', {0x0E, 0x11, 0x11, 0x0E, 0x11, 0x11, 0x0E}},
+    {'9', {0x0E, 0x11, 0x11, 0x0F, 0x01, 0x02, 0x0C}},
+    {'A', {0x0E, 0x11, 0x11, 0x11, 0x1F, 0x11, 0x11}},
+    {'B', {0x1E, 0x11, 0x11, 0x1E, 0x11, 0x11, 0x1E}},
+    {'C', {0x0E, 0x11, 0x10, 0x10, 0x10, 0x11, 0x0E}},
+    {'D', {0x1C, 0x12, 0x11, 0x11, 0x11, 0x12, 0x1C}},
+    {'E', {0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x1F}},
+    {'F', {0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x10}},
+    {'G', {0x0E, 0x11, 0x10, 0x17, 0x11, 0x11, 0x0F}},
+    {'H', {0x11, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11}},
+    {'I', {0x0E, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0E}},
+    {'J', {0x07, 0x02, 0x02, 0x02, 0x02, 0x12, 0x0C}},
+    {'K', {0x11, 0x12, 0x14, 0x18, 0x14, 0x12, 0x11}},
+    {'L', {0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x1F}},
+    {'M', {0x11, 0x1B, 0x15, 0x15, 0x11, 0x11, 0x11}},
+    {'N', {0x11, 0x11, 0x19, 0x15, 0x13, 0x11, 0x11}},
+    {'O', {0x0E, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E}},
+    {'P', {0x1E, 0x11, 0x11, 0x1E, 0x10, 0x10, 0x10}},
+    {'Q', {0x0E, 0x11, 0x11, 0x11, 0x15, 0x12, 0x0D}},
+    {'R', {0x1E, 0x11, 0x11, 0x1E, 0x14, 0x12, 0x11}},
+    {'S', {0x0F, 0x10, 0x10, 0x0E, 0x01, 0x01, 0x1E}},
+    {'T', {0x1F, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04}},
+    {'U', {0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E}},
+    {'V', {0x11, 0x11, 0x11, 0x11, 0x11, 0x0A, 0x04}},
+    {'W', {0x11, 0x11, 0x11, 0x15, 0x15, 0x15, 0x0A}},
+    {'X', {0x11, 0x11, 0x0A, 0x04, 0x0A, 0x11, 0x11}},
+    {'Y', {0x11, 0x11, 0x11, 0x0A, 0x04, 0x04, 0x04}},
+    {'Z', {0x1F, 0x01, 0x02, 0x04, 0x08, 0x10, 0x1F}},
+    {'.', {0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C}},
+    {',', {0x00, 0x00, 0x00, 0x00, 0x0C, 0x04, 0x08}},
+    {':', {0x00, 0x0C, 0x0C, 0x00, 0x0C, 0x0C, 0x00}},
+    {'-', {0x00, 0x00, 0x00, 0x1F, 0x00, 0x00, 0x00}},
+    {'+', {0x00, 0x04, 0x04, 0x1F, 0x04, 0x04, 0x00}},
+    {'=', {0x00, 0x00, 0x1F, 0x00, 0x1F, 0x00, 0x00}},
+    {'_', {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1F}},
+    {'~', {0x00, 0x00, 0x08, 0x15, 0x02, 0x00, 0x00}},
+    {'/', {0x00, 0x01, 0x02, 0x04, 0x08, 0x10, 0x00}},
+    {'%', {0x18, 0x19, 0x02, 0x04, 0x08, 0x13, 0x03}},
+    {'(', {0x02, 0x04, 0x08, 0x08, 0x08, 0x04, 0x02}},
+    {')', {0x08, 0x04, 0x02, 0x02, 0x02, 0x04, 0x08}},
+    {'[', {0x0E, 0x08, 0x08, 0x08, 0x08, 0x08, 0x0E}},
+    {']', {0x0E, 0x02, 0x02, 0x02, 0x02, 0x02, 0x0E}},
+    {'?', {0x0E, 0x11, 0x01, 0x02, 0x04, 0x00, 0x04}},
+};
+
+const char* OVERLAY_VERTEX_SHADER = R"(#version 330 core
+layout (location = 0) in vec2 aPos;
+
+uniform vec2 screenSize;
+uniform vec2 offset;
+
+void main()
+{
+    // Pixels (origin top-left) to normalized device coordinates
+    vec2 ndc = (aPos + offset) / screenSize * 2.0 - 1.0;
+    gl_Position = vec4(ndc.x, -ndc.y, 0.0, 1.0);
+}
+)";
+
+const char* OVERLAY_FRAGMENT_SHADER = R"(#version 330 core
+out vec4 FragColor;
+
+uniform vec4 color;
+
+void main()
+{
+    FragColor = color;
+}
+)";
+
+unsigned int compileOverlayShader(const char* source, unsigned int type)
+{
+    unsigned int shader = glCreateShader(type);
+    glShaderSource(shader, 1, &source, NULL);
+    glCompileShader(shader);
+    
+    int success;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+    if (!success) {
+        char infoLog[1024];
+        glGetShaderInfoLog(shader, 1024, NULL, infoLog);
+        std::cerr << "Overlay shader compilation error: " << infoLog << std::endl;
+        glDeleteShader(shader);
+        return 0;
+    }
+    return shader;
+}
+
+} // namespace
+
+Overlay::Overlay(OverlayAnchor anchor) : shaderProgram(0), VAO(0), VBO(0), screenSizeLoc(-1), colorLoc(-1),
+                                         offsetLoc(-1), anchor(anchor), backgroundVertexCount(0),
+                                         textVertexCount(0), panelWidth(0.0f), panelHeight(0.0f), buffersDirty(false)
+{
+}
+
+Overlay::~Overlay()
+{
+    cleanup();
+}
+
+bool Overlay::initialize()
+{
+    unsigned int vertexShader = compileOverlayShader(OVERLAY_VERTEX_SHADER, GL_VERTEX_SHADER);
+    unsigned int fragmentShader = compileOverlayShader(OVERLAY_FRAGMENT_SHADER, GL_FRAGMENT_SHADER);
+    if (vertexShader == 0 || fragmentShader == 0) {
+        return false;
+    }
+    
+    shaderProgram = glCreateProgram();
+    glAttachShader(shaderProgram, vertexShader);
+    glAttachShader(shaderProgram, fragmentShader);
+    glLinkProgram(shaderProgram);
+    glDeleteShader(vertexShader);
+    glDeleteShader(fragmentShader);
+    
+    int success;
+    glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success);
+    if (!success) {
+        char infoLog[1024];
+        glGetProgramInfoLog(shaderProgram, 1024, NULL, infoLog);
+        std::cerr << "Overlay program linking error: " << infoLog << std::endl;
+        return false;
+    }
+    
+    screenSizeLoc = glGetUniformLocation(shaderProgram, "screenSize");
+    offsetLoc = glGetUniformLocation(shaderProgram, "offset");
+    colorLoc = glGetUniformLocation(shaderProgram, "color");
+    
+    glGenVertexArrays(1, &VAO);
+    glGenBuffers(1, &VBO);
+    glBindVertexArray(VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    
+    return true;
+}
+
+void Overlay::cleanup()
+{
+    if (VAO != 0) {
+        glDeleteVertexArrays(1, &VAO);
+        VAO = 0;
+    }
+    if (VBO != 0) {
+        glDeleteBuffers(1, &VBO);
+        VBO = 0;
+    }
+    if (shaderProgram != 0) {
+        glDeleteProgram(shaderProgram);
+        shaderProgram = 0;
+    }
+}
+
+void Overlay::setLines(const std::vector<std::string>& newLines)
+{
+    if (newLines == lines) {
+        return;
+    }
+    
+    lines = newLines;
+    buildVertices();
+}
+
+void Overlay::clear()
+{
+    setLines({});
+}
+
+void Overlay::render(int viewportWidth, int viewportHeight)
+{
+    if (shaderProgram == 0 || textVertexCount == 0 || viewportWidth <= 0 || viewportHeight <= 0) {
+        return;
+    }
+    
+    glBindVertexArray(VAO);
+    if (buffersDirty) {
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_DYNAMIC_DRAW);
+        buffersDirty = false;
+    }
+    
+    glUseProgram(shaderProgram);
+    glUniform2f(screenSizeLoc, static_cast<float>(viewportWidth), static_cast<float>(viewportHeight));
+    
+    // Vertices are laid out for the top-left corner; other anchors shift the panel across and down
+    float offsetX = anchor != OverlayAnchor::TopLeft ? std::max(0.0f, viewportWidth - panelWidth - 2.0f * MARGIN) : 0.0f;
+    float offsetY = anchor == OverlayAnchor::BottomRight ? std::max(0.0f, viewportHeight - panelHeight - 2.0f * MARGIN) : 0.0f;
+    glUniform2f(offsetLoc, offsetX, offsetY);
+    
+    // Drawn on top of the scene, always filled (the scene may be in wireframe mode)
+    glDisable(GL_DEPTH_TEST);
+    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    
+    glUniform4f(colorLoc, 0.0f, 0.0f, 0.0f, 0.6f);
+    glDrawArrays(GL_TRIANGLES, 0, backgroundVertexCount);
+    
+    glUniform4f(colorLoc, 1.0f, 1.0f, 1.0f, 1.0f);
+    glDrawArrays(GL_TRIANGLES, backgroundVertexCount, textVertexCount);
+    
+    glDisable(GL_BLEND);
+    glEnable(GL_DEPTH_TEST);
+    glBindVertexArray(0);
+}
+
+void Overlay::buildVertices()
+{
+    vertices.clear();
+    backgroundVertexCount = 0;
+    textVertexCount = 0;
+    panelWidth = 0.0f;
+    panelHeight = 0.0f;
+    buffersDirty = true;
+    
+    size_t longestLine = 0;
+    for (const std::string& line : lines) {
+        longestLine = std::max(longestLine, line.size());
+    }
+    if (longestLine == 0) {
+        return;
+    }
+    
+    // Character cell: glyph plus one pixel of spacing each way
+    float cellWidth = (GLYPH_WIDTH + 1) * PIXEL_SCALE;
+    float cellHeight = (GLYPH_HEIGHT + 2) * PIXEL_SCALE;
+    
+    // Background panel
+    panelWidth = longestLine * cellWidth + 2.0f * MARGIN;
+    panelHeight = lines.size() * cellHeight + 2.0f * MARGIN;
+    addQuad(MARGIN, MARGIN, MARGIN + panelWidth, MARGIN + panelHeight);
+    backgroundVertexCount = static_cast<int>(vertices.size() / 2);
+    
+    // One quad per lit font pixel
+    for (size_t row = 0; row < lines.size(); row++) {
+        float lineTop = 2.0f * MARGIN + row * cellHeight;
+        for (size_t column = 0; column < lines[row].size(); column++) {
+            const unsigned char* glyph = getGlyph(lines[row][column]);
+            float glyphLeft = 2.0f * MARGIN + column * cellWidth;
+            
+            for (int y = 0; y < GLYPH_HEIGHT; y++) {
+                for (int x = 0; x < GLYPH_WIDTH; x++) {
+                    if (glyph[y] & (0x10 >> x)) {
+                        float px = glyphLeft + x * PIXEL_SCALE;
+                        float py = lineTop + y * PIXEL_SCALE;
+                        addQuad(px, py, px + PIXEL_SCALE, py + PIXEL_SCALE);
+                    }
+                }
+            }
+        }
+    }
+    textVertexCount = static_cast<int>(vertices.size() / 2) - backgroundVertexCount;
+}
+
+void Overlay::addQuad(float x0, float y0, float x1, float y1)
+{
+    float quad[] = {
+        x0, y0,  x1, y0,  x1, y1,
+        x0, y0,  x1, y1,  x0, y1
+    };
+    vertices.insert(vertices.end(), std::begin(quad), std::end(quad));
+}
+
+const unsigned char* Overlay::getGlyph(char c)
+{
+    char upper = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+    for (const Glyph& glyph : FONT) {
+        if (glyph.character == upper) {
+            return glyph.rows;
+        }
+    }
+    
+    // Unknown characters show as '?' (last entry)
+    return FONT[sizeof(FONT) / sizeof(FONT[0]) - 1].rows;
+}
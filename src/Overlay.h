@@ -0,0 +1,56 @@
+#ifndef OVERLAY_H
+#define OVERLAY_H
+
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+
+// Viewport corner an overlay panel is attached to
+enum class OverlayAnchor { TopLeft, TopRight, BottomRight };
+
+// Screen-space text overlay drawn with a built-in 5x7 bitmap font (upper case, digits and
+// common punctuation). Each lit font pixel becomes a quad; the vertex data is rebuilt only
+// when the text changes.
+class Overlay
+{
+public:
+    explicit Overlay(OverlayAnchor anchor = OverlayAnchor::TopLeft);
+    ~Overlay();
+
+    bool initialize();
+    void cleanup();
+
+    // Replace the displayed lines (in the anchor corner of the viewport)
+    void setLines(const std::vector<std::string>& lines);
+    void clear();
+
+    // Draw over the current frame; viewport size in pixels
+    void render(int viewportWidth, int viewportHeight);
+
+private:
+    unsigned int shaderProgram;
+    unsigned int VAO, VBO;
+    int screenSizeLoc;
+    int colorLoc;
+    int offsetLoc;
+    OverlayAnchor anchor;
+
+    std::vector<std::string> lines;
+    std::vector<float> vertices;     // x, y in pixels; background quad first, then glyphs
+    int backgroundVertexCount;
+    int textVertexCount;
+    float panelWidth;                // Including margins; places right-anchored panels
+    float panelHeight;               // Including margins; places bottom-anchored panels
+    bool buffersDirty;
+
+    static constexpr int GLYPH_WIDTH = 5;
+    static constexpr int GLYPH_HEIGHT = 7;
+    static constexpr float PIXEL_SCALE = 2.0f;   // Screen pixels per font pixel
+    static constexpr float MARGIN = 10.0f;       // Pixels from the viewport corner and around the text
+
+    void buildVertices();
+    void addQuad(float x0, float y0, float x1, float y1);
+    static const unsigned char* getGlyph(char c);
+};
+
+#endif
@@ -0,0 +1,268 @@
+#include "PerfCounters.h"
+#include <atomic>
+#include <cstring>
+#include <iostream>
+
+#if defined(FT_SIM_PERF_COUNTERS) && defined(__linux__)
+#define PERF_COUNTERS_SUPPORTED 1
+#include <cerrno>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    const char* getRegionKey(PerfRegion region)
+    {
+        switch (region) {
+            case PerfRegion::Row:      return "row";
+            case PerfRegion::BvhBuild: return "bvh_build";
+            case PerfRegion::RayCast:  return "ray_cast";
+            default:                   return "unknown";
+        }
+    }
+    
+    const char* getEventKey(PerfEvent event)
+    {
+        switch (event) {
+            case PerfEvent::Cycles:       return "cycles";
+            case PerfEvent::Instructions: return "instructions";
+            case PerfEvent::LlcMisses:    return "llc_misses";
+            case PerfEvent::BranchMisses: return "branch_misses";
+            default:                      return "unknown";
+        }
+    }
+
+#ifdef PERF_COUNTERS_SUPPORTED
+    struct ThreadCounters {
+        bool opened = false;
+        bool available = false;
+        int leaderFd = -1;
+        int fds[PerfTotals::EVENTS] = {-1, -1, -1, -1};
+        size_t groupIndex[PerfTotals::EVENTS] = {};   // Position of each event in a group read
+        size_t groupSize = 0;
+        PerfTotals totals;
+        
+        ~ThreadCounters()
+        {
+            for (int fd : fds) {
+                if (fd >= 0) close(fd);
+            }
+        }
+    };
+    
+    thread_local ThreadCounters threadCounters;
+    
+    // Reported once per process rather than once per thread (threads open their groups concurrently)
+    std::atomic<bool> unavailableReported{false};
+    
+    int openEvent(uint64_t config, int groupFd)
+    {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = config;
+        attr.disabled = groupFd < 0 ? 1 : 0;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        
+        // This thread, any CPU. Threads it starts later are not counted (inherit cannot be combined
+        // with group reads), and neither are Embree's worker threads, which exist already.
+        return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, groupFd, 0));
+    }
+    
+    bool openThreadCounters(ThreadCounters& counters)
+    {
+        counters.opened = true;
+        
+        const uint64_t configs[PerfTotals::EVENTS] = {
+            PERF_COUNT_HW_CPU_CYCLES,
+            PERF_COUNT_HW_INSTRUCTIONS,
+            PERF_COUNT_HW_CACHE_MISSES,
+            PERF_COUNT_HW_BRANCH_MISSES
+        };
+        
+        // The first event that opens leads the group; the rest join it or are left out
+        int firstError = 0;
+        for (size_t e = 0; e < PerfTotals::EVENTS; e++) {
+            int fd = openEvent(configs[e], counters.leaderFd);
+            if (fd < 0) {
+                if (firstError == 0) firstError = errno;
+                continue;
+            }
+            if (counters.leaderFd < 0) {
+                counters.leaderFd = fd;
+            }
+            counters.fds[e] = fd;
+            counters.groupIndex[e] = counters.groupSize++;
+            counters.totals.eventAvailable[e] = true;
+        }
+        
+        if (counters.leaderFd < 0) {
+            if (!unavailableReported.exchange(true)) {
+                std::cerr << "Hardware counters unavailable (perf_event_open: " << std::strerror(firstError)
+                          << "); check /proc/sys/kernel/perf_event_paranoid" << std::endl;
+            }
+            return false;
+        }
+        
+        ioctl(counters.leaderFd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(counters.leaderFd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+        counters.available = true;
+        return true;
+    }
+    
+    // Group read: nr, time enabled, time running, then nr values
+    bool readThreadCounters(ThreadCounters& counters, uint64_t* snapshot)
+    {
+        uint64_t buffer[3 + PerfTotals::EVENTS];
+        ssize_t expected = static_cast<ssize_t>((3 + counters.groupSize) * sizeof(uint64_t));
+        if (read(counters.leaderFd, buffer, sizeof(buffer)) != expected) {
+            return false;
+        }
+        
+        snapshot[0] = buffer[1];
+        snapshot[1] = buffer[2];
+        for (size_t e = 0; e < PerfTotals::EVENTS; e++) {
+            snapshot[2 + e] = counters.fds[e] >= 0 ? buffer[3 + counters.groupIndex[e]] : 0;
+        }
+        return true;
+    }
+#endif
+}
+
+void PerfTotals::merge(const PerfTotals& other)
+{
+    for (size_t r = 0; r < REGIONS; r++) {
+        calls[r] += other.calls[r];
+        for (size_t e = 0; e < EVENTS; e++) {
+            values[r][e] += other.values[r][e];
+        }
+    }
+    for (size_t e = 0; e < EVENTS; e++) {
+        eventAvailable[e] = eventAvailable[e] || other.eventAvailable[e];
+    }
+}
+
+void PerfTotals::writeJson(std::ostream& out, const char* indent) const
+{
+    bool anyEvent = false;
+    for (size_t e = 0; e < EVENTS; e++) {
+        anyEvent = anyEvent || eventAvailable[e];
+    }
+    
+    out << indent << "\"hardware_counters\": {\n";
+    out << indent << "  \"available\": " << (anyEvent ? "true" : "false");
+    if (!anyEvent) {
+        out << "\n" << indent << "}";
+        return;
+    }
+    out << ",\n";
+    
+    // Counter groups are per thread: work Embree hands to its own threads (most of a BVH
+    // build) is not in these values
+    out << indent << "  \"scope\": \"calling_thread\",\n";
+    out << indent << "  \"note\": \"bvh_build counts only the thread that commits the scene, not Embree's build threads\",\n";
+    
+    size_t cycles = static_cast<size_t>(PerfEvent::Cycles);
+    size_t instructions = static_cast<size_t>(PerfEvent::Instructions);
+    size_t llcMisses = static_cast<size_t>(PerfEvent::LlcMisses);
+    
+    for (size_t r = 0; r < REGIONS; r++) {
+        out << indent << "  \"" << getRegionKey(static_cast<PerfRegion>(r)) << "\": {\"calls\": " << calls[r];
+        for (size_t e = 0; e < EVENTS; e++) {
+            if (eventAvailable[e]) {
+                out << ", \"" << getEventKey(static_cast<PerfEvent>(e)) << "\": " << values[r][e];
+            }
+        }
+        if (eventAvailable[cycles] && eventAvailable[instructions] && values[r][cycles] > 0) {
+            out << ", \"ipc\": " << static_cast<double>(values[r][instructions]) / values[r][cycles];
+        }
+        if (eventAvailable[llcMisses] && eventAvailable[instructions] && values[r][instructions] > 0) {
+            out << ", \"llc_mpki\": " << values[r][llcMisses] * 1000.0 / values[r][instructions];
+        }
+        out << "}" << (r + 1 < REGIONS ? ",\n" : "\n");
+    }
+    out << indent << "}";
+}
+
+bool PerfCounters::isCompiledIn()
+{
+#ifdef PERF_COUNTERS_SUPPORTED
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool PerfCounters::isAvailable()
+{
+#ifdef PERF_COUNTERS_SUPPORTED
+    if (!threadCounters.opened) {
+        openThreadCounters(threadCounters);
+    }
+    return threadCounters.available;
+#else
+    return false;
+#endif
+}
+
+void PerfCounters::takeThreadTotals(PerfTotals& totals)
+{
+#ifdef PERF_COUNTERS_SUPPORTED
+    totals = threadCounters.totals;
+    resetThread();
+#else
+    totals = PerfTotals();
+#endif
+}
+
+void PerfCounters::resetThread()
+{
+#ifdef PERF_COUNTERS_SUPPORTED
+    // Keep the record of which events this thread's group counts
+    PerfTotals cleared;
+    std::memcpy(cleared.eventAvailable, threadCounters.totals.eventAvailable, sizeof(cleared.eventAvailable));
+    threadCounters.totals = cleared;
+#endif
+}
+
+void PerfCounters::beginRegion(PerfRegion, uint64_t* snapshot)
+{
+#ifdef PERF_COUNTERS_SUPPORTED
+    snapshot[0] = 0;
+    if (isAvailable() && !readThreadCounters(threadCounters, snapshot)) {
+        snapshot[0] = 0;
+    }
+#else
+    (void)snapshot;
+#endif
+}
+
+void PerfCounters::endRegion(PerfRegion region, const uint64_t* snapshot)
+{
+#ifdef PERF_COUNTERS_SUPPORTED
+    uint64_t current[SNAPSHOT_SIZE];
+    if (!threadCounters.available || snapshot[0] == 0 || !readThreadCounters(threadCounters, current)) {
+        return;
+    }
+    
+    // Scale up when the kernel multiplexed the group off the PMU for part of the region
+    uint64_t enabled = current[0] - snapshot[0];
+    uint64_t running = current[1] - snapshot[1];
+    double scale = running > 0 && running < enabled ? static_cast<double>(enabled) / running : 1.0;
+    
+    PerfTotals& totals = threadCounters.totals;
+    size_t r = static_cast<size_t>(region);
+    totals.calls[r]++;
+    for (size_t e = 0; e < PerfTotals::EVENTS; e++) {
+        totals.values[r][e] += static_cast<uint64_t>((current[2 + e] - snapshot[2 + e]) * scale);
+    }
+#else
+    (void)region;
+    (void)snapshot;
+#endif
+}
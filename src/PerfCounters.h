@@ -0,0 +1,88 @@
+#ifndef PERFCOUNTERS_H
+#define PERFCOUNTERS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+// Code regions measured with hardware counters
+enum class PerfRegion {
+    Row,            // One bulk row (pose, geometry refresh, all ray passes)
+    BvhBuild,       // Embree scene commits
+    RayCast,        // rtcIntersect loop of one electrode
+    Count
+};
+
+// Hardware events of a counter group
+enum class PerfEvent {
+    Cycles,
+    Instructions,
+    LlcMisses,      // Last-level cache misses (PERF_COUNT_HW_CACHE_MISSES)
+    BranchMisses,
+    Count
+};
+
+struct PerfTotals {
+    static constexpr size_t REGIONS = static_cast<size_t>(PerfRegion::Count);
+    static constexpr size_t EVENTS = static_cast<size_t>(PerfEvent::Count);
+
+    uint64_t calls[REGIONS] = {};
+    uint64_t values[REGIONS][EVENTS] = {};   // Scaled for multiplexing
+    bool eventAvailable[EVENTS] = {};
+
+    void merge(const PerfTotals& other);
+
+    // "hardware_counters" object for the run report (cycles, instructions, misses, IPC, MPKI)
+    void writeJson(std::ostream& out, const char* indent) const;
+};
+
+// Per-thread hardware counters through perf_event_open (Linux, built with FT_SIM_PERF_COUNTERS).
+// Each thread opens one counter group (cycles as leader) on its first region and keeps it
+// counting; a region reads the group at entry and exit and adds the difference to the
+// thread's totals, so guards may nest. Events the CPU or kernel refuses are left out of the
+// group, and if none can be opened (perf_event_paranoid, containers, no PMU in a VM) regions
+// cost a flag check and the report says the counters were unavailable. Only the calling
+// thread is counted: a region's work on other threads (Embree's BVH build threads) is not.
+class PerfCounters
+{
+public:
+    // True when compiled in; false where perf_event_open does not exist
+    static bool isCompiledIn();
+
+    // Whether the calling thread's counter group is open (opens it on first call)
+    static bool isAvailable();
+
+    static void takeThreadTotals(PerfTotals& totals);
+    static void resetThread();
+
+    static void beginRegion(PerfRegion region, uint64_t* snapshot);
+    static void endRegion(PerfRegion region, const uint64_t* snapshot);
+
+    // Entries of a region snapshot: time enabled, time running, then one value per event
+    static constexpr size_t SNAPSHOT_SIZE = 2 + PerfTotals::EVENTS;
+};
+
+class PerfRegionGuard
+{
+public:
+    explicit PerfRegionGuard(PerfRegion region) : region(region) { PerfCounters::beginRegion(region, snapshot); }
+    ~PerfRegionGuard() { PerfCounters::endRegion(region, snapshot); }
+
+    PerfRegionGuard(const PerfRegionGuard&) = delete;
+    PerfRegionGuard& operator=(const PerfRegionGuard&) = delete;
+
+private:
+    PerfRegion region;
+    uint64_t snapshot[PerfCounters::SNAPSHOT_SIZE];
+};
+
+#define FT_PERF_CONCAT_INNER(a, b) a##b
+#define FT_PERF_CONCAT(a, b) FT_PERF_CONCAT_INNER(a, b)
+
+#if defined(FT_SIM_PERF_COUNTERS) && defined(__linux__)
+#define FT_PERF_REGION(region) PerfRegionGuard FT_PERF_CONCAT(perfRegion, __LINE__)(region)
+#else
+#define FT_PERF_REGION(region) ((void)0)
+#endif
+
+#endif
@@ -0,0 +1,395 @@
+#include "PlyLoader.h"
+#include "MappedFile.h"
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <sstream>
+
+// Static member initialization
+thread_local std::string PlyLoader::lastError = "";
+
+bool PlyLoader::loadPLY(const std::string& filePath,
+                        std::vector<float>& vertices,
+                        std::vector<unsigned int>& indices,
+                        size_t& vertexCount,
+                        size_t& triangleCount)
+{
+    MappedFile file;
+    if (!file.open(filePath)) {
+        vertices.clear();
+        indices.clear();
+        vertexCount = 0;
+        triangleCount = 0;
+        lastError = "Failed to open " + filePath;
+        return false;
+    }
+    
+    return loadPLY(filePath, file.data(), file.size(), vertices, indices, vertexCount, triangleCount);
+}
+
+bool PlyLoader::loadPLY(const std::string& filePath, const char* data, size_t size,
+                        std::vector<float>& vertices,
+                        std::vector<unsigned int>& indices,
+                        size_t& vertexCount,
+                        size_t& triangleCount)
+{
+    vertices.clear();
+    indices.clear();
+    vertexCount = 0;
+    triangleCount = 0;
+    lastError = "";
+    
+    Format format;
+    std::vector<Element> elements;
+    size_t bodyOffset = 0;
+    if (!parseHeader(data, size, format, elements, bodyOffset)) {
+        lastError = "Invalid PLY header in " + filePath + (lastError.empty() ? "" : ": " + lastError);
+        return false;
+    }
+    
+    bool bigEndian = format == Format::BinaryBigEndian;
+    bool ascii = format == Format::Ascii;
+    
+    // The header counts are only trusted once the body is large enough to hold them
+    // (an ASCII body may lack the separator after its last value)
+    size_t bodyBytes = size - bodyOffset + (ascii ? 1 : 0);
+    size_t requiredBytes = 0;
+    for (const Element& element : elements) {
+        size_t recordBytes = getMinimumRecordSize(element, ascii);
+        if (element.count > (bodyBytes - requiredBytes) / recordBytes) {
+            lastError = "PLY element count exceeds the file size (" + element.name + ") in " + filePath;
+            return false;
+        }
+        requiredBytes += element.count * recordBytes;
+    }
+    
+    // Size the outputs from the header counts (faces are assumed to be triangles; polygons grow the index buffer)
+    for (const Element& element : elements) {
+        if (element.name == "vertex") {
+            vertices.reserve(element.count * 3);
+        } else if (element.name == "face") {
+            indices.reserve(element.count * 3);
+        }
+    }
+    
+    const char* cursor = data + bodyOffset;
+    const char* end = data + size;
+    size_t loadedVertices = 0;
+    
+    auto readScalar = [&](ScalarType type, double& value) {
+        return ascii ? readAsciiScalar(cursor, end, value) : readBinaryScalar(cursor, end, type, bigEndian, value);
+    };
+    
+    std::vector<double> faceCorners;
+    
+    for (const Element& element : elements) {
+        // Positions of x/y/z within the vertex properties
+        int axisProperty[3] = {-1, -1, -1};
+        int faceProperty = -1;
+        for (size_t p = 0; p < element.properties.size(); p++) {
+            const Property& property = element.properties[p];
+            if (element.name == "vertex" && !property.isList) {
+                if (property.name == "x") axisProperty[0] = static_cast<int>(p);
+                if (property.name == "y") axisProperty[1] = static_cast<int>(p);
+                if (property.name == "z") axisProperty[2] = static_cast<int>(p);
+            }
+            if (element.name == "face" && property.isList &&
+                (property.name == "vertex_indices" || property.name == "vertex_index")) {
+                faceProperty = static_cast<int>(p);
+            }
+        }
+        
+        if (element.name == "vertex" && (axisProperty[0] < 0 || axisProperty[1] < 0 || axisProperty[2] < 0)) {
+            lastError = "PLY vertex element has no x/y/z properties: " + filePath;
+            return false;
+        }
+        
+        for (size_t item = 0; item < element.count; item++) {
+            float position[3] = {0.0f, 0.0f, 0.0f};
+            
+            for (size_t p = 0; p < element.properties.size(); p++) {
+                const Property& property = element.properties[p];
+                
+                if (!property.isList) {
+                    double value = 0.0;
+                    if (!readScalar(property.type, value)) {
+                        lastError = "Truncated PLY data in " + filePath;
+                        return false;
+                    }
+                    for (int axis = 0; axis < 3; axis++) {
+                        if (axisProperty[axis] == static_cast<int>(p)) {
+                            position[axis] = static_cast<float>(value);
+                        }
+                    }
+                    continue;
+                }
+                
+                double countValue = 0.0;
+                if (!readScalar(property.countType, countValue) || !(countValue >= 0.0) ||
+                    countValue > static_cast<double>(end - cursor + (ascii ? 1 : 0)) / getMinimumValueSize(property.type, ascii)) {
+                    lastError = "Truncated PLY data in " + filePath;
+                    return false;
+                }
+                size_t listCount = static_cast<size_t>(countValue);
+                
+                if (static_cast<int>(p) != faceProperty) {
+                    // Skip lists we do not use
+                    for (size_t i = 0; i < listCount; i++) {
+                        double ignored = 0.0;
+                        if (!readScalar(property.type, ignored)) {
+                            lastError = "Truncated PLY data in " + filePath;
+                            return false;
+                        }
+                    }
+                    continue;
+                }
+                
+                faceCorners.resize(listCount);
+                for (size_t i = 0; i < listCount; i++) {
+                    if (!readScalar(property.type, faceCorners[i])) {
+                        lastError = "Truncated PLY data in " + filePath;
+                        return false;
+                    }
+                }
+                
+                // Reject faces with indices that are not valid unsigned values (negative, fractional, NaN)
+                bool validFace = true;
+                for (size_t i = 0; i < listCount; i++) {
+                    double corner = faceCorners[i];
+                    if (!(corner >= 0.0 && corner <= static_cast<double>(UINT32_MAX)) || corner != std::floor(corner)) {
+                        validFace = false;
+                    }
+                }
+                if (!validFace) {
+                    continue;
+                }
+                
+                // Fan-triangulate: (0, i, i + 1)
+                for (size_t i = 1; i + 1 < listCount; i++) {
+                    indices.push_back(static_cast<unsigned int>(faceCorners[0]));
+                    indices.push_back(static_cast<unsigned int>(faceCorners[i]));
+                    indices.push_back(static_cast<unsigned int>(faceCorners[i + 1]));
+                }
+            }
+            
+            if (element.name == "vertex") {
+                vertices.push_back(position[0]);
+                vertices.push_back(position[1]);
+                vertices.push_back(position[2]);
+                loadedVertices++;
+            }
+        }
+    }
+    
+    // Drop faces that reference missing vertices
+    size_t validIndices = 0;
+    for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+        if (indices[i] >= loadedVertices || indices[i + 1] >= loadedVertices || indices[i + 2] >= loadedVertices) {
+            continue;
+        }
+        indices[validIndices++] = indices[i];
+        indices[validIndices++] = indices[i + 1];
+        indices[validIndices++] = indices[i + 2];
+    }
+    indices.resize(validIndices);
+    
+    if (vertices.empty() || indices.empty()) {
+        lastError = "No vertex data found in " + filePath;
+        return false;
+    }
+    
+    vertexCount = vertices.size() / 3;
+    triangleCount = indices.size() / 3;
+    
+    return true;
+}
+
+std::string PlyLoader::getLastError()
+{
+    return lastError;
+}
+
+bool PlyLoader::parseHeader(const char* data, size_t size, Format& format,
+                            std::vector<Element>& elements, size_t& bodyOffset)
+{
+    // The header is ASCII and ends with an "end_header" line
+    const char* headerEnd = nullptr;
+    for (size_t i = 0; i + 10 <= size; i++) {
+        if (std::memcmp(data + i, "end_header", 10) == 0 && (i == 0 || data[i - 1] == '\n')) {
+            headerEnd = data + i;
+            break;
+        }
+    }
+    
+    if (size < 3 || std::memcmp(data, "ply", 3) != 0 || !headerEnd) {
+        return false;
+    }
+    
+    const char* bodyStart = static_cast<const char*>(std::memchr(headerEnd, '\n', data + size - headerEnd));
+    if (!bodyStart) {
+        return false;
+    }
+    bodyOffset = static_cast<size_t>(bodyStart + 1 - data);
+    
+    std::istringstream header(std::string(data, headerEnd - data));
+    std::string line;
+    bool hasFormat = false;
+    
+    while (std::getline(header, line)) {
+        std::istringstream tokens(line);
+        std::string keyword;
+        tokens >> keyword;
+        
+        if (keyword == "format") {
+            std::string formatName;
+            tokens >> formatName;
+            if (formatName == "ascii") {
+                format = Format::Ascii;
+            } else if (formatName == "binary_little_endian") {
+                format = Format::BinaryLittleEndian;
+            } else if (formatName == "binary_big_endian") {
+                format = Format::BinaryBigEndian;
+            } else {
+                lastError = "unknown format " + formatName;
+                return false;
+            }
+            hasFormat = true;
+        }
+        else if (keyword == "element") {
+            // from_chars rejects signs, so "-1" is not read as a huge count
+            Element element;
+            std::string countText;
+            tokens >> element.name >> countText;
+            const char* countEnd = countText.data() + countText.size();
+            auto parsed = std::from_chars(countText.data(), countEnd, element.count);
+            if (element.name.empty() || parsed.ec != std::errc() || parsed.ptr != countEnd) {
+                lastError = "invalid element count '" + countText + "'";
+                return false;
+            }
+            elements.push_back(element);
+        }
+        else if (keyword == "property") {
+            if (elements.empty()) {
+                return false;
+            }
+            
+            Property property;
+            std::string typeName;
+            tokens >> typeName;
+            if (typeName == "list") {
+                std::string countTypeName;
+                tokens >> countTypeName >> typeName;
+                property.isList = true;
+                property.countType = parseScalarType(countTypeName);
+                if (property.countType == ScalarType::Invalid) {
+                    lastError = "unknown type " + countTypeName;
+                    return false;
+                }
+            }
+            property.type = parseScalarType(typeName);
+            if (property.type == ScalarType::Invalid) {
+                lastError = "unknown type " + typeName;
+                return false;
+            }
+            tokens >> property.name;
+            elements.back().properties.push_back(property);
+        }
+        // comment, obj_info and ply lines need no handling
+    }
+    
+    return hasFormat;
+}
+
+PlyLoader::ScalarType PlyLoader::parseScalarType(const std::string& name)
+{
+    if (name == "char" || name == "int8") return ScalarType::Int8;
+    if (name == "uchar" || name == "uint8") return ScalarType::UInt8;
+    if (name == "short" || name == "int16") return ScalarType::Int16;
+    if (name == "ushort" || name == "uint16") return ScalarType::UInt16;
+    if (name == "int" || name == "int32") return ScalarType::Int32;
+    if (name == "uint" || name == "uint32") return ScalarType::UInt32;
+    if (name == "float" || name == "float32") return ScalarType::Float32;
+    if (name == "double" || name == "float64") return ScalarType::Float64;
+    return ScalarType::Invalid;
+}
+
+size_t PlyLoader::getScalarSize(ScalarType type)
+{
+    switch (type) {
+        case ScalarType::Int8:
+        case ScalarType::UInt8:
+            return 1;
+        case ScalarType::Int16:
+        case ScalarType::UInt16:
+            return 2;
+        case ScalarType::Int32:
+        case ScalarType::UInt32:
+        case ScalarType::Float32:
+            return 4;
+        case ScalarType::Float64:
+            return 8;
+        default:
+            return 0;
+    }
+}
+
+size_t PlyLoader::getMinimumValueSize(ScalarType type, bool ascii)
+{
+    return ascii ? 2 : std::max<size_t>(getScalarSize(type), 1);
+}
+
+size_t PlyLoader::getMinimumRecordSize(const Element& element, bool ascii)
+{
+    size_t recordBytes = 0;
+    for (const Property& property : element.properties) {
+        recordBytes += getMinimumValueSize(property.isList ? property.countType : property.type, ascii);
+    }
+    return std::max<size_t>(recordBytes, 1);
+}
+
+bool PlyLoader::readBinaryScalar(const char*& cursor, const char* end, ScalarType type,
+                                 bool bigEndian, double& value)
+{
+    size_t size = getScalarSize(type);
+    if (size == 0 || static_cast<size_t>(end - cursor) < size) {
+        return false;
+    }
+    
+    unsigned char bytes[8];
+    std::memcpy(bytes, cursor, size);
+    if (bigEndian) {
+        std::reverse(bytes, bytes + size);
+    }
+    cursor += size;
+    
+    switch (type) {
+        case ScalarType::Int8:    { int8_t v;   std::memcpy(&v, bytes, 1); value = v; break; }
+        case ScalarType::UInt8:   { uint8_t v;  std::memcpy(&v, bytes, 1); value = v; break; }
+        case ScalarType::Int16:   { int16_t v;  std::memcpy(&v, bytes, 2); value = v; break; }
+        case ScalarType::UInt16:  { uint16_t v; std::memcpy(&v, bytes, 2); value = v; break; }
+        case ScalarType::Int32:   { int32_t v;  std::memcpy(&v, bytes, 4); value = v; break; }
+        case ScalarType::UInt32:  { uint32_t v; std::memcpy(&v, bytes, 4); value = v; break; }
+        case ScalarType::Float32: { float v;    std::memcpy(&v, bytes, 4); value = v; break; }
+        case ScalarType::Float64: { double v;   std::memcpy(&v, bytes, 8); value = v; break; }
+        default: return false;
+    }
+    
+    return true;
+}
+
+bool PlyLoader::readAsciiScalar(const char*& cursor, const char* end, double& value)
+{
+    while (cursor < end && (*cursor == ' ' || *cursor == '\t' || *cursor == '\r' || *cursor == '\n')) {
+        cursor++;
+    }
+    
+    std::from_chars_result result = std::from_chars(cursor, end, value);
+    if (result.ec != std::errc()) {
+        return false;
+    }
+    
+    cursor = result.ptr;
+    return true;
+}
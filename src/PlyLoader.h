@@ -0,0 +1,66 @@
+#ifndef PLYLOADER_H
+#define PLYLOADER_H
+
+#include <vector>
+#include <string>
+
+// PLY loader for binary (little/big endian) and ASCII files. The file is
+// memory-mapped and the element counts from the header size the output
+// buffers up front; polygon faces are fan-triangulated.
+class PlyLoader
+{
+public:
+    // Load a PLY file and return vertex data
+    static bool loadPLY(const std::string& filePath,
+                        std::vector<float>& vertices,
+                        std::vector<unsigned int>& indices,
+                        size_t& vertexCount,
+                        size_t& triangleCount);
+
+    // Same, parsing a file that is already in memory (filePath is used in messages)
+    static bool loadPLY(const std::string& filePath, const char* data, size_t size,
+                        std::vector<float>& vertices,
+                        std::vector<unsigned int>& indices,
+                        size_t& vertexCount,
+                        size_t& triangleCount);
+
+    // Get last error message
+    static std::string getLastError();
+
+private:
+    static thread_local std::string lastError;
+
+    enum class Format { Ascii, BinaryLittleEndian, BinaryBigEndian };
+    enum class ScalarType { Int8, UInt8, Int16, UInt16, Int32, UInt32, Float32, Float64, Invalid };
+
+    struct Property {
+        std::string name;
+        ScalarType type = ScalarType::Invalid;
+        bool isList = false;
+        ScalarType countType = ScalarType::Invalid;  // List length type
+    };
+
+    struct Element {
+        std::string name;
+        size_t count = 0;
+        std::vector<Property> properties;
+    };
+
+    // Header parsing; returns the offset of the first body byte
+    static bool parseHeader(const char* data, size_t size, Format& format,
+                            std::vector<Element>& elements, size_t& bodyOffset);
+    static ScalarType parseScalarType(const std::string& name);
+    static size_t getScalarSize(ScalarType type);
+
+    // Fewest body bytes one item (or one list entry) can take: binary scalar sizes, or a digit
+    // and a separator per ASCII value. Counts the remaining bytes cannot hold are rejected.
+    static size_t getMinimumRecordSize(const Element& element, bool ascii);
+    static size_t getMinimumValueSize(ScalarType type, bool ascii);
+
+    // Body readers (advance the cursor; false on truncated or malformed data)
+    static bool readBinaryScalar(const char*& cursor, const char* end, ScalarType type,
+                                 bool bigEndian, double& value);
+    static bool readAsciiScalar(const char*& cursor, const char* end, double& value);
+};
+
+#endif
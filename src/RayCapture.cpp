@@ -0,0 +1,52 @@
+#include "RayCapture.h"
+#include <algorithm>
+
+RayCapture::RayCapture(size_t rayBudget) : budget(std::max<size_t>(rayBudget, 1)), writeIndex(0), generation(0)
+{
+    passRays.resize(budget);
+    publishedRays.reserve(budget);
+}
+
+size_t RayCapture::getBudget() const
+{
+    return budget;
+}
+
+void RayCapture::beginPass()
+{
+    writerMutex.lock();
+    writeIndex = 0;
+}
+
+void RayCapture::record(const glm::vec3& origin, const glm::vec3& direction, float hitDistance, float maxDistance)
+{
+    // Ring: past the budget the oldest rays of the pass are overwritten
+    CapturedRay& ray = passRays[writeIndex % budget];
+    ray.origin = origin;
+    ray.hit = hitDistance >= 0.0f;
+    ray.end = origin + direction * (ray.hit ? hitDistance : maxDistance);
+    writeIndex++;
+}
+
+void RayCapture::endPass()
+{
+    size_t count = std::min(writeIndex, budget);
+    {
+        std::lock_guard<std::mutex> lock(publishedMutex);
+        publishedRays.assign(passRays.begin(), passRays.begin() + count);
+        generation++;
+    }
+    writerMutex.unlock();
+}
+
+bool RayCapture::getLatest(std::vector<CapturedRay>& rays, uint64_t& lastGeneration) const
+{
+    std::lock_guard<std::mutex> lock(publishedMutex);
+    if (generation <= lastGeneration) {
+        return false;
+    }
+    
+    rays = publishedRays;
+    lastGeneration = generation;
+    return true;
+}
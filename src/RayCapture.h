@@ -0,0 +1,63 @@
+#ifndef RAYCAPTURE_H
+#define RAYCAPTURE_H
+
+#include <cstdint>
+#include <mutex>
+#include <vector>
+#include <glm/glm.hpp>
+
+// One traced ray: from the triangle center to the hit point (or to the end of its range)
+struct CapturedRay {
+    glm::vec3 origin;
+    glm::vec3 end;
+    bool hit;
+};
+
+// Debug capture of the rays traced by a capacitance calculation. Each pass writes into a
+// preallocated ring of `budget` rays (the calculator subsamples to fit) and publishes it when
+// the pass ends; readers copy out the last published pass. Calculators only touch the capture
+// when one is attached, so a disabled capture costs nothing.
+class RayCapture
+{
+public:
+    explicit RayCapture(size_t budget = DEFAULT_BUDGET);
+
+    size_t getBudget() const;
+
+    // Writer side (the calculating thread); a pass holds the capture until it ends
+    void beginPass();
+    void record(const glm::vec3& origin, const glm::vec3& direction, float hitDistance, float maxDistance);
+    void endPass();
+
+    // Copy out the last published pass if it is newer than lastGeneration
+    bool getLatest(std::vector<CapturedRay>& rays, uint64_t& lastGeneration) const;
+
+    static constexpr size_t DEFAULT_BUDGET = 20000;
+
+private:
+    size_t budget;
+
+    std::mutex writerMutex;              // Held from beginPass to endPass
+    std::vector<CapturedRay> passRays;   // Ring written by the current pass
+    size_t writeIndex;
+
+    mutable std::mutex publishedMutex;
+    std::vector<CapturedRay> publishedRays;
+    uint64_t generation;
+};
+
+// Scoped pass on an optional capture
+class RayCapturePass
+{
+public:
+    explicit RayCapturePass(RayCapture* capture) : capture(capture) { if (capture) capture->beginPass(); }
+    ~RayCapturePass() { if (capture) capture->endPass(); }
+
+    RayCapturePass(const RayCapturePass&) = delete;
+    RayCapturePass& operator=(const RayCapturePass&) = delete;
+
+private:
+    RayCapture* capture;
+};
+
+#endif
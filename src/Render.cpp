@@ -1,10 +1,29 @@
 #include "Render.h"
 #include <glad/glad.h>
+#include <cstring>
 #include <iostream>
 #include <fstream>
 #include <sstream>
 
-Render::Render() : shaderProgram(0), axesVAO(0), axesVBO(0), axesInitialized(false)
+// Buffer storage (GL 4.4 / ARB_buffer_storage) is not part of the 3.3 core loader
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#endif
+#ifndef GL_MAP_COHERENT_BIT
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+typedef void (APIENTRY *BufferStorageProc)(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+
+Render::Render() : shaderProgram(0), modelLoc(-1), colorLoc(-1), instancedLoc(-1),
+                   heatmapLoc(-1), heatmapRangeLoc(-1), triangleScalarsLoc(-1),
+                   cameraUBO(0), cameraUploaded(false),
+                   instanceVBO(0), instanceCapacity(0), procLoader(nullptr), persistentMappingSupported(false),
+                   instanceMapping(nullptr), instanceRegion(0), regionFences{},
+                   instanceVersion(0), instanceWireframe(false), instancesDirty(true),
+                   heatmapEnabled(false), heatmapMin(0.0f), heatmapMax(1.0f),
+                   rayShaderProgram(0), rayVAO(0), rayVBO(0), rayCapacity(0), rayVertexCount(0),
+                   rayMapping(nullptr), rayFence(nullptr), frameTimer(nullptr),
+                   axesVAO(0), axesVBO(0), axesInitialized(false)
 {
 }
 
@@ -14,6 +33,16 @@ Render::~Render()
 }
 
 bool Render::initialize(const std::vector<Model>& models)
+{
+    if (!initialize()) {
+        return false;
+    }
+    
+    uploadModels(models);
+    return true;
+}
+
+bool Render::initialize(GLProcLoader loader)
 {
     std::cout << "Initializing renderer..." << std::endl;
     
@@ -23,19 +52,69 @@ bool Render::initialize(const std::vector<Model>& models)
         return false;
     }
     
+    cacheUniformLocations();
+    setupCameraBlock();
+    
+    // Instance buffer must exist before any mesh VAO is created
+    procLoader = loader;
+    persistentMappingSupported = procLoader && supportsBufferStorage();
+    allocateInstanceBuffer(0);
+    std::cout << "Instance data: " << (persistentMappingSupported ? "persistently mapped buffer" : "orphaned buffer uploads") << std::endl;
+    
     // Setup coordinate axes
     setupCoordinateAxes();
     
-    // Copy models and set up their buffers
-    renderModels = models;
-    for (size_t i = 0; i < renderModels.size(); i++) {
-        setupModelBuffers(renderModels[i]);
+    if (!setupRayLines()) {
+        std::cerr << "Failed to set up ray line shader; ray capture will not be drawn" << std::endl;
     }
     
     std::cout << "Renderer initialized successfully" << std::endl;
     return true;
 }
 
+void Render::uploadModels(const std::vector<Model>& models)
+{
+    // Copy model instances; models sharing a mesh share its GPU buffers
+    renderModels = models;
+    modelMeshBuffers.resize(renderModels.size());
+    for (size_t i = 0; i < renderModels.size(); i++) {
+        modelMeshBuffers[i] = getMeshBuffers(*renderModels[i].mesh);
+    }
+    rebuildDrawBatches();
+    
+    std::cout << "Uploaded " << meshBuffers.size() << " unique meshes for " << renderModels.size() << " models" << std::endl;
+}
+
+void Render::updateModelMeshes(const std::vector<Model>& models, const std::vector<ModelId>& changedModels)
+{
+    for (ModelId id : changedModels) {
+        if (id >= renderModels.size() || id >= models.size()) {
+            continue;
+        }
+        
+        MeshAssetPtr oldMesh = renderModels[id].mesh;
+        size_t oldBuffers = modelMeshBuffers[id];
+        
+        renderModels[id].mesh = models[id].mesh;
+        modelMeshBuffers[id] = getMeshBuffers(*renderModels[id].mesh);
+        
+        // Free the old mesh's buffers once no model draws it anymore
+        bool stillUsed = false;
+        for (const Model& model : renderModels) {
+            if (model.mesh == oldMesh) {
+                stillUsed = true;
+                break;
+            }
+        }
+        if (!stillUsed) {
+            cleanupMeshBuffers(meshBuffers[oldBuffers]);
+            meshBufferLookup.erase(oldMesh.get());
+        }
+    }
+    
+    rebuildDrawBatches();
+}
+
 void Render::render(const glm::mat4& view, const glm::mat4& projection, 
                    TransformManager& transformManager, bool wireframe)
 {
@@ -43,13 +122,7 @@ void Render::render(const glm::mat4& view, const glm::mat4& projection,
     glUseProgram(shaderProgram);
     
     // Set matrices
-    int viewLoc = glGetUniformLocation(shaderProgram, "view");
-    int projLoc = glGetUniformLocation(shaderProgram, "projection");
-    int modelLoc = glGetUniformLocation(shaderProgram, "model");
-    int colorLoc = glGetUniformLocation(shaderProgram, "color");
-    
-    glUniformMatrix4fv(viewLoc, 1, GL_FALSE, &view[0][0]);
-    glUniformMatrix4fv(projLoc, 1, GL_FALSE, &projection[0][0]);
+    updateCameraBlock(view, projection);
     
     // Set wireframe mode
     if (wireframe) {
@@ -60,27 +133,53 @@ void Render::render(const glm::mat4& view, const glm::mat4& projection,
     }
     
     // Render coordinate axes first
-    renderCoordinateAxes(view, projection);
+    if (frameTimer) frameTimer->beginGpu(GpuStage::Axes);
+    renderCoordinateAxes(wireframe);
+    if (frameTimer) frameTimer->endGpu(GpuStage::Axes);
     
-    // Render each model with proper transformation order
-    for (const Model& model : renderModels) {
-        if (model.VAO == 0) continue; // Skip if not properly initialized
-        
-        // Get combined transformation matrix (includes all positioning and transformations)
-        glm::mat4 finalModelMatrix = transformManager.getCombinedTransform(model.name);
-        
-        glUniformMatrix4fv(modelLoc, 1, GL_FALSE, &finalModelMatrix[0][0]);
-        
-        // Set model color (darker for wireframe, but not too dark)
-        glm::vec3 renderColor = wireframe ? getDarkerColor(model.color) : model.color;
-        glUniform3fv(colorLoc, 1, &renderColor[0]);
-        
-        // Bind and draw
-        glBindVertexArray(model.VAO);
-        glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(model.indices.size()), GL_UNSIGNED_INT, 0);
+    // Rewrite instance data only when transforms, colors or batching changed
+    uint64_t transformVersion = transformManager.getTransformVersion();
+    if (instancesDirty || transformVersion != instanceVersion || wireframe != instanceWireframe) {
+        ScopedCpuTimer transformTimer(frameTimer, CpuStage::Transforms);
+        uploadInstanceData(transformManager, wireframe);
+        instanceVersion = transformVersion;
+        instanceWireframe = wireframe;
+        instancesDirty = false;
+    }
+    
+    // One draw call per unique mesh
+    ScopedCpuTimer submitTimer(frameTimer, CpuStage::Submit);
+    if (frameTimer) frameTimer->beginGpu(GpuStage::Models);
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+    glUniform1i(instancedLoc, 1);
+    size_t regionBase = instanceRegion * instanceCapacity;
+    if (heatmapEnabled) {
+        drawHeatmapInstances(regionBase);
+    } else {
+        for (const DrawBatch& batch : drawBatches) {
+            const MeshBuffers& buffers = meshBuffers[batch.meshBuffers];
+            if (buffers.VAO == 0) continue; // Skip if not properly initialized
+            
+            glBindVertexArray(buffers.VAO);
+            bindInstanceAttributes(regionBase + batch.firstInstance);
+            glDrawElementsInstanced(GL_TRIANGLES, buffers.indexCount, GL_UNSIGNED_INT, 0, batch.instanceCount);
+        }
     }
+    glUniform1i(instancedLoc, 0);
+    if (frameTimer) frameTimer->endGpu(GpuStage::Models);
     
     glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    
+    // The region stays readable by the GPU until this fence passes
+    if (instanceMapping) {
+        if (regionFences[instanceRegion]) {
+            glDeleteSync(static_cast<GLsync>(regionFences[instanceRegion]));
+        }
+        regionFences[instanceRegion] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+    
+    renderRayLines();
     
     // Reset line width
     if (wireframe) {
@@ -88,12 +187,79 @@ void Render::render(const glm::mat4& view, const glm::mat4& projection,
     }
 }
 
+void Render::setTriangleScalars(ModelId id, const std::vector<float>& values)
+{
+    if (id >= triangleScalars.size()) {
+        triangleScalars.resize(id + 1);
+    }
+    TriangleScalarBuffer& scalars = triangleScalars[id];
+    if (scalars.buffer == 0) {
+        glGenBuffers(1, &scalars.buffer);
+        glGenTextures(1, &scalars.texture);
+        glBindTexture(GL_TEXTURE_BUFFER, scalars.texture);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_R32F, scalars.buffer);
+        glBindTexture(GL_TEXTURE_BUFFER, 0);
+    }
+    
+    // One upload per update; the mesh itself is untouched
+    glBindBuffer(GL_TEXTURE_BUFFER, scalars.buffer);
+    if (values.size() == scalars.count) {
+        glBufferSubData(GL_TEXTURE_BUFFER, 0, values.size() * sizeof(float), values.data());
+    } else {
+        glBufferData(GL_TEXTURE_BUFFER, values.size() * sizeof(float), values.data(), GL_STREAM_DRAW);
+        scalars.count = values.size();
+    }
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+void Render::clearTriangleScalars()
+{
+    for (TriangleScalarBuffer& scalars : triangleScalars) {
+        if (scalars.texture != 0) {
+            glDeleteTextures(1, &scalars.texture);
+        }
+        if (scalars.buffer != 0) {
+            glDeleteBuffers(1, &scalars.buffer);
+        }
+    }
+    triangleScalars.clear();
+}
+
+void Render::setHeatmap(bool enabled, float rangeMin, float rangeMax)
+{
+    heatmapEnabled = enabled;
+    heatmapMin = rangeMin;
+    heatmapMax = rangeMax;
+}
+
 void Render::cleanup()
 {
-    // Clean up model buffers
-    for (Model& model : renderModels) {
-        cleanupModelBuffers(model);
+    // Clean up mesh buffers
+    for (MeshBuffers& buffers : meshBuffers) {
+        cleanupMeshBuffers(buffers);
+    }
+    meshBuffers.clear();
+    meshBufferLookup.clear();
+    modelMeshBuffers.clear();
+    renderModels.clear();
+    drawBatches.clear();
+    instanceModels.clear();
+    instanceData.clear();
+    
+    // Clean up heatmap scalars and ray lines
+    clearTriangleScalars();
+    cleanupRayLines();
+    
+    // Clean up instance buffer
+    releaseInstanceBuffer();
+    instancesDirty = true;
+    
+    // Clean up camera block
+    if (cameraUBO != 0) {
+        glDeleteBuffers(1, &cameraUBO);
+        cameraUBO = 0;
     }
+    cameraUploaded = false;
     
     // Clean up coordinate axes
     cleanupCoordinateAxes();
@@ -191,45 +357,318 @@ unsigned int Render::createShaderProgram(const std::string& vertexSource, const
     return program;
 }
 
-void Render::setupModelBuffers(Model& model)
+size_t Render::getMeshBuffers(const MeshAsset& mesh)
+{
+    auto it = meshBufferLookup.find(&mesh);
+    if (it != meshBufferLookup.end()) {
+        return it->second;
+    }
+    
+    size_t index = meshBuffers.size();
+    meshBuffers.emplace_back();
+    setupMeshBuffers(mesh, meshBuffers.back());
+    meshBufferLookup[&mesh] = index;
+    return index;
+}
+
+void Render::setupMeshBuffers(const MeshAsset& mesh, MeshBuffers& buffers)
 {
     // Generate buffers
-    glGenVertexArrays(1, &model.VAO);
-    glGenBuffers(1, &model.VBO);
-    glGenBuffers(1, &model.EBO);
+    glGenVertexArrays(1, &buffers.VAO);
+    glGenBuffers(1, &buffers.VBO);
+    glGenBuffers(1, &buffers.EBO);
     
     // Bind VAO
-    glBindVertexArray(model.VAO);
+    glBindVertexArray(buffers.VAO);
     
     // Bind and fill VBO
-    glBindBuffer(GL_ARRAY_BUFFER, model.VBO);
-    glBufferData(GL_ARRAY_BUFFER, model.vertices.size() * sizeof(float), model.vertices.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, buffers.VBO);
+    glBufferData(GL_ARRAY_BUFFER, mesh.vertices.size() * sizeof(float), mesh.vertices.data(), GL_STATIC_DRAW);
     
     // Bind and fill EBO
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, model.EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, model.indices.size() * sizeof(unsigned int), model.indices.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffers.EBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, mesh.indices.size() * sizeof(unsigned int), mesh.indices.data(), GL_STATIC_DRAW);
+    buffers.indexCount = static_cast<int>(mesh.indices.size());
     
     // Set vertex attributes (position only)
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
     glEnableVertexAttribArray(0);
     
+    // Per-instance attributes advance once per instance; render() points them into the instance buffer
+    for (unsigned int location = 1; location <= 5; location++) {
+        glEnableVertexAttribArray(location);
+        glVertexAttribDivisor(location, 1);
+    }
+    
     glBindVertexArray(0);
 }
 
-void Render::cleanupModelBuffers(Model& model)
+void Render::cleanupMeshBuffers(MeshBuffers& buffers)
+{
+    if (buffers.VAO != 0) {
+        glDeleteVertexArrays(1, &buffers.VAO);
+        buffers.VAO = 0;
+    }
+    if (buffers.VBO != 0) {
+        glDeleteBuffers(1, &buffers.VBO);
+        buffers.VBO = 0;
+    }
+    if (buffers.EBO != 0) {
+        glDeleteBuffers(1, &buffers.EBO);
+        buffers.EBO = 0;
+    }
+}
+
+bool Render::supportsBufferStorage() const
+{
+    GLint major = 0;
+    GLint minor = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &major);
+    glGetIntegerv(GL_MINOR_VERSION, &minor);
+    if (major > 4 || (major == 4 && minor >= 4)) {
+        return true;
+    }
+    
+    GLint extensionCount = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &extensionCount);
+    for (GLint i = 0; i < extensionCount; i++) {
+        const char* name = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, static_cast<GLuint>(i)));
+        if (name && std::strcmp(name, "GL_ARB_buffer_storage") == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void Render::allocateInstanceBuffer(size_t capacity)
+{
+    releaseInstanceBuffer();
+    instanceCapacity = capacity;
+    
+    glGenBuffers(1, &instanceVBO);
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+    
+    GLsizeiptr regionBytes = static_cast<GLsizeiptr>(capacity * sizeof(InstanceData));
+    BufferStorageProc bufferStorage = nullptr;
+    if (persistentMappingSupported && capacity > 0) {
+        bufferStorage = reinterpret_cast<BufferStorageProc>(procLoader("glBufferStorage"));
+    }
+    
+    if (bufferStorage) {
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        bufferStorage(GL_ARRAY_BUFFER, regionBytes * INSTANCE_REGIONS, nullptr, flags);
+        instanceMapping = glMapBufferRange(GL_ARRAY_BUFFER, 0, regionBytes * INSTANCE_REGIONS, flags);
+        if (!instanceMapping) {
+            // Immutable storage cannot be respecified; start over with a plain buffer
+            std::cerr << "Failed to map instance buffer persistently, falling back to uploads" << std::endl;
+            persistentMappingSupported = false;
+            glDeleteBuffers(1, &instanceVBO);
+            glGenBuffers(1, &instanceVBO);
+            glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+        }
+    }
+    if (!instanceMapping) {
+        glBufferData(GL_ARRAY_BUFFER, regionBytes, nullptr, GL_DYNAMIC_DRAW);
+    }
+    
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    instanceRegion = 0;
+    instancesDirty = true;
+}
+
+void Render::releaseInstanceBuffer()
+{
+    for (size_t region = 0; region < INSTANCE_REGIONS; region++) {
+        if (regionFences[region]) {
+            glDeleteSync(static_cast<GLsync>(regionFences[region]));
+            regionFences[region] = nullptr;
+        }
+    }
+    
+    if (instanceMapping) {
+        glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        instanceMapping = nullptr;
+    }
+    if (instanceVBO != 0) {
+        glDeleteBuffers(1, &instanceVBO);
+        instanceVBO = 0;
+    }
+    instanceCapacity = 0;
+    instanceRegion = 0;
+}
+
+void Render::uploadInstanceData(TransformManager& transformManager, bool wireframe)
+{
+    InstanceData* target = instanceData.data();
+    if (instanceMapping) {
+        // Write into the next region so frames still in flight keep reading theirs
+        instanceRegion = (instanceRegion + 1) % INSTANCE_REGIONS;
+        waitForRegion(instanceRegion);
+        target = static_cast<InstanceData*>(instanceMapping) + instanceRegion * instanceCapacity;
+    }
+    
+    // Gather per-instance transforms and colors in batch order
+    for (size_t i = 0; i < instanceModels.size(); i++) {
+        const Model& model = renderModels[instanceModels[i]];
+        InstanceData instance;
+        instance.model = transformManager.getCombinedTransform(model.id);
+        
+        // Darker for wireframe, but not too dark
+        instance.color = wireframe ? getDarkerColor(model.color) : model.color;
+        target[i] = instance;
+    }
+    
+    if (!instanceMapping) {
+        // Orphan the old storage so the driver need not wait on frames still using it
+        glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+        glBufferData(GL_ARRAY_BUFFER, instanceCapacity * sizeof(InstanceData), nullptr, GL_DYNAMIC_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, instanceData.size() * sizeof(InstanceData), instanceData.data());
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+}
+
+void Render::waitForRegion(size_t region)
+{
+    GLsync fence = static_cast<GLsync>(regionFences[region]);
+    if (!fence) {
+        return;
+    }
+    
+    // Usually already signaled: the region was last drawn INSTANCE_REGIONS refreshes ago
+    GLenum status = glClientWaitSync(fence, 0, 0);
+    while (status == GL_TIMEOUT_EXPIRED) {
+        status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000); // 1 ms
+    }
+    if (status == GL_WAIT_FAILED) {
+        std::cerr << "Waiting on instance buffer fence failed" << std::endl;
+    }
+    
+    glDeleteSync(fence);
+    regionFences[region] = nullptr;
+}
+
+void Render::bindInstanceAttributes(size_t firstInstance)
+{
+    // GL 3.3 has no base-instance draw, so each batch offsets the attribute pointers instead.
+    // Expects the target VAO and the instance buffer to be bound; the model matrix leads the struct.
+    size_t base = firstInstance * sizeof(InstanceData);
+    GLsizei stride = sizeof(InstanceData);
+    
+    for (unsigned int column = 0; column < 4; column++) {
+        glVertexAttribPointer(1 + column, 4, GL_FLOAT, GL_FALSE, stride,
+                              (void*)(base + column * sizeof(glm::vec4)));
+    }
+    glVertexAttribPointer(5, 3, GL_FLOAT, GL_FALSE, stride, (void*)(base + sizeof(glm::mat4)));
+}
+
+void Render::rebuildDrawBatches()
 {
-    if (model.VAO != 0) {
-        glDeleteVertexArrays(1, &model.VAO);
-        model.VAO = 0;
+    // Bucket models by the mesh they draw
+    std::vector<std::vector<size_t>> modelsByMesh(meshBuffers.size());
+    for (size_t i = 0; i < renderModels.size(); i++) {
+        modelsByMesh[modelMeshBuffers[i]].push_back(i);
+    }
+    
+    drawBatches.clear();
+    instanceModels.clear();
+    for (size_t m = 0; m < modelsByMesh.size(); m++) {
+        if (modelsByMesh[m].empty()) continue;
+        
+        DrawBatch batch;
+        batch.meshBuffers = m;
+        batch.firstInstance = instanceModels.size();
+        batch.instanceCount = static_cast<int>(modelsByMesh[m].size());
+        drawBatches.push_back(batch);
+        
+        instanceModels.insert(instanceModels.end(), modelsByMesh[m].begin(), modelsByMesh[m].end());
     }
-    if (model.VBO != 0) {
-        glDeleteBuffers(1, &model.VBO);
-        model.VBO = 0;
+    instanceData.resize(instanceModels.size());
+    
+    if (instanceModels.size() > instanceCapacity) {
+        allocateInstanceBuffer(instanceModels.size());
     }
-    if (model.EBO != 0) {
-        glDeleteBuffers(1, &model.EBO);
-        model.EBO = 0;
+    instancesDirty = true;
+}
+
+void Render::drawHeatmapInstances(size_t regionBase)
+{
+    // gl_PrimitiveID restarts for every instance, so each model is its own one-instance draw
+    glUniform2f(heatmapRangeLoc, heatmapMin, heatmapMax);
+    glActiveTexture(GL_TEXTURE0 + TRIANGLE_SCALAR_UNIT);
+    
+    for (const DrawBatch& batch : drawBatches) {
+        const MeshBuffers& buffers = meshBuffers[batch.meshBuffers];
+        if (buffers.VAO == 0) continue;
+        
+        glBindVertexArray(buffers.VAO);
+        for (int i = 0; i < batch.instanceCount; i++) {
+            ModelId id = renderModels[instanceModels[batch.firstInstance + i]].id;
+            
+            // Scalars left over from a replaced mesh no longer line up with its triangles
+            bool hasScalars = id < triangleScalars.size() && triangleScalars[id].texture != 0 &&
+                              triangleScalars[id].count * 3 == static_cast<size_t>(buffers.indexCount);
+            glUniform1i(heatmapLoc, hasScalars ? 1 : 0);
+            glBindTexture(GL_TEXTURE_BUFFER, hasScalars ? triangleScalars[id].texture : 0);
+            
+            bindInstanceAttributes(regionBase + batch.firstInstance + i);
+            glDrawElementsInstanced(GL_TRIANGLES, buffers.indexCount, GL_UNSIGNED_INT, 0, 1);
+        }
     }
+    
+    glUniform1i(heatmapLoc, 0);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+}
+
+void Render::cacheUniformLocations()
+{
+    modelLoc = glGetUniformLocation(shaderProgram, "model");
+    colorLoc = glGetUniformLocation(shaderProgram, "color");
+    instancedLoc = glGetUniformLocation(shaderProgram, "useInstancing");
+    heatmapLoc = glGetUniformLocation(shaderProgram, "useHeatmap");
+    heatmapRangeLoc = glGetUniformLocation(shaderProgram, "heatmapRange");
+    triangleScalarsLoc = glGetUniformLocation(shaderProgram, "triangleScalars");
+    
+    // Sampler units are fixed, so they are set once
+    glUseProgram(shaderProgram);
+    glUniform1i(triangleScalarsLoc, TRIANGLE_SCALAR_UNIT);
+    glUniform1i(heatmapLoc, 0);
+    glUseProgram(0);
+}
+
+void Render::setupCameraBlock()
+{
+    glGenBuffers(1, &cameraUBO);
+    glBindBuffer(GL_UNIFORM_BUFFER, cameraUBO);
+    glBufferData(GL_UNIFORM_BUFFER, 2 * sizeof(glm::mat4), nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    glBindBufferBase(GL_UNIFORM_BUFFER, CAMERA_BLOCK_BINDING, cameraUBO);
+    
+    unsigned int blockIndex = glGetUniformBlockIndex(shaderProgram, "Camera");
+    if (blockIndex == GL_INVALID_INDEX) {
+        std::cerr << "Shader program has no Camera uniform block" << std::endl;
+        return;
+    }
+    glUniformBlockBinding(shaderProgram, blockIndex, CAMERA_BLOCK_BINDING);
+    cameraUploaded = false;
+}
+
+void Render::updateCameraBlock(const glm::mat4& view, const glm::mat4& projection)
+{
+    if (cameraUploaded && view == uploadedView && projection == uploadedProjection) {
+        return;
+    }
+    
+    // std140: two column-major mat4s, view then projection
+    glBindBuffer(GL_UNIFORM_BUFFER, cameraUBO);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(glm::mat4), &view[0][0]);
+    glBufferSubData(GL_UNIFORM_BUFFER, sizeof(glm::mat4), sizeof(glm::mat4), &projection[0][0]);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    
+    uploadedView = view;
+    uploadedProjection = projection;
+    cameraUploaded = true;
 }
 
 std::string Render::loadShaderFromFile(const std::string& filePath)
@@ -273,14 +712,26 @@ std::string Render::getDefaultVertexShader()
 {
     return R"(#version 330 core
 layout (location = 0) in vec3 aPos;
+layout (location = 1) in mat4 aInstanceModel;  // Occupies locations 1-4
+layout (location = 5) in vec3 aInstanceColor;
+
+layout (std140) uniform Camera
+{
+    mat4 view;
+    mat4 projection;
+};
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+uniform vec3 color;
+uniform bool useInstancing;  // Per-instance attributes instead of the model/color uniforms
+
+out vec3 vertexColor;
 
 void main()
 {
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
+    mat4 modelMatrix = useInstancing ? aInstanceModel : model;
+    vertexColor = useInstancing ? aInstanceColor : color;
+    gl_Position = projection * view * modelMatrix * vec4(aPos, 1.0);
 }
 )";
 }
@@ -288,13 +739,67 @@ void main()
 std::string Render::getDefaultFragmentShader()
 {
     return R"(#version 330 core
+in vec3 vertexColor;
 out vec4 FragColor;
 
-uniform vec3 color;
+uniform bool useHeatmap;              // Colour by the per-triangle scalars instead
+uniform samplerBuffer triangleScalars;
+uniform vec2 heatmapRange;            // Value mapped to the cold end, value mapped to the hot end
+
+vec3 heatmapColor(float t)
+{
+    // Blue - cyan - green - yellow - red
+    return clamp(vec3(1.5 - abs(4.0 * t - 3.0), 1.5 - abs(4.0 * t - 2.0), 1.5 - abs(4.0 * t - 1.0)), 0.0, 1.0);
+}
+
+void main()
+{
+    if (useHeatmap) {
+        float value = texelFetch(triangleScalars, gl_PrimitiveID).r;
+        if (value < 0.0) {
+            FragColor = vec4(0.3, 0.3, 0.3, 1.0);  // No data (ray missed)
+            return;
+        }
+        float t = clamp((value - heatmapRange.x) / (heatmapRange.y - heatmapRange.x), 0.0, 1.0);
+        FragColor = vec4(heatmapColor(t), 1.0);
+        return;
+    }
+    FragColor = vec4(vertexColor, 1.0);
+}
+)";
+}
+
+std::string Render::getRayVertexShader()
+{
+    return R"(#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aColor;
+
+layout (std140) uniform Camera
+{
+    mat4 view;
+    mat4 projection;
+};
+
+out vec3 vertexColor;
+
+void main()
+{
+    vertexColor = aColor;
+    gl_Position = projection * view * vec4(aPos, 1.0);
+}
+)";
+}
+
+std::string Render::getRayFragmentShader()
+{
+    return R"(#version 330 core
+in vec3 vertexColor;
+out vec4 FragColor;
 
 void main()
 {
-    FragColor = vec4(color, 1.0);
+    FragColor = vec4(vertexColor, 1.0);
 }
 )";
 }
@@ -326,21 +831,15 @@ void Render::setupCoordinateAxes()
     axesInitialized = true;
 }
 
-void Render::renderCoordinateAxes(const glm::mat4& view, const glm::mat4& projection)
+void Render::renderCoordinateAxes(bool wireframe)
 {
     if (!axesInitialized) return;
     
-    // Get uniform locations
-    int modelLoc = glGetUniformLocation(shaderProgram, "model");
-    int colorLoc = glGetUniformLocation(shaderProgram, "color");
-    
     // Set model matrix to identity (axes at origin)
     glm::mat4 modelMatrix = glm::mat4(1.0f);
     glUniformMatrix4fv(modelLoc, 1, GL_FALSE, &modelMatrix[0][0]);
     
     // Temporarily set line mode and increase line width
-    GLenum currentPolygonMode[2];
-    glGetIntegerv(GL_POLYGON_MODE, (GLint*)currentPolygonMode);
     glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
     glLineWidth(3.0f);
     
@@ -360,9 +859,170 @@ void Render::renderCoordinateAxes(const glm::mat4& view, const glm::mat4& projec
     
     glBindVertexArray(0);
     
-    // Restore previous polygon mode and line width
-    glPolygonMode(GL_FRONT_AND_BACK, currentPolygonMode[0]);
-    glLineWidth(1.0f);
+    // Restore the caller's polygon mode and line width (known, so no state query is needed)
+    glPolygonMode(GL_FRONT_AND_BACK, wireframe ? GL_LINE : GL_FILL);
+    glLineWidth(wireframe ? 2.0f : 1.0f);
+}
+
+bool Render::setupRayLines()
+{
+    rayShaderProgram = createShaderProgram(getRayVertexShader(), getRayFragmentShader());
+    if (rayShaderProgram == 0) {
+        return false;
+    }
+    
+    unsigned int blockIndex = glGetUniformBlockIndex(rayShaderProgram, "Camera");
+    if (blockIndex != GL_INVALID_INDEX) {
+        glUniformBlockBinding(rayShaderProgram, blockIndex, CAMERA_BLOCK_BINDING);
+    }
+    
+    glGenVertexArrays(1, &rayVAO);
+    return true;
+}
+
+void Render::allocateRayBuffer(size_t rays)
+{
+    releaseRayBuffer();
+    rayCapacity = rays;
+    
+    glGenBuffers(1, &rayVBO);
+    glBindVertexArray(rayVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, rayVBO);
+    
+    // Two vertices per ray, each position then colour
+    GLsizeiptr bytes = static_cast<GLsizeiptr>(rays * 2 * 6 * sizeof(float));
+    BufferStorageProc bufferStorage = nullptr;
+    if (persistentMappingSupported) {
+        bufferStorage = reinterpret_cast<BufferStorageProc>(procLoader("glBufferStorage"));
+    }
+    if (bufferStorage) {
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        bufferStorage(GL_ARRAY_BUFFER, bytes, nullptr, flags);
+        rayMapping = glMapBufferRange(GL_ARRAY_BUFFER, 0, bytes, flags);
+    }
+    if (!rayMapping) {
+        if (bufferStorage) {
+            // Immutable storage cannot be respecified
+            glDeleteBuffers(1, &rayVBO);
+            glGenBuffers(1, &rayVBO);
+            glBindBuffer(GL_ARRAY_BUFFER, rayVBO);
+        }
+        glBufferData(GL_ARRAY_BUFFER, bytes, nullptr, GL_DYNAMIC_DRAW);
+    }
+    
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
+    glEnableVertexAttribArray(1);
+    
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void Render::releaseRayBuffer()
+{
+    if (rayFence) {
+        glDeleteSync(static_cast<GLsync>(rayFence));
+        rayFence = nullptr;
+    }
+    if (rayMapping) {
+        glBindBuffer(GL_ARRAY_BUFFER, rayVBO);
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        rayMapping = nullptr;
+    }
+    if (rayVBO != 0) {
+        glDeleteBuffers(1, &rayVBO);
+        rayVBO = 0;
+    }
+    rayCapacity = 0;
+    rayVertexCount = 0;
+}
+
+void Render::setFrameTimer(FrameTimer* timer)
+{
+    frameTimer = timer;
+}
+
+void Render::setRayLines(const std::vector<CapturedRay>& rays)
+{
+    rayVertexCount = 0;
+    if (rays.empty() || rayShaderProgram == 0) {
+        return;
+    }
+    
+    // Sized once for the capture budget
+    if (rays.size() > rayCapacity) {
+        allocateRayBuffer(rays.size());
+    }
+    
+    std::vector<float> staged;
+    float* target = static_cast<float*>(rayMapping);
+    if (rayMapping) {
+        // The previous draw may still read the buffer
+        if (rayFence) {
+            GLsync fence = static_cast<GLsync>(rayFence);
+            while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED) {
+            }
+            glDeleteSync(fence);
+            rayFence = nullptr;
+        }
+    } else {
+        staged.resize(rays.size() * 12);
+        target = staged.data();
+    }
+    
+    for (const CapturedRay& ray : rays) {
+        glm::vec3 color = ray.hit ? glm::vec3(1.0f, 0.9f, 0.2f) : glm::vec3(0.8f, 0.2f, 0.2f);
+        const float vertices[12] = {
+            ray.origin.x, ray.origin.y, ray.origin.z, color.r, color.g, color.b,
+            ray.end.x, ray.end.y, ray.end.z, color.r, color.g, color.b
+        };
+        std::memcpy(target, vertices, sizeof(vertices));
+        target += 12;
+    }
+    
+    if (!rayMapping) {
+        glBindBuffer(GL_ARRAY_BUFFER, rayVBO);
+        glBufferData(GL_ARRAY_BUFFER, rayCapacity * 12 * sizeof(float), nullptr, GL_DYNAMIC_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, staged.size() * sizeof(float), staged.data());
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+    rayVertexCount = static_cast<int>(rays.size() * 2);
+}
+
+void Render::renderRayLines()
+{
+    if (rayVertexCount == 0) {
+        return;
+    }
+    
+    // Rays are already in world space (the calculator traces transformed geometry)
+    glUseProgram(rayShaderProgram);
+    glBindVertexArray(rayVAO);
+    glDrawArrays(GL_LINES, 0, rayVertexCount);
+    glBindVertexArray(0);
+    glUseProgram(shaderProgram);
+    
+    if (rayMapping) {
+        if (rayFence) {
+            glDeleteSync(static_cast<GLsync>(rayFence));
+        }
+        rayFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+}
+
+void Render::cleanupRayLines()
+{
+    releaseRayBuffer();
+    if (rayVAO != 0) {
+        glDeleteVertexArrays(1, &rayVAO);
+        rayVAO = 0;
+    }
+    if (rayShaderProgram != 0) {
+        glDeleteProgram(rayShaderProgram);
+        rayShaderProgram = 0;
+    }
 }
 
 void Render::cleanupCoordinateAxes()
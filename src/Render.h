@@ -3,10 +3,45 @@
 
 #include <vector>
 #include <string>
+#include <unordered_map>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include "ModelManager.h"
 #include "Transform.h"
+#include "RayCapture.h"
+#include "FrameTimer.h"
+
+// GPU buffers for one mesh asset, shared by every model that references it
+struct MeshBuffers {
+    unsigned int VAO = 0;
+    unsigned int VBO = 0;
+    unsigned int EBO = 0;
+    int indexCount = 0;
+};
+
+// Per-instance vertex attributes streamed each frame (locations 1-4: model matrix, 5: colour)
+struct InstanceData {
+    glm::mat4 model;
+    glm::vec3 color;
+    float padding = 0.0f;
+};
+
+// Per-triangle scalars of one model, sampled by the fragment shader through a buffer texture
+struct TriangleScalarBuffer {
+    unsigned int buffer = 0;
+    unsigned int texture = 0;
+    size_t count = 0;
+};
+
+// One instanced draw: a contiguous range of the instance buffer sharing a mesh
+struct DrawBatch {
+    size_t meshBuffers = 0;
+    size_t firstInstance = 0;
+    int instanceCount = 0;
+};
+
+// OpenGL function loader (e.g. glfwGetProcAddress) used for entry points beyond GL 3.3
+using GLProcLoader = void* (*)(const char* name);
 
 // OpenGL renderer class
 class Render
@@ -18,6 +53,27 @@ public:
     // Initialize renderer with models
     bool initialize(const std::vector<Model>& models);
 
+    // Split initialization: shaders and axes first (no models needed), then mesh upload.
+    // With a loader, instance data goes through a persistently mapped buffer when supported.
+    bool initialize(GLProcLoader procLoader = nullptr);
+    void uploadModels(const std::vector<Model>& models);
+
+    // Re-upload the meshes of models whose mesh was replaced (e.g. after a live reload)
+    void updateModelMeshes(const std::vector<Model>& models, const std::vector<ModelId>& changedModels);
+
+    // Heatmap: models with per-triangle scalars (one value per mesh triangle, negative for no
+    // data) are coloured from the scalar range instead of their model colour. A reversed range
+    // (rangeMin > rangeMax) puts the hot end at low values.
+    void setTriangleScalars(ModelId id, const std::vector<float>& values);
+    void clearTriangleScalars();
+    void setHeatmap(bool enabled, float rangeMin = 0.0f, float rangeMax = 1.0f);
+
+    // Debug ray lines (hit rays in yellow, misses in red), drawn with the scene; empty hides them
+    void setRayLines(const std::vector<CapturedRay>& rays);
+
+    // Stage timing (transform rebuild, submission, GPU passes); null disables it
+    void setFrameTimer(FrameTimer* timer);
+
     // Render all models with group transformations
     void render(const glm::mat4& view, const glm::mat4& projection, 
                 TransformManager& transformManager, bool wireframe = false);
@@ -29,8 +85,66 @@ private:
     // Shader program ID
     unsigned int shaderProgram;
     
+    // Uniform locations, resolved once after linking
+    int modelLoc;
+    int colorLoc;
+    int instancedLoc;
+    int heatmapLoc;
+    int heatmapRangeLoc;
+    int triangleScalarsLoc;
+    
+    // View/projection uniform block, re-uploaded only when the camera moves
+    static constexpr unsigned int CAMERA_BLOCK_BINDING = 0;
+    unsigned int cameraUBO;
+    glm::mat4 uploadedView;
+    glm::mat4 uploadedProjection;
+    bool cameraUploaded;
+    
     // Model data for rendering
     std::vector<Model> renderModels;
+    std::vector<size_t> modelMeshBuffers;     // renderModels index -> meshBuffers index
+    
+    // One set of GPU buffers per unique mesh
+    std::vector<MeshBuffers> meshBuffers;
+    std::unordered_map<const MeshAsset*, size_t> meshBufferLookup;
+    
+    // Instancing: models grouped by mesh, with their per-frame data in one streamed buffer
+    std::vector<DrawBatch> drawBatches;
+    std::vector<size_t> instanceModels;       // renderModels indices in instance order
+    std::vector<InstanceData> instanceData;
+    unsigned int instanceVBO;
+    size_t instanceCapacity;                  // Instances per buffer region
+    
+    // Persistent mapping: the buffer is split into regions that are cycled on each refresh,
+    // each guarded by a fence. Without it, the buffer is a single orphaned region.
+    static constexpr size_t INSTANCE_REGIONS = 3;
+    GLProcLoader procLoader;
+    bool persistentMappingSupported;
+    void* instanceMapping;
+    size_t instanceRegion;
+    void* regionFences[INSTANCE_REGIONS];     // GLsync per region
+    
+    // Instance data is rewritten only when one of these changes
+    uint64_t instanceVersion;
+    bool instanceWireframe;
+    bool instancesDirty;
+
+    // Heatmap scalars, indexed by ModelId
+    static constexpr int TRIANGLE_SCALAR_UNIT = 0;
+    std::vector<TriangleScalarBuffer> triangleScalars;
+    bool heatmapEnabled;
+    float heatmapMin, heatmapMax;
+
+    // Debug ray lines: position + colour per vertex, one GL_LINES draw. The buffer is mapped
+    // persistently when supported; updates wait on the fence of the last draw that read it.
+    unsigned int rayShaderProgram;
+    unsigned int rayVAO, rayVBO;
+    size_t rayCapacity;                       // Rays the buffer holds
+    int rayVertexCount;
+    void* rayMapping;
+    void* rayFence;                           // GLsync of the last ray draw
+
+    FrameTimer* frameTimer;
 
     // Coordinate axes
     unsigned int axesVAO, axesVBO;
@@ -42,12 +156,35 @@ private:
     unsigned int createShaderProgram(const std::string& vertexSource, const std::string& fragmentSource);
     
     // Buffer management
-    void setupModelBuffers(Model& model);
-    void cleanupModelBuffers(Model& model);
+    size_t getMeshBuffers(const MeshAsset& mesh);
+    void setupMeshBuffers(const MeshAsset& mesh, MeshBuffers& buffers);
+    void cleanupMeshBuffers(MeshBuffers& buffers);
+    
+    // Instance buffer management
+    bool supportsBufferStorage() const;
+    void allocateInstanceBuffer(size_t capacity);
+    void releaseInstanceBuffer();
+    void uploadInstanceData(TransformManager& transformManager, bool wireframe);
+    void waitForRegion(size_t region);
+    void bindInstanceAttributes(size_t firstInstance);
+    void rebuildDrawBatches();
+    void drawHeatmapInstances(size_t regionBase);
+    
+    // Uniform state
+    void cacheUniformLocations();
+    void setupCameraBlock();
+    void updateCameraBlock(const glm::mat4& view, const glm::mat4& projection);
+    
+    // Debug ray lines
+    bool setupRayLines();
+    void allocateRayBuffer(size_t rays);
+    void releaseRayBuffer();
+    void renderRayLines();
+    void cleanupRayLines();
     
     // Coordinate axes
     void setupCoordinateAxes();
-    void renderCoordinateAxes(const glm::mat4& view, const glm::mat4& projection);
+    void renderCoordinateAxes(bool wireframe);
     void cleanupCoordinateAxes();
     
     // Color utility
@@ -65,6 +202,8 @@ private:
     // Default shader sources (fallback if files not found)
     std::string getDefaultVertexShader();
     std::string getDefaultFragmentShader();
+    std::string getRayVertexShader();
+    std::string getRayFragmentShader();
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,200 @@
+#include "RowPrefetcher.h"
+#include "BulkCapacitanceProcessor.h"
+#include "CapacitanceCalculator.h"
+#include "Transform.h"
+#include "Tracer.h"
+#include <algorithm>
+#include <iostream>
+#include <iterator>
+
+RowPrefetcher::RowPrefetcher() : stopRequested(false), abortRow(false), failed(false), centerRow(0), hasRequest(false),
+                                 rowInProgress(0), computing(false), runFile(nullptr)
+{
+}
+
+RowPrefetcher::~RowPrefetcher()
+{
+    stop();
+}
+
+bool RowPrefetcher::start(const std::vector<Model>& runModels, const RunFile* file, std::function<void()> resultCallback)
+{
+    if (worker.joinable()) {
+        if (!failed) {
+            return true;
+        }
+        worker.join();  // The failed worker has already exited
+    }
+    if (!file || !file->isOpen()) {
+        return false;
+    }
+    
+    models = runModels;
+    runFile = file;
+    onResult = resultCallback;
+    stopRequested = false;
+    abortRow = false;
+    failed = false;
+    hasRequest = false;
+    computing = false;
+    cache.clear();
+    
+    worker = std::thread(&RowPrefetcher::run, this);
+    return true;
+}
+
+void RowPrefetcher::stop()
+{
+    if (!worker.joinable()) {
+        return;
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopRequested = true;
+    }
+    abortRow = true;
+    wake.notify_one();
+    worker.join();
+    runFile = nullptr;
+}
+
+bool RowPrefetcher::isRunning() const
+{
+    return worker.joinable() && !failed;
+}
+
+void RowPrefetcher::request(size_t row)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        centerRow = row;
+        hasRequest = true;
+        
+        // A row outside the new window is not worth finishing
+        size_t distance = rowInProgress > row ? rowInProgress - row : row - rowInProgress;
+        if (computing && distance > PREFETCH_RADIUS) {
+            abortRow = true;
+        }
+        
+        // Keep the cache bounded, dropping the rows farthest from where the user is
+        if (cache.size() > MAX_CACHED_ROWS) {
+            for (auto it = cache.begin(); it != cache.end();) {
+                size_t cachedDistance = it->first > row ? it->first - row : row - it->first;
+                it = cachedDistance > MAX_CACHED_ROWS / 2 ? cache.erase(it) : std::next(it);
+            }
+        }
+    }
+    wake.notify_one();
+}
+
+bool RowPrefetcher::getCapacitances(size_t row, double* capacitances) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = cache.find(row);
+    if (it == cache.end()) {
+        return false;
+    }
+    
+    std::copy(it->second.begin(), it->second.end(), capacitances);
+    return true;
+}
+
+bool RowPrefetcher::takeNextRow(size_t& row)
+{
+    // Called with mutex held: nearest uncomputed row first, alternating after and before the center
+    size_t rowCount = runFile->getRowCount();
+    for (size_t distance = 0; distance <= PREFETCH_RADIUS; distance++) {
+        for (int side = 0; side < 2; side++) {
+            if (side == 1 && (distance == 0 || distance > centerRow)) {
+                continue;
+            }
+            size_t candidate = side == 0 ? centerRow + distance : centerRow - distance;
+            if (candidate >= rowCount || cache.count(candidate)) {
+                continue;
+            }
+            if (runFile->getRecord(candidate).flags & RUN_ROW_COMPUTED) {
+                continue;
+            }
+            
+            row = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+void RowPrefetcher::run()
+{
+    Tracer::setThreadName("row prefetcher");
+    TransformManager transforms;
+    for (const Model& model : models) {
+        transforms.registerModel(model.id, model.name);
+    }
+    
+    CapacitanceCalculator calculator;
+    if (!calculator.initialize(models, transforms)) {
+        std::cerr << "Row prefetch: calculator failed to initialize" << std::endl;
+        reportFailure();
+        return;
+    }
+    
+    std::vector<CapacitanceResult> results;
+    
+    while (true) {
+        size_t row = 0;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            computing = false;
+            wake.wait(lock, [this, &row]() {
+                return stopRequested || (hasRequest && takeNextRow(row));
+            });
+            if (stopRequested) {
+                break;
+            }
+            
+            rowInProgress = row;
+            computing = true;
+            abortRow = false;
+        }
+        
+        RunRecord record = runFile->getRecord(row);
+        BulkCapacitanceProcessor::applyRunRecord(record, transforms);
+        calculator.refreshGeometry();
+        if (!calculator.calculateCapacitances(results, 0, &abortRow)) {
+            if (abortRow) {
+                continue;  // The center moved away; the row is taken again if it is still wanted
+            }
+            // A real failure (e.g. a scene that does not fit the memory budget) would repeat
+            // for every row, so the worker reports it and exits
+            std::cerr << "Row prefetch: calculation failed at row " << row << std::endl;
+            reportFailure();
+            return;
+        }
+        
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            std::array<double, RUN_CAPACITANCE_COLUMNS>& capacitances = cache[row];
+            capacitances.fill(0.0);
+            for (size_t i = 0; i < RUN_CAPACITANCE_COLUMNS && i < results.size(); i++) {
+                capacitances[i] = results[i].capacitance;
+            }
+        }
+        
+        if (onResult) {
+            onResult();
+        }
+    }
+}
+
+void RowPrefetcher::reportFailure()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        computing = false;
+    }
+    failed = true;
+    if (onResult) {
+        onResult();
+    }
+}
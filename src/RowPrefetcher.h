@@ -0,0 +1,65 @@
+#ifndef ROWPREFETCHER_H
+#define ROWPREFETCHER_H
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "ModelManager.h"
+#include "RunFile.h"
+
+// Computes the capacitances of run file rows that the bulk run did not reach, around the
+// row step mode is showing. Rows are taken nearest first; a new center abandons the rows
+// still queued for the old one. The worker owns its own transform manager and calculator
+// and only reads the run file, which must stay open until stop().
+class RowPrefetcher
+{
+public:
+    RowPrefetcher();
+    ~RowPrefetcher();
+
+    // Start the worker; onResult is called from the worker after every computed row and when
+    // its calculator fails (to initialize or to compute a row), after which the worker exits.
+    // isRunning is false once the worker has failed.
+    bool start(const std::vector<Model>& models, const RunFile* runFile, std::function<void()> onResult);
+    void stop();
+    bool isRunning() const;
+
+    // Prefetch the uncomputed rows within PREFETCH_RADIUS of centerRow
+    void request(size_t centerRow);
+
+    // Copy out a prefetched row's capacitances (RUN_CAPACITANCE_COLUMNS values)
+    bool getCapacitances(size_t row, double* capacitances) const;
+
+private:
+    void run();
+    bool takeNextRow(size_t& row);
+    void reportFailure();
+
+    static constexpr size_t PREFETCH_RADIUS = 16;
+    static constexpr size_t MAX_CACHED_ROWS = 4096;   // Rows far from the center are dropped beyond this
+
+    std::thread worker;
+    mutable std::mutex mutex;
+    std::condition_variable wake;
+    bool stopRequested;
+    std::atomic<bool> abortRow;    // Set when the center moves away from the row in progress
+    std::atomic<bool> failed;      // Set before the worker exits on an initialization failure
+
+    // Guarded by mutex
+    size_t centerRow;
+    bool hasRequest;
+    size_t rowInProgress;
+    bool computing;
+    std::unordered_map<size_t, std::array<double, RUN_CAPACITANCE_COLUMNS>> cache;
+
+    std::vector<Model> models;
+    const RunFile* runFile;
+    std::function<void()> onResult;
+};
+
+#endif
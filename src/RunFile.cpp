@@ -0,0 +1,146 @@
+#include "RunFile.h"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+namespace {
+
+// On-disk layout: header, then rowCount fixed-size records
+struct RunFileHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t rowCount;
+    uint64_t computedRowCount;
+    uint32_t recordSize;
+    uint32_t capacitanceColumns;
+};
+
+constexpr char RUN_MAGIC[4] = {'F', 'T', 'R', 'N'};
+
+} // namespace
+
+RunFile::RunFile() : records(nullptr), rowCount(0), computedRowCount(0)
+{
+}
+
+bool RunFile::save(const std::string& filePath, const std::vector<RunRecord>& runRecords)
+{
+    RunFileHeader header;
+    std::memcpy(header.magic, RUN_MAGIC, sizeof(RUN_MAGIC));
+    header.version = RUN_FILE_VERSION;
+    header.rowCount = runRecords.size();
+    header.computedRowCount = 0;
+    header.recordSize = sizeof(RunRecord);
+    header.capacitanceColumns = RUN_CAPACITANCE_COLUMNS;
+    for (const RunRecord& record : runRecords) {
+        if (record.flags & RUN_ROW_COMPUTED) {
+            header.computedRowCount++;
+        }
+    }
+    
+    std::string tempPath = filePath + ".tmp";
+    std::error_code error;
+    
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            std::cerr << "Could not write run file: " << tempPath << std::endl;
+            return false;
+        }
+        
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(runRecords.data()), runRecords.size() * sizeof(RunRecord));
+        
+        if (!file.good()) {
+            std::cerr << "Failed writing run file: " << tempPath << std::endl;
+            file.close();
+            std::filesystem::remove(tempPath, error);
+            return false;
+        }
+    }
+    
+    std::filesystem::rename(tempPath, filePath, error);
+    if (error) {
+        std::cerr << "Could not replace run file " << filePath << ": " << error.message() << std::endl;
+        std::filesystem::remove(tempPath, error);
+        return false;
+    }
+    
+    return true;
+}
+
+std::string RunFile::getRunPath(const std::string& csvDirectory)
+{
+    return csvDirectory + "/capacitance_run.ftrun";
+}
+
+std::string RunFile::getPartialRunPath(const std::string& csvDirectory)
+{
+    return csvDirectory + "/capacitance_run_partial.ftrun";
+}
+
+bool RunFile::open(const std::string& filePath)
+{
+    close();
+    
+    if (!file.open(filePath)) {
+        return false;
+    }
+    
+    RunFileHeader header;
+    if (file.size() < sizeof(header)) {
+        std::cerr << "Run file too small: " << filePath << std::endl;
+        close();
+        return false;
+    }
+    std::memcpy(&header, file.data(), sizeof(header));
+    
+    if (std::memcmp(header.magic, RUN_MAGIC, sizeof(RUN_MAGIC)) != 0 || header.version != RUN_FILE_VERSION ||
+        header.recordSize != sizeof(RunRecord) || header.capacitanceColumns != RUN_CAPACITANCE_COLUMNS) {
+        std::cerr << "Unsupported run file (rerun bulk processing to regenerate): " << filePath << std::endl;
+        close();
+        return false;
+    }
+    
+    if ((file.size() - sizeof(header)) / sizeof(RunRecord) < header.rowCount) {
+        std::cerr << "Run file is truncated: " << filePath << std::endl;
+        close();
+        return false;
+    }
+    
+    records = file.data() + sizeof(header);
+    rowCount = static_cast<size_t>(header.rowCount);
+    computedRowCount = static_cast<size_t>(header.computedRowCount);
+    return true;
+}
+
+void RunFile::close()
+{
+    file.close();
+    records = nullptr;
+    rowCount = 0;
+    computedRowCount = 0;
+}
+
+bool RunFile::isOpen() const
+{
+    return records != nullptr;
+}
+
+size_t RunFile::getRowCount() const
+{
+    return rowCount;
+}
+
+size_t RunFile::getComputedRowCount() const
+{
+    return computedRowCount;
+}
+
+RunRecord RunFile::getRecord(size_t row) const
+{
+    RunRecord record;
+    std::memcpy(&record, records + row * sizeof(RunRecord), sizeof(RunRecord));
+    return record;
+}
@@ -0,0 +1,65 @@
+#ifndef RUNFILE_H
+#define RUNFILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "MappedFile.h"
+
+// Capacitance columns per row (A1, A2, B1, B2, C1, C2)
+constexpr size_t RUN_CAPACITANCE_COLUMNS = 6;
+
+// Flags of a run record
+constexpr uint32_t RUN_ROW_HAS_TAG = 1;     // transforms[0] applies
+constexpr uint32_t RUN_ROW_HAS_TBG = 2;     // transforms[1] applies
+constexpr uint32_t RUN_ROW_HAS_TCG = 4;     // transforms[2] applies
+constexpr uint32_t RUN_ROW_COMPUTED = 8;    // capacitances are valid
+
+// One row of a bulk run: the calculated group transforms (the pose) and its results.
+// Records have a fixed size, so any row is found in O(1) from the mapping.
+struct RunRecord {
+    float transforms[3][16];                          // TAG, TBG, TCG; column-major mat4
+    double capacitances[RUN_CAPACITANCE_COLUMNS];     // Farads
+    uint32_t flags;
+    uint32_t reserved;
+};
+
+// Binary pose trajectory and results written by a bulk run (<csv dir>/capacitance_run.ftrun),
+// read back through a memory mapping for step mode and plotting
+class RunFile
+{
+public:
+    RunFile();
+
+    // Write all records (temporary file + rename)
+    static bool save(const std::string& filePath, const std::vector<RunRecord>& records);
+
+    // Default location for a CSV directory
+    static std::string getRunPath(const std::string& csvDirectory);
+
+    // Where a cancelled or stopped bulk run writes its rows, so a complete run is not replaced
+    static std::string getPartialRunPath(const std::string& csvDirectory);
+
+    // Map a run file; false if missing, of another version or truncated
+    bool open(const std::string& filePath);
+    void close();
+    bool isOpen() const;
+
+    size_t getRowCount() const;
+    size_t getComputedRowCount() const;
+
+    // Copy out one record (row < getRowCount())
+    RunRecord getRecord(size_t row) const;
+
+private:
+    // Bump whenever the record layout changes
+    static constexpr uint32_t RUN_FILE_VERSION = 1;
+
+    MappedFile file;
+    const char* records;
+    size_t rowCount;
+    size_t computedRowCount;
+};
+
+#endif
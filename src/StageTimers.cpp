@@ -0,0 +1,216 @@
+#include "StageTimers.h"
+#include "PerfCounters.h"
+#include "EmbreeMemory.h"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+namespace {
+    thread_local StageTotals threadTotals;
+    
+    // Index of the highest set bit (value > 0)
+    unsigned highestBit(uint64_t value)
+    {
+        unsigned bit = 0;
+        for (unsigned shift = 32; shift > 0; shift /= 2) {
+            if (value >> shift) {
+                value >>= shift;
+                bit += shift;
+            }
+        }
+        return bit;
+    }
+    
+    // Values below 8 ns get their own bucket; above, each power of two is split in eight
+    size_t getBucket(uint64_t nanoseconds)
+    {
+        if (nanoseconds < 8) {
+            return static_cast<size_t>(nanoseconds);
+        }
+        unsigned octave = highestBit(nanoseconds);
+        return (octave - 2) * 8 + static_cast<size_t>((nanoseconds >> (octave - 3)) - 8);
+    }
+    
+    uint64_t getBucketMidpoint(size_t bucket)
+    {
+        if (bucket < 8) {
+            return bucket;
+        }
+        unsigned octave = static_cast<unsigned>(bucket / 8 + 2);
+        uint64_t width = uint64_t(1) << (octave - 3);
+        uint64_t lower = (8 + bucket % 8) * width;
+        return lower + width / 2;
+    }
+    
+    const char* getStageKey(BulkStage stage)
+    {
+        switch (stage) {
+            case BulkStage::CsvParse:        return "csv_parse";
+            case BulkStage::Pose:            return "pose";
+            case BulkStage::GeometryRefresh: return "geometry_refresh";
+            case BulkStage::RayCast:         return "ray_cast";
+            case BulkStage::Save:            return "save";
+            default:                         return "unknown";
+        }
+    }
+    
+    const char* getCounterKey(BulkCounter counter)
+    {
+        switch (counter) {
+            case BulkCounter::Rows:         return "rows";
+            case BulkCounter::Rays:         return "rays";
+            case BulkCounter::Hits:         return "hits";
+            case BulkCounter::BytesRead:    return "bytes_read";
+            case BulkCounter::BytesWritten: return "bytes_written";
+            default:                        return "unknown";
+        }
+    }
+}
+
+void StageTotals::addTime(BulkStage stage, uint64_t nanoseconds)
+{
+    Stage& entry = stages[static_cast<size_t>(stage)];
+    entry.calls++;
+    entry.totalNanoseconds += nanoseconds;
+    entry.maxNanoseconds = std::max(entry.maxNanoseconds, nanoseconds);
+    entry.histogram[getBucket(nanoseconds)]++;
+}
+
+void StageTotals::merge(const StageTotals& other)
+{
+    for (size_t s = 0; s < STAGES; s++) {
+        stages[s].calls += other.stages[s].calls;
+        stages[s].totalNanoseconds += other.stages[s].totalNanoseconds;
+        stages[s].maxNanoseconds = std::max(stages[s].maxNanoseconds, other.stages[s].maxNanoseconds);
+        for (size_t b = 0; b < BUCKETS; b++) {
+            stages[s].histogram[b] += other.stages[s].histogram[b];
+        }
+    }
+    for (size_t c = 0; c < COUNTERS; c++) {
+        counters[c] += other.counters[c];
+    }
+}
+
+uint64_t StageTotals::getPercentile(BulkStage stage, double fraction) const
+{
+    const Stage& entry = stages[static_cast<size_t>(stage)];
+    if (entry.calls == 0) {
+        return 0;
+    }
+    
+    // Nearest rank; the bucket midpoint stands in for the sample
+    uint64_t rank = static_cast<uint64_t>(fraction * (entry.calls - 1) + 0.5);
+    uint64_t seen = 0;
+    for (size_t b = 0; b < BUCKETS; b++) {
+        seen += entry.histogram[b];
+        if (seen > rank) {
+            return std::min(getBucketMidpoint(b), entry.maxNanoseconds);
+        }
+    }
+    return entry.maxNanoseconds;
+}
+
+bool StageTimers::isEnabled()
+{
+#ifdef FT_SIM_STAGE_TIMERS
+    return true;
+#else
+    return false;
+#endif
+}
+
+void StageTimers::addTime(BulkStage stage, uint64_t nanoseconds)
+{
+    threadTotals.addTime(stage, nanoseconds);
+}
+
+void StageTimers::addCount(BulkCounter counter, uint64_t amount)
+{
+    threadTotals.counters[static_cast<size_t>(counter)] += amount;
+}
+
+void StageTimers::takeThreadTotals(StageTotals& totals)
+{
+    totals = threadTotals;
+    resetThread();
+}
+
+void StageTimers::resetThread()
+{
+    threadTotals = StageTotals();
+}
+
+bool StageTimers::writeJsonReport(const std::string& filePath, const StageTotals& totals,
+                                  double wallSeconds, size_t totalRows, bool cancelled,
+                                  const PerfTotals* hardwareCounters,
+                                  const EmbreeMemoryStats* embreeMemory)
+{
+    std::ofstream file(filePath);
+    if (!file.is_open()) {
+        std::cerr << "Cannot create report file: " << filePath << std::endl;
+        return false;
+    }
+    
+    auto counter = [&](BulkCounter c) { return totals.counters[static_cast<size_t>(c)]; };
+    auto milliseconds = [](uint64_t nanoseconds) { return nanoseconds / 1.0e6; };
+    
+    double rayCastSeconds = totals.stages[static_cast<size_t>(BulkStage::RayCast)].totalNanoseconds / 1.0e9;
+    double rows = static_cast<double>(counter(BulkCounter::Rows));
+    double rays = static_cast<double>(counter(BulkCounter::Rays));
+    
+    file << std::fixed << std::setprecision(6);
+    file << "{\n";
+    file << "  \"cancelled\": " << (cancelled ? "true" : "false") << ",\n";
+    file << "  \"total_rows\": " << totalRows << ",\n";
+    file << "  \"wall_seconds\": " << wallSeconds << ",\n";
+    
+    file << "  \"rates\": {\n";
+    file << "    \"rows_per_second\": " << (wallSeconds > 0.0 ? rows / wallSeconds : 0.0) << ",\n";
+    file << "    \"mrays_per_second\": " << (wallSeconds > 0.0 ? rays / wallSeconds / 1.0e6 : 0.0) << ",\n";
+    file << "    \"ray_cast_mrays_per_second\": " << (rayCastSeconds > 0.0 ? rays / rayCastSeconds / 1.0e6 : 0.0) << "\n";
+    file << "  },\n";
+    
+    file << "  \"counters\": {\n";
+    for (size_t c = 0; c < StageTotals::COUNTERS; c++) {
+        file << "    \"" << getCounterKey(static_cast<BulkCounter>(c)) << "\": " << totals.counters[c]
+             << (c + 1 < StageTotals::COUNTERS ? ",\n" : "\n");
+    }
+    file << "  },\n";
+    
+    file << "  \"stages\": {\n";
+    for (size_t s = 0; s < StageTotals::STAGES; s++) {
+        BulkStage stage = static_cast<BulkStage>(s);
+        const StageTotals::Stage& entry = totals.stages[s];
+        double meanNanoseconds = entry.calls > 0 ? static_cast<double>(entry.totalNanoseconds) / entry.calls : 0.0;
+        
+        file << "    \"" << getStageKey(stage) << "\": {";
+        file << "\"calls\": " << entry.calls;
+        file << ", \"total_seconds\": " << entry.totalNanoseconds / 1.0e9;
+        file << ", \"share\": " << (wallSeconds > 0.0 ? entry.totalNanoseconds / 1.0e9 / wallSeconds : 0.0);
+        file << ", \"mean_ms\": " << meanNanoseconds / 1.0e6;
+        file << ", \"p50_ms\": " << milliseconds(totals.getPercentile(stage, 0.50));
+        file << ", \"p95_ms\": " << milliseconds(totals.getPercentile(stage, 0.95));
+        file << ", \"p99_ms\": " << milliseconds(totals.getPercentile(stage, 0.99));
+        file << ", \"max_ms\": " << milliseconds(entry.maxNanoseconds);
+        file << "}" << (s + 1 < StageTotals::STAGES ? ",\n" : "\n");
+    }
+    file << "  }";
+    
+    if (hardwareCounters) {
+        file << ",\n";
+        hardwareCounters->writeJson(file, "  ");
+    }
+    if (embreeMemory) {
+        file << ",\n";
+        embreeMemory->writeJson(file, "  ");
+    }
+    file << "\n}\n";
+    
+    file.close();
+    if (!file) {
+        std::cerr << "Failed to write report file: " << filePath << std::endl;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,109 @@
+#ifndef STAGETIMERS_H
+#define STAGETIMERS_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+struct PerfTotals;
+struct EmbreeMemoryStats;
+
+// Stages of a bulk run
+enum class BulkStage {
+    CsvParse,           // Loading and parsing the sphere CSVs
+    Pose,               // Building and applying a row's pose
+    GeometryRefresh,    // refreshGeometry (triangle extraction and BVH rebuild)
+    RayCast,            // calculateCapacitances
+    Save,               // Results CSV and run file
+    Count
+};
+
+// Work counters of a bulk run
+enum class BulkCounter {
+    Rows,
+    Rays,
+    Hits,               // Traced triangles with a hit on either side
+    BytesRead,
+    BytesWritten,
+    Count
+};
+
+// Totals of one thread (or several merged). Durations go into a log-scale histogram with
+// eight buckets per power of two, so percentiles are within ~6% and recording never allocates.
+struct StageTotals {
+    static constexpr size_t STAGES = static_cast<size_t>(BulkStage::Count);
+    static constexpr size_t COUNTERS = static_cast<size_t>(BulkCounter::Count);
+    static constexpr size_t BUCKETS = 496;
+
+    struct Stage {
+        uint64_t calls = 0;
+        uint64_t totalNanoseconds = 0;
+        uint64_t maxNanoseconds = 0;
+        uint32_t histogram[BUCKETS] = {};
+    };
+
+    Stage stages[STAGES];
+    uint64_t counters[COUNTERS] = {};
+
+    void addTime(BulkStage stage, uint64_t nanoseconds);
+    void merge(const StageTotals& other);
+
+    // Estimated duration at a fraction (0..1) of a stage's calls, in ns
+    uint64_t getPercentile(BulkStage stage, double fraction) const;
+};
+
+// Scoped stage timers and counters for bulk runs. Each thread accumulates into its own
+// thread-local totals, so timing costs two clock reads per scope and no synchronization;
+// the owner of a run takes its thread's totals at the end. Compiled out unless
+// FT_SIM_STAGE_TIMERS is defined (the macros below then expand to nothing).
+class StageTimers
+{
+public:
+    static bool isEnabled();
+
+    static void addTime(BulkStage stage, uint64_t nanoseconds);
+    static void addCount(BulkCounter counter, uint64_t amount);
+
+    // Return and clear the calling thread's totals
+    static void takeThreadTotals(StageTotals& totals);
+    static void resetThread();
+
+    // Times, rates (rows/s, Mrays/s) and percentiles as JSON, plus hardware counters and
+    // Embree memory if given
+    static bool writeJsonReport(const std::string& filePath, const StageTotals& totals,
+                                double wallSeconds, size_t totalRows, bool cancelled,
+                                const PerfTotals* hardwareCounters = nullptr,
+                                const EmbreeMemoryStats* embreeMemory = nullptr);
+};
+
+class ScopedStageTimer
+{
+public:
+    explicit ScopedStageTimer(BulkStage stage) : stage(stage), start(std::chrono::steady_clock::now()) {}
+    ~ScopedStageTimer()
+    {
+        auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+        StageTimers::addTime(stage, static_cast<uint64_t>(elapsed.count()));
+    }
+
+    ScopedStageTimer(const ScopedStageTimer&) = delete;
+    ScopedStageTimer& operator=(const ScopedStageTimer&) = delete;
+
+private:
+    BulkStage stage;
+    std::chrono::steady_clock::time_point start;
+};
+
+#define FT_STAGE_CONCAT_INNER(a, b) a##b
+#define FT_STAGE_CONCAT(a, b) FT_STAGE_CONCAT_INNER(a, b)
+
+#ifdef FT_SIM_STAGE_TIMERS
+#define FT_STAGE_TIMER(stage) ScopedStageTimer FT_STAGE_CONCAT(stageTimer, __LINE__)(stage)
+#define FT_STAGE_COUNT(counter, amount) StageTimers::addCount(counter, static_cast<uint64_t>(amount))
+#else
+#define FT_STAGE_TIMER(stage) ((void)0)
+#define FT_STAGE_COUNT(counter, amount) ((void)0)
+#endif
+
+#endif
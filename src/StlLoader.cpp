@@ -0,0 +1,84 @@
+#include "StlLoader.h"
+#include "MappedFile.h"
+#include <cstdint>
+#include <cstring>
+
+// Static member initialization
+thread_local std::string StlLoader::lastError = "";
+
+bool StlLoader::loadSTL(const std::string& filePath,
+                        std::vector<float>& vertices,
+                        std::vector<unsigned int>& indices,
+                        size_t& vertexCount,
+                        size_t& triangleCount)
+{
+    MappedFile file;
+    if (!file.open(filePath)) {
+        vertices.clear();
+        indices.clear();
+        vertexCount = 0;
+        triangleCount = 0;
+        lastError = "Failed to open " + filePath;
+        return false;
+    }
+    
+    return loadSTL(filePath, file.data(), file.size(), vertices, indices, vertexCount, triangleCount);
+}
+
+bool StlLoader::loadSTL(const std::string& filePath, const char* data, size_t size,
+                        std::vector<float>& vertices,
+                        std::vector<unsigned int>& indices,
+                        size_t& vertexCount,
+                        size_t& triangleCount)
+{
+    vertices.clear();
+    indices.clear();
+    vertexCount = 0;
+    triangleCount = 0;
+    lastError = "";
+    
+    if (size < HEADER_BYTES) {
+        lastError = "File too small to be a binary STL: " + filePath;
+        return false;
+    }
+    
+    uint32_t fileTriangles = 0;
+    std::memcpy(&fileTriangles, data + 80, sizeof(fileTriangles));
+    
+    // ASCII STL also starts with "solid", so the size check is what identifies a binary file
+    if (size != HEADER_BYTES + static_cast<size_t>(fileTriangles) * TRIANGLE_BYTES) {
+        lastError = "Not a binary STL (ASCII STL is not supported): " + filePath;
+        return false;
+    }
+    
+    if (fileTriangles == 0) {
+        lastError = "No triangles found in " + filePath;
+        return false;
+    }
+    
+    // Sized once; each record's three corners are copied directly (the facet normal is recomputed later)
+    vertices.resize(static_cast<size_t>(fileTriangles) * 9);
+    indices.resize(static_cast<size_t>(fileTriangles) * 3);
+    
+    const char* record = data + HEADER_BYTES;
+    float* outVertex = vertices.data();
+    for (uint32_t t = 0; t < fileTriangles; t++) {
+        std::memcpy(outVertex, record + 12, 9 * sizeof(float));
+        outVertex += 9;
+        record += TRIANGLE_BYTES;
+        
+        indices[t * 3] = t * 3;
+        indices[t * 3 + 1] = t * 3 + 1;
+        indices[t * 3 + 2] = t * 3 + 2;
+    }
+    
+    vertexCount = vertices.size() / 3;
+    triangleCount = fileTriangles;
+    
+    return true;
+}
+
+std::string StlLoader::getLastError()
+{
+    return lastError;
+}
@@ -0,0 +1,38 @@
+#ifndef STLLOADER_H
+#define STLLOADER_H
+
+#include <vector>
+#include <string>
+
+// Binary STL loader. The file is memory-mapped and written straight into
+// exactly sized output buffers; duplicate corners are welded afterwards by
+// MeshCache::prepareMesh like every other loaded mesh.
+class StlLoader
+{
+public:
+    // Load a binary STL file and return vertex data
+    static bool loadSTL(const std::string& filePath,
+                        std::vector<float>& vertices,
+                        std::vector<unsigned int>& indices,
+                        size_t& vertexCount,
+                        size_t& triangleCount);
+
+    // Same, parsing a file that is already in memory (filePath is used in messages)
+    static bool loadSTL(const std::string& filePath, const char* data, size_t size,
+                        std::vector<float>& vertices,
+                        std::vector<unsigned int>& indices,
+                        size_t& vertexCount,
+                        size_t& triangleCount);
+
+    // Get last error message
+    static std::string getLastError();
+
+private:
+    static thread_local std::string lastError;
+    
+    // Binary layout: 80-byte header, uint32 triangle count, then 50 bytes per triangle
+    static constexpr size_t HEADER_BYTES = 84;
+    static constexpr size_t TRIANGLE_BYTES = 50;
+};
+
+#endif
@@ -0,0 +1,241 @@
+#include "Tracer.h"
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace {
+    struct TraceEvent {
+        const char* category;
+        const char* argName;
+        int64_t arg;
+        double start;       // us
+        double duration;    // us
+        char name[Tracer::MAX_NAME_LENGTH + 1];
+    };
+    
+    constexpr size_t MAX_CHUNKS = Tracer::MAX_EVENTS_PER_THREAD / Tracer::EVENTS_PER_CHUNK;
+    
+    // Written only by its thread; the dump reads the first `count` events. Chunks are allocated
+    // as the thread needs them (most threads record a handful of events) and never move.
+    struct ThreadBuffer {
+        uint32_t threadId = 0;
+        std::string threadName;
+        std::unique_ptr<TraceEvent[]> chunks[MAX_CHUNKS];
+        std::atomic<size_t> count{0};
+        std::atomic<size_t> dropped{0};
+    };
+    
+    std::atomic<bool> tracing{false};
+    std::string tracePath;
+    std::chrono::steady_clock::time_point traceStart;
+    
+    // Buffers outlive their threads (pool threads may be gone by the time the trace is written)
+    std::mutex registryMutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> threadBuffers;
+    thread_local ThreadBuffer* threadBuffer = nullptr;
+    
+    ThreadBuffer* getThreadBuffer()
+    {
+        if (!threadBuffer) {
+            auto buffer = std::make_unique<ThreadBuffer>();
+            
+            std::lock_guard<std::mutex> lock(registryMutex);
+            buffer->threadId = static_cast<uint32_t>(threadBuffers.size() + 1);
+            threadBuffer = buffer.get();
+            threadBuffers.push_back(std::move(buffer));
+        }
+        return threadBuffer;
+    }
+    
+    void writeJsonString(std::ostream& out, const char* text)
+    {
+        out << '"';
+        for (const char* c = text; *c; c++) {
+            if (*c == '"' || *c == '\\') {
+                out << '\\' << *c;
+            } else if (static_cast<unsigned char>(*c) < 0x20) {
+                out << ' ';
+            } else {
+                out << *c;
+            }
+        }
+        out << '"';
+    }
+}
+
+bool Tracer::start(const std::string& outputPath)
+{
+    std::lock_guard<std::mutex> lock(registryMutex);
+    tracePath = outputPath;
+    traceStart = std::chrono::steady_clock::now();
+    tracing.store(true, std::memory_order_release);
+    std::cout << "Tracing to " << outputPath << " (written at exit)" << std::endl;
+    return true;
+}
+
+bool Tracer::startFromCommandLine(int argc, char** argv)
+{
+    std::string outputPath;
+    for (int i = 1; i + 1 < argc; i++) {
+        if (std::strcmp(argv[i], "--trace") == 0) {
+            outputPath = argv[i + 1];
+        }
+    }
+    if (outputPath.empty()) {
+        const char* environmentPath = std::getenv("FT_SIM_TRACE");
+        if (environmentPath && *environmentPath) {
+            outputPath = environmentPath;
+        }
+    }
+    if (outputPath.empty()) {
+        return false;
+    }
+    
+    // Runs before the buffer registry is destroyed (it was constructed before main)
+    std::atexit([]() { stop(); });
+    return start(outputPath);
+}
+
+bool Tracer::isEnabled()
+{
+    return tracing.load(std::memory_order_relaxed);
+}
+
+void Tracer::setThreadName(const char* name)
+{
+    if (!isEnabled()) {
+        return;
+    }
+    
+    ThreadBuffer* buffer = getThreadBuffer();
+    std::lock_guard<std::mutex> lock(registryMutex);
+    buffer->threadName = name;
+}
+
+double Tracer::now()
+{
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - traceStart).count();
+}
+
+void Tracer::record(const char* category, const char* name, const char* argName, int64_t arg,
+                    double startMicroseconds, double endMicroseconds)
+{
+    ThreadBuffer* buffer = getThreadBuffer();
+    size_t index = buffer->count.load(std::memory_order_relaxed);
+    if (index >= MAX_EVENTS_PER_THREAD) {
+        buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    
+    // The chunk is allocated before the count that publishes its first event
+    std::unique_ptr<TraceEvent[]>& chunk = buffer->chunks[index / EVENTS_PER_CHUNK];
+    if (!chunk) {
+        chunk.reset(new TraceEvent[EVENTS_PER_CHUNK]);
+    }
+    TraceEvent& event = chunk[index % EVENTS_PER_CHUNK];
+    event.category = category;
+    event.argName = argName;
+    event.arg = arg;
+    event.start = startMicroseconds;
+    event.duration = endMicroseconds - startMicroseconds;
+    std::strncpy(event.name, name, MAX_NAME_LENGTH);
+    event.name[MAX_NAME_LENGTH] = '\0';
+    
+    // Publish the event to the dump
+    buffer->count.store(index + 1, std::memory_order_release);
+}
+
+bool Tracer::stop()
+{
+    if (!tracing.exchange(false)) {
+        return false;
+    }
+    
+    std::ofstream file(tracePath);
+    if (!file.is_open()) {
+        std::cerr << "Cannot create trace file: " << tracePath << std::endl;
+        return false;
+    }
+    
+    std::lock_guard<std::mutex> lock(registryMutex);
+    size_t eventCount = 0;
+    size_t droppedCount = 0;
+    bool first = true;
+    auto separator = [&]() -> std::ostream& {
+        file << (first ? "\n" : ",\n");
+        first = false;
+        return file;
+    };
+    
+    file << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+    separator() << "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 1, \"args\": {\"name\": \"FT_Sim\"}}";
+    
+    char timing[96];
+    for (const std::unique_ptr<ThreadBuffer>& buffer : threadBuffers) {
+        if (!buffer->threadName.empty()) {
+            separator() << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << buffer->threadId
+                        << ", \"args\": {\"name\": ";
+            writeJsonString(file, buffer->threadName.c_str());
+            file << "}}";
+        }
+        
+        size_t count = buffer->count.load(std::memory_order_acquire);
+        for (size_t i = 0; i < count; i++) {
+            const TraceEvent& event = buffer->chunks[i / EVENTS_PER_CHUNK][i % EVENTS_PER_CHUNK];
+            separator() << "{\"name\": ";
+            writeJsonString(file, event.name);
+            std::snprintf(timing, sizeof(timing), ", \"ts\": %.3f, \"dur\": %.3f", event.start, event.duration);
+            file << ", \"cat\": \"" << event.category << "\", \"ph\": \"X\"" << timing
+                 << ", \"pid\": 1, \"tid\": " << buffer->threadId;
+            if (event.argName) {
+                file << ", \"args\": {\"" << event.argName << "\": " << event.arg << "}";
+            }
+            file << "}";
+        }
+        eventCount += count;
+        droppedCount += buffer->dropped.load(std::memory_order_relaxed);
+    }
+    file << "\n]}\n";
+    
+    file.close();
+    if (!file) {
+        std::cerr << "Failed to write trace file: " << tracePath << std::endl;
+        return false;
+    }
+    
+    std::cout << "Trace written to " << tracePath << ": " << eventCount << " events from "
+              << threadBuffers.size() << " threads";
+    if (droppedCount > 0) {
+        std::cout << " (" << droppedCount << " dropped; a thread exceeded " << MAX_EVENTS_PER_THREAD << " events)";
+    }
+    std::cout << std::endl;
+    return true;
+}
+
+TraceScope::TraceScope(const char* category, const char* scopeName, const char* argName, int64_t arg)
+    : active(Tracer::isEnabled()), category(category), argName(argName), arg(arg), start(0.0)
+{
+    if (active) {
+        std::strncpy(name, scopeName, Tracer::MAX_NAME_LENGTH);
+        name[Tracer::MAX_NAME_LENGTH] = '\0';
+        start = Tracer::now();
+    }
+}
+
+TraceScope::TraceScope(const char* category, const std::string& scopeName, const char* argName, int64_t arg)
+    : TraceScope(category, scopeName.c_str(), argName, arg)
+{
+}
+
+TraceScope::~TraceScope()
+{
+    if (active) {
+        Tracer::record(category, name, argName, arg, start, Tracer::now());
+    }
+}
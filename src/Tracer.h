@@ -0,0 +1,66 @@
+#ifndef TRACER_H
+#define TRACER_H
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+// Opt-in timeline tracer (--trace <file> or FT_SIM_TRACE=<file>). Scopes are recorded as
+// complete events into chunks owned by the recording thread: appending is a plain store
+// plus a release of the event count, with no locks and an allocation only for every
+// EVENTS_PER_CHUNK-th event. stop() writes every thread's events as Chrome trace-event JSON, which
+// chrome://tracing and ui.perfetto.dev open. While tracing is off a scope costs one
+// relaxed atomic load.
+class Tracer
+{
+public:
+    static bool start(const std::string& outputPath);
+    static bool isEnabled();
+
+    // Start if "--trace <file>" is given or FT_SIM_TRACE is set; the trace is written at exit
+    static bool startFromCommandLine(int argc, char** argv);
+
+    // Write the trace and stop recording; threads must no longer be recording
+    static bool stop();
+
+    // Label the calling thread in the timeline
+    static void setThreadName(const char* name);
+
+    // Microseconds since start()
+    static double now();
+
+    // Record a finished scope; name is copied (truncated to MAX_NAME_LENGTH)
+    static void record(const char* category, const char* name, const char* argName, int64_t arg,
+                       double startMicroseconds, double endMicroseconds);
+
+    static constexpr size_t MAX_NAME_LENGTH = 39;
+    static constexpr size_t EVENTS_PER_CHUNK = size_t(1) << 12;
+    static constexpr size_t MAX_EVENTS_PER_THREAD = size_t(1) << 17;
+};
+
+// Records the enclosing scope when tracing is on. Category and argName must be string
+// literals (they are stored by pointer); name is copied, so temporaries are fine.
+class TraceScope
+{
+public:
+    TraceScope(const char* category, const char* name, const char* argName = nullptr, int64_t arg = 0);
+    TraceScope(const char* category, const std::string& name, const char* argName = nullptr, int64_t arg = 0);
+    ~TraceScope();
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    bool active;
+    const char* category;
+    const char* argName;
+    int64_t arg;
+    double start;
+    char name[Tracer::MAX_NAME_LENGTH + 1];
+};
+
+#define FT_TRACE_CONCAT_INNER(a, b) a##b
+#define FT_TRACE_CONCAT(a, b) FT_TRACE_CONCAT_INNER(a, b)
+#define FT_TRACE_SCOPE(...) TraceScope FT_TRACE_CONCAT(traceScope, __LINE__)(__VA_ARGS__)
+
+#endif
@@ -3,7 +3,20 @@
 #include <cmath>
 
 TransformManager::TransformManager()
+    : evaluatedEnableFlags(0), versionCounter(0)
 {
+    for (size_t i = 0; i < SUB_GROUP_COUNT; i++) {
+        subGroupHasCalculated[i] = false;
+        subGroupCalculated[i] = createIdentityTransform();
+    }
+    
+    // Build the fixed part of the hierarchy: Positiv/Negativ roots, then one node per sub-group
+    nodes.resize(GROUP_NODE_COUNT);
+    for (size_t i = 0; i < SUB_GROUP_COUNT; i++) {
+        SubGroupType subGroup = static_cast<SubGroupType>(i);
+        attachNode(subGroupNodeIndex(subGroup), parentNodeIndex(getSubGroupParent(subGroup)));
+    }
+    
     initializeDefaultTransforms();
     initializeSampleTransforms();
 }
@@ -88,90 +101,251 @@ ParentGroupType TransformManager::getSubGroupParent(SubGroupType subGroup) const
     }
 }
 
+void TransformManager::registerModel(ModelId id, const std::string& modelName)
+{
+    if (id == INVALID_MODEL_ID) {
+        return;
+    }
+    
+    if (id >= modelSubGroups.size()) {
+        modelSubGroups.resize(id + 1, SubGroupType::Individual);
+        modelWorldPositions.resize(id + 1, glm::vec3(0.0f));
+        nodes.resize(modelNodeIndex(id) + 1);
+    }
+    
+    modelSubGroups[id] = getModelSubGroup(modelName);
+    modelWorldPositions[id] = getModelWorldPosition(modelName);
+    
+    // Attach the model leaf under its sub-group node
+    attachNode(modelNodeIndex(id), subGroupNodeIndex(modelSubGroups[id]));
+    setNodeLocal(modelNodeIndex(id), glm::translate(glm::mat4(1.0f), modelWorldPositions[id]));
+    markSubtreeDirty(modelNodeIndex(id));
+}
+
+SubGroupType TransformManager::getModelSubGroup(ModelId id) const
+{
+    return id < modelSubGroups.size() ? modelSubGroups[id] : SubGroupType::Individual;
+}
+
+glm::vec3 TransformManager::getModelWorldPosition(ModelId id) const
+{
+    return id < modelWorldPositions.size() ? modelWorldPositions[id] : glm::vec3(0.0f);
+}
+
 glm::mat4 TransformManager::getCombinedTransform(const std::string& modelName) const
 {
-    // Get sub group for this model
+    // Uncached path for callers that only have a name
     SubGroupType subGroup = getModelSubGroup(modelName);
+    return getParentGroupLocal(getSubGroupParent(subGroup)) * 
+           getSubGroupLocal(subGroup) * 
+           glm::translate(glm::mat4(1.0f), getModelWorldPosition(modelName));
+}
+
+const glm::mat4& TransformManager::getCombinedTransform(ModelId id)
+{
+    static const glm::mat4 identity(1.0f);
+    if (id >= modelSubGroups.size()) {
+        return identity;
+    }
     
-    // Get parent group for this sub group
-    ParentGroupType parentGroup = getSubGroupParent(subGroup);
-    
-    // Step 1: Get the model's final world position
-    glm::vec3 modelWorldPos = getModelWorldPosition(modelName);
-    
-    // Step 2: Check if we have a calculated UVW→IJK transform for this group
-    std::string groupName = getGroupNameFromModel(modelName);
-    
-    if (enableCalculatedTransforms && hasCalculatedTransform(groupName)) {
-        // NEW: Apply calculated UVW→IJK transformation directly
-        glm::mat4 calculatedTransform = getCalculatedTransform(groupName);
-        
-        // Apply the calculated transform to the model's world position
-        glm::mat4 finalTransform = calculatedTransform * glm::translate(glm::mat4(1.0f), modelWorldPos);
-        
-        // Step 3: Apply Positiv group transform if enabled (around world center)
-        if (enablePositiv && parentGroup == ParentGroupType::Positiv) {
-            finalTransform = positivTranslation * positivRotation * finalTransform;
-        }
-        
-        return finalTransform;
-    }
-    else {
-        // FALLBACK: Use original manual transformation system
-        glm::mat4 finalTransform = glm::translate(glm::mat4(1.0f), modelWorldPos);
-        
-        // Apply sub-group transformations around the group center
-        if (enableTag && subGroup == SubGroupType::TAG) {
-            // All TAG objects rotate around TAG center (0, 24.85, 0)
-            glm::vec3 tagCenter = glm::vec3(0.0f, 24.85f, 0.0f);
-            finalTransform = glm::translate(glm::mat4(1.0f), tagCenter) * 
-                            tagRotation * tagTranslation * 
-                            glm::translate(glm::mat4(1.0f), -tagCenter) * 
-                            glm::translate(glm::mat4(1.0f), modelWorldPos);
-        }
-        else if (enableTbg && subGroup == SubGroupType::TBG) {
-            // All TBG objects rotate around TBG center
-            float radius = 24.85f;
-            float angle = -30.0f * 3.14159f / 180.0f;
-            glm::vec3 tbgCenter = glm::vec3(radius * cos(angle), radius * sin(angle), 0.0f);
-            finalTransform = glm::translate(glm::mat4(1.0f), tbgCenter) * 
-                            tbgRotation * tbgTranslation * 
-                            glm::translate(glm::mat4(1.0f), -tbgCenter) * 
-                            glm::translate(glm::mat4(1.0f), modelWorldPos);
+    syncEnableFlags();
+    return evaluateNode(modelNodeIndex(id));
+}
+
+uint64_t TransformManager::getTransformVersion()
+{
+    syncEnableFlags();
+    return versionCounter;
+}
+
+uint64_t TransformManager::getModelTransformVersion(ModelId id)
+{
+    if (id >= modelSubGroups.size()) {
+        return 0;
+    }
+    
+    syncEnableFlags();
+    return nodes[modelNodeIndex(id)].version;
+}
+
+glm::mat4 TransformManager::getParentGroupLocal(ParentGroupType parentGroup) const
+{
+    // Positiv group transform is applied around the world center
+    if (enablePositiv && parentGroup == ParentGroupType::Positiv) {
+        return positivTranslation * positivRotation;
+    }
+    return glm::mat4(1.0f);
+}
+
+glm::mat4 TransformManager::getSubGroupLocal(SubGroupType subGroup) const
+{
+    size_t groupIndex = static_cast<size_t>(subGroup);
+    
+    // NEW: Calculated UVW→IJK transformation takes precedence
+    if (enableCalculatedTransforms && subGroupHasCalculated[groupIndex]) {
+        return subGroupCalculated[groupIndex];
+    }
+    
+    // FALLBACK: Original manual transformation system, rotating around the group center
+    float radius = 24.85f;
+    if (enableTag && subGroup == SubGroupType::TAG) {
+        // All TAG objects rotate around TAG center (0, 24.85, 0)
+        glm::vec3 tagCenter = glm::vec3(0.0f, radius, 0.0f);
+        return glm::translate(glm::mat4(1.0f), tagCenter) * 
+               tagRotation * tagTranslation * 
+               glm::translate(glm::mat4(1.0f), -tagCenter);
+    }
+    else if (enableTbg && subGroup == SubGroupType::TBG) {
+        // All TBG objects rotate around TBG center
+        float angle = -30.0f * 3.14159f / 180.0f;
+        glm::vec3 tbgCenter = glm::vec3(radius * cos(angle), radius * sin(angle), 0.0f);
+        return glm::translate(glm::mat4(1.0f), tbgCenter) * 
+               tbgRotation * tbgTranslation * 
+               glm::translate(glm::mat4(1.0f), -tbgCenter);
+    }
+    else if (enableTcg && subGroup == SubGroupType::TCG) {
+        // All TCG objects rotate around TCG center
+        float angle = -150.0f * 3.14159f / 180.0f;
+        glm::vec3 tcgCenter = glm::vec3(radius * cos(angle), radius * sin(angle), 0.0f);
+        return glm::translate(glm::mat4(1.0f), tcgCenter) * 
+               tcgRotation * tcgTranslation * 
+               glm::translate(glm::mat4(1.0f), -tcgCenter);
+    }
+    
+    return glm::mat4(1.0f);
+}
+
+void TransformManager::updateGroupNodes()
+{
+    for (size_t i = 0; i < PARENT_GROUP_COUNT; i++) {
+        ParentGroupType parentGroup = static_cast<ParentGroupType>(i);
+        setNodeLocal(parentNodeIndex(parentGroup), getParentGroupLocal(parentGroup));
+    }
+    
+    for (size_t i = 0; i < SUB_GROUP_COUNT; i++) {
+        SubGroupType subGroup = static_cast<SubGroupType>(i);
+        setNodeLocal(subGroupNodeIndex(subGroup), getSubGroupLocal(subGroup));
+    }
+    
+    evaluatedEnableFlags = packEnableFlags();
+}
+
+void TransformManager::syncEnableFlags()
+{
+    // The enable flags are public fields; pick up direct edits lazily
+    if (packEnableFlags() != evaluatedEnableFlags) {
+        updateGroupNodes();
+    }
+}
+
+unsigned int TransformManager::packEnableFlags() const
+{
+    return (enablePositiv ? 1u : 0u) | (enableTag ? 2u : 0u) | (enableTbg ? 4u : 0u) |
+           (enableTcg ? 8u : 0u) | (enableCalculatedTransforms ? 16u : 0u);
+}
+
+void TransformManager::setNodeLocal(size_t nodeIndex, const glm::mat4& local)
+{
+    TransformNode& node = nodes[nodeIndex];
+    if (node.local == local) {
+        return; // Unchanged: consumers keep their cached results
+    }
+    
+    node.local = local;
+    markSubtreeDirty(nodeIndex);
+}
+
+void TransformManager::attachNode(size_t nodeIndex, int parent)
+{
+    TransformNode& node = nodes[nodeIndex];
+    if (node.parent == parent) {
+        return;
+    }
+    
+    // Unlink from the previous parent's child list
+    if (node.parent >= 0) {
+        int* link = &nodes[node.parent].firstChild;
+        while (*link >= 0 && static_cast<size_t>(*link) != nodeIndex) {
+            link = &nodes[*link].nextSibling;
         }
-        else if (enableTcg && subGroup == SubGroupType::TCG) {
-            // All TCG objects rotate around TCG center
-            float radius = 24.85f;
-            float angle = -150.0f * 3.14159f / 180.0f;
-            glm::vec3 tcgCenter = glm::vec3(radius * cos(angle), radius * sin(angle), 0.0f);
-            finalTransform = glm::translate(glm::mat4(1.0f), tcgCenter) * 
-                            tcgRotation * tcgTranslation * 
-                            glm::translate(glm::mat4(1.0f), -tcgCenter) * 
-                            glm::translate(glm::mat4(1.0f), modelWorldPos);
+        if (*link >= 0) {
+            *link = node.nextSibling;
         }
-        
-        // Step 4: Apply Positiv group transform if enabled (around world center)
-        if (enablePositiv && parentGroup == ParentGroupType::Positiv) {
-            finalTransform = positivTranslation * positivRotation * finalTransform;
+    }
+    
+    node.parent = parent;
+    node.nextSibling = nodes[parent].firstChild;
+    nodes[parent].firstChild = static_cast<int>(nodeIndex);
+}
+
+void TransformManager::markSubtreeDirty(size_t nodeIndex)
+{
+    // Versions are bumped eagerly; world matrices are recomputed on demand
+    versionCounter++;
+    markNodeDirty(nodeIndex);
+}
+
+void TransformManager::markNodeDirty(size_t nodeIndex)
+{
+    TransformNode& node = nodes[nodeIndex];
+    node.dirty = true;
+    node.version = versionCounter;
+    
+    // A dirty node's whole subtree is already dirty (evaluation cleans a node together with its
+    // ancestors), so descent stops there. Its version is still newer than any a consumer stored,
+    // since consumers store a version only after evaluating the node.
+    for (int child = node.firstChild; child >= 0; child = nodes[child].nextSibling) {
+        if (!nodes[child].dirty) {
+            markNodeDirty(child);
         }
-        
-        return finalTransform;
     }
 }
 
+const glm::mat4& TransformManager::evaluateNode(size_t nodeIndex)
+{
+    TransformNode& node = nodes[nodeIndex];
+    if (node.dirty) {
+        node.world = node.parent >= 0 ? evaluateNode(node.parent) * node.local : node.local;
+        node.dirty = false;
+    }
+    return node.world;
+}
+
 // NEW: Direct UVW→IJK transformation matrix methods
 void TransformManager::setCalculatedTransform(const std::string& groupName, const glm::mat4& transform)
 {
-    calculatedTransforms[groupName] = transform;
+    SubGroupType subGroup;
+    if (findSubGroupByName(groupName, subGroup)) {
+        setCalculatedTransform(subGroup, transform);
+    } else {
+        calculatedTransforms[groupName] = transform;
+    }
+}
+
+void TransformManager::setCalculatedTransform(SubGroupType group, const glm::mat4& transform)
+{
+    size_t groupIndex = static_cast<size_t>(group);
+    subGroupHasCalculated[groupIndex] = true;
+    subGroupCalculated[groupIndex] = transform;
+    setNodeLocal(subGroupNodeIndex(group), getSubGroupLocal(group));
 }
 
 bool TransformManager::hasCalculatedTransform(const std::string& groupName) const
 {
+    SubGroupType subGroup;
+    if (findSubGroupByName(groupName, subGroup)) {
+        return subGroupHasCalculated[static_cast<size_t>(subGroup)];
+    }
     return calculatedTransforms.find(groupName) != calculatedTransforms.end();
 }
 
 glm::mat4 TransformManager::getCalculatedTransform(const std::string& groupName) const
 {
+    SubGroupType subGroup;
+    if (findSubGroupByName(groupName, subGroup) && subGroupHasCalculated[static_cast<size_t>(subGroup)]) {
+        return subGroupCalculated[static_cast<size_t>(subGroup)];
+    }
+    
     auto it = calculatedTransforms.find(groupName);
     if (it != calculatedTransforms.end()) {
         return it->second;
@@ -182,21 +356,26 @@ glm::mat4 TransformManager::getCalculatedTransform(const std::string& groupName)
 void TransformManager::clearCalculatedTransforms()
 {
     calculatedTransforms.clear();
+    for (size_t i = 0; i < SUB_GROUP_COUNT; i++) {
+        subGroupHasCalculated[i] = false;
+    }
+    updateGroupNodes();
     std::cout << "Cleared all calculated transforms" << std::endl;
 }
 
-std::string TransformManager::getGroupNameFromModel(const std::string& modelName) const
+bool TransformManager::findSubGroupByName(const std::string& groupName, SubGroupType& subGroup) const
 {
-    SubGroupType subGroup = getModelSubGroup(modelName);
-    
-    switch (subGroup) {
-        case SubGroupType::TAG: return "TAG";
-        case SubGroupType::TBG: return "TBG";
-        case SubGroupType::TCG: return "TCG";
-        case SubGroupType::Negativ: return "Negativ";
-        case SubGroupType::Individual: return "Individual";
-        default: return "Unknown";
+    static const SubGroupType allGroups[SUB_GROUP_COUNT] = {
+        SubGroupType::TAG, SubGroupType::TBG, SubGroupType::TCG, SubGroupType::Negativ, SubGroupType::Individual
+    };
+    
+    for (SubGroupType group : allGroups) {
+        if (getSubGroupName(group) == groupName) {
+            subGroup = group;
+            return true;
+        }
     }
+    return false;
 }
 
 // LEGACY: Keep original method for backwards compatibility
@@ -207,6 +386,14 @@ void TransformManager::applyCalculatedTransform(const std::string& groupName, co
     
     // Enable calculated transforms
     enableCalculatedTransforms = true;
+    updateGroupNodes();
+}
+
+void TransformManager::applyCalculatedTransform(SubGroupType group, const glm::mat4& transform)
+{
+    setCalculatedTransform(group, transform);
+    enableCalculatedTransforms = true;
+    updateGroupNodes();
 }
 
 glm::vec3 TransformManager::getModelWorldPosition(const std::string& modelName) const
@@ -468,6 +655,9 @@ void TransformManager::buildTransformationMatrices()
                   glm::rotate(glm::mat4(1.0f), tcgRotationZ, glm::vec3(0.0f, 0.0f, 1.0f));
     
     tcgTranslation = glm::translate(glm::mat4(1.0f), glm::vec3(tcgTranslationX, tcgTranslationY, tcgTranslationZ));
+    
+    // Propagate into the hierarchy (only changed nodes bump their version)
+    updateGroupNodes();
 }
 
 void TransformManager::printGroupTransforms() const
@@ -475,7 +665,16 @@ void TransformManager::printGroupTransforms() const
     std::cout << "\n=== Transformation Values ===" << std::endl;
     
     std::cout << "\nCalculated Transforms [" << (enableCalculatedTransforms ? "ENABLED" : "DISABLED") << "]:" << std::endl;
-    std::cout << "  Active transforms: " << calculatedTransforms.size() << std::endl;
+    size_t activeGroups = 0;
+    for (size_t i = 0; i < SUB_GROUP_COUNT; i++) {
+        activeGroups += subGroupHasCalculated[i] ? 1 : 0;
+    }
+    std::cout << "  Active transforms: " << activeGroups + calculatedTransforms.size() << std::endl;
+    for (size_t i = 0; i < SUB_GROUP_COUNT; i++) {
+        if (subGroupHasCalculated[i]) {
+            std::cout << "    " << getSubGroupName(static_cast<SubGroupType>(i)) << ": matrix set" << std::endl;
+        }
+    }
     for (const auto& pair : calculatedTransforms) {
         std::cout << "    " << pair.first << ": matrix set" << std::endl;
     }
@@ -3,8 +3,11 @@
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
+#include <cstdint>
 #include <map>
 #include <string>
+#include <vector>
+#include "ModelRegistry.h"
 
 // Parent group types
 enum class ParentGroupType { 
@@ -21,6 +24,18 @@ enum class SubGroupType {
     Individual  // No group transformation
 };
 
+// Node of the transform hierarchy (Positiv -> TAG/TBG/TCG -> models, Negativ -> negatives).
+// Each node caches its world matrix and records the version at which it last changed.
+struct TransformNode {
+    int parent = -1;
+    int firstChild = -1;
+    int nextSibling = -1;
+    glm::mat4 local = glm::mat4(1.0f);
+    glm::mat4 world = glm::mat4(1.0f);
+    uint64_t version = 0;
+    bool dirty = true;
+};
+
 // Transform manager class with proper transformation order
 class TransformManager
 {
@@ -40,11 +55,25 @@ public:
     SubGroupType getModelSubGroup(const std::string& modelName) const;
     ParentGroupType getSubGroupParent(SubGroupType subGroup) const;
     
+    // Register a model ID, resolving its sub-group and world position from its name once
+    void registerModel(ModelId id, const std::string& modelName);
+    SubGroupType getModelSubGroup(ModelId id) const;
+    
     // Get combined transformation for a model (handles different transformation orders)
     glm::mat4 getCombinedTransform(const std::string& modelName) const;
     
+    // Cached world matrix, recomputed when dirty. Not const: evaluating updates the cache, so a
+    // manager shared between threads needs external locking (the workers use their own copies).
+    const glm::mat4& getCombinedTransform(ModelId id);
+    
+    // Change tracking: compare against a previously seen value to skip unchanged work. These pick
+    // up direct edits of the public enable flags first, so they are not const either.
+    uint64_t getTransformVersion();                 // Bumped by any transform change
+    uint64_t getModelTransformVersion(ModelId id);  // Bumped when this model's world matrix changes
+    
     // Get model's original world position
     glm::vec3 getModelWorldPosition(const std::string& modelName) const;
+    glm::vec3 getModelWorldPosition(ModelId id) const;
     
     // Name utilities
     std::string getParentGroupName(ParentGroupType group) const;
@@ -53,19 +82,21 @@ public:
     // Initialization
     void initializeDefaultTransforms();
     void initializeSampleTransforms();
-    void buildTransformationMatrices();
+    void buildTransformationMatrices(); // Call after editing the public values or matrices below
     
     // Debug info
     void printGroupTransforms() const;
 
     // NEW: Direct UVW→IJK transformation matrix application
     void setCalculatedTransform(const std::string& groupName, const glm::mat4& transform);
+    void setCalculatedTransform(SubGroupType group, const glm::mat4& transform);  // No name lookup
     bool hasCalculatedTransform(const std::string& groupName) const;
     glm::mat4 getCalculatedTransform(const std::string& groupName) const;
     void clearCalculatedTransforms();
     
     // LEGACY: Keep for backwards compatibility but mark as deprecated
     void applyCalculatedTransform(const std::string& groupName, const glm::mat4& transform);
+    void applyCalculatedTransform(SubGroupType group, const glm::mat4& transform);
     void setGroupTransformMatrix(SubGroupType group, const glm::mat4& transform);
     
     // Matrix decomposition helpers (kept for other uses)
@@ -134,9 +165,45 @@ private:
     std::map<ParentGroupType, glm::mat4> parentGroupTransforms;
     std::map<SubGroupType, glm::mat4> subGroupTransforms;
     
-    // NEW: Storage for calculated UVW→IJK transformation matrices
+    // NEW: Storage for calculated UVW→IJK transformation matrices of names that are not sub-groups
     std::map<std::string, glm::mat4> calculatedTransforms; // groupName -> transform matrix
     
+    // Calculated transforms of the sub-groups, stored without string keys
+    static constexpr size_t SUB_GROUP_COUNT = 5;
+    bool subGroupHasCalculated[SUB_GROUP_COUNT];
+    glm::mat4 subGroupCalculated[SUB_GROUP_COUNT];
+    
+    // Per-model data indexed by ModelId (filled by registerModel)
+    std::vector<SubGroupType> modelSubGroups;
+    std::vector<glm::vec3> modelWorldPositions;
+    
+    bool findSubGroupByName(const std::string& groupName, SubGroupType& subGroup) const;
+    
+    // Transform hierarchy: parent roots, then sub-groups, then one leaf per ModelId
+    static constexpr size_t PARENT_GROUP_COUNT = 2;
+    static constexpr size_t GROUP_NODE_COUNT = PARENT_GROUP_COUNT + SUB_GROUP_COUNT;
+    std::vector<TransformNode> nodes;
+    unsigned int evaluatedEnableFlags;  // Enable flags the group nodes were built from
+    uint64_t versionCounter;
+    
+    static int parentNodeIndex(ParentGroupType group) { return static_cast<int>(group); }
+    static int subGroupNodeIndex(SubGroupType group) { return static_cast<int>(PARENT_GROUP_COUNT) + static_cast<int>(group); }
+    static size_t modelNodeIndex(ModelId id) { return GROUP_NODE_COUNT + id; }
+    
+    // Local matrices of the group nodes, derived from the current settings
+    glm::mat4 getParentGroupLocal(ParentGroupType parentGroup) const;
+    glm::mat4 getSubGroupLocal(SubGroupType subGroup) const;
+    
+    // Hierarchy maintenance
+    void updateGroupNodes();
+    void syncEnableFlags();
+    unsigned int packEnableFlags() const;
+    void attachNode(size_t nodeIndex, int parent);
+    void setNodeLocal(size_t nodeIndex, const glm::mat4& local);
+    void markSubtreeDirty(size_t nodeIndex);
+    void markNodeDirty(size_t nodeIndex);
+    const glm::mat4& evaluateNode(size_t nodeIndex);
+    
     // Helper methods
     glm::mat4 createIdentityTransform() const;
     glm::mat4 createInversePositionMatrix(const glm::vec3& position) const;
@@ -145,9 +212,6 @@ private:
     glm::vec3 extractTranslation(const glm::mat4& matrix);
     glm::vec3 extractRotation(const glm::mat4& matrix);
     glm::vec3 extractScale(const glm::mat4& matrix);
-    
-    // Helper method to get group name from model name
-    std::string getGroupNameFromModel(const std::string& modelName) const;
 };
 
 #endif
\ No newline at end of file